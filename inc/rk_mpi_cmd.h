@@ -75,6 +75,12 @@ typedef enum {
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
     MPP_SET_DISABLE_THREAD,             /* MPP no thread mode and use external thread to decode */
+    /*
+     * encoder frames in flight, need to setup before init
+     * parameter type RK_S32, zero for platform default
+     * frame N + 1 is prepared while frame N is running on hardware
+     */
+    MPP_SET_ENC_TASK_COUNT,
 
     MPP_STATE_CMD_BASE                  = CMD_MODULE_MPP | CMD_STATE_OPS,
     MPP_START,
@@ -110,6 +116,7 @@ typedef enum {
     MPP_DEC_CMD_QUERY                   = CMD_MODULE_CODEC | CMD_CTX_ID_DEC | CMD_DEC_QUERY,
     /* query decoder runtime information for decode stage */
     MPP_DEC_QUERY,                      /* set and get MppDecQueryCfg structure */
+    MPP_DEC_GET_LATENCY,                /* get MppDecLatencyStat structure */
 
     CMD_DEC_CMD_CFG                     = CMD_MODULE_CODEC | CMD_CTX_ID_DEC | CMD_DEC_CFG,
     MPP_DEC_SET_CFG,                    /* set MppDecCfg structure */
@@ -22,6 +22,25 @@
 
 typedef void* MppDecCfg;
 
+/*
+ * Key of one config item resolved from the name string by
+ * mpp_dec_cfg_get_key. The key is valid for any MppDecCfg in the process
+ * and the *_by_key functions skip the name lookup on each access.
+ */
+typedef void* MppDecCfgKey;
+
+typedef struct MppDecCfgKeyVal_t {
+    MppDecCfgKey      key;
+    /* value of the key type, struct data pointer for struct type */
+    union {
+        RK_S32          s32;
+        RK_U32          u32;
+        RK_S64          s64;
+        RK_U64          u64;
+        void            *ptr;
+    } val;
+} MppDecCfgKeyVal;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,6 +60,23 @@ MPP_RET mpp_dec_cfg_get_s64(MppDecCfg cfg, const char *name, RK_S64 *val);
 MPP_RET mpp_dec_cfg_get_u64(MppDecCfg cfg, const char *name, RK_U64 *val);
 MPP_RET mpp_dec_cfg_get_ptr(MppDecCfg cfg, const char *name, void **val);
 
+MPP_RET mpp_dec_cfg_get_key(const char *name, MppDecCfgKey *key);
+
+MPP_RET mpp_dec_cfg_set_s32_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_S32 val);
+MPP_RET mpp_dec_cfg_set_u32_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_U32 val);
+MPP_RET mpp_dec_cfg_set_s64_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_S64 val);
+MPP_RET mpp_dec_cfg_set_u64_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_U64 val);
+MPP_RET mpp_dec_cfg_set_ptr_by_key(MppDecCfg cfg, MppDecCfgKey key, void *val);
+
+MPP_RET mpp_dec_cfg_get_s32_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_S32 *val);
+MPP_RET mpp_dec_cfg_get_u32_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_U32 *val);
+MPP_RET mpp_dec_cfg_get_s64_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_S64 *val);
+MPP_RET mpp_dec_cfg_get_u64_by_key(MppDecCfg cfg, MppDecCfgKey key, RK_U64 *val);
+MPP_RET mpp_dec_cfg_get_ptr_by_key(MppDecCfg cfg, MppDecCfgKey key, void **val);
+
+/* set count key value pairs in one call, stop on the first failure */
+MPP_RET mpp_dec_cfg_set_batch(MppDecCfg cfg, MppDecCfgKeyVal *kv, RK_S32 count);
+
 void mpp_dec_cfg_show(void);
 
 #ifdef __cplusplus
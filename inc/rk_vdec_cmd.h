@@ -63,6 +63,36 @@ typedef struct MppDecQueryCfg_t {
     RK_U32      dec_out_frm_cnt;
 } MppDecQueryCfg;
 
+/*
+ * decoder pipeline latency statistic for MPP_DEC_GET_LATENCY
+ *
+ * Each stage records the time of every decoded frame into a histogram.
+ * Packet in time is the time when decoder takes the packet from input queue.
+ * When one frame is split into several packets the last packet is used.
+ */
+typedef enum MppDecLatencyStage_e {
+    MPP_DEC_LAT_PKT_TO_PARSE,       /* packet in to parse done */
+    MPP_DEC_LAT_PARSE_TO_HW,        /* parse done to hardware start */
+    MPP_DEC_LAT_HW_WAIT,            /* hardware start to hardware done */
+    MPP_DEC_LAT_FRM_OUT,            /* hardware done to frame output */
+    MPP_DEC_LAT_BUTT,
+} MppDecLatencyStage;
+
+typedef struct MppDecLatency_t {
+    /* all time are in us */
+    RK_U32      count;
+    RK_U32      avg;
+    RK_U32      p50;
+    RK_U32      p99;
+    RK_U32      max;
+} MppDecLatency;
+
+typedef struct MppDecLatencyStat_t {
+    /* set by user to clear the statistic after query */
+    RK_U32          reset;
+    MppDecLatency   stage[MPP_DEC_LAT_BUTT];
+} MppDecLatencyStat;
+
 typedef void* MppExtCbCtx;
 typedef MPP_RET (*MppExtCbFunc)(MppExtCbCtx cb_ctx, MppCtx mpp, RK_S32 cmd, void *arg);
 
@@ -22,6 +22,25 @@
 
 typedef void* MppEncCfg;
 
+/*
+ * Key of one config item resolved from the name string by
+ * mpp_enc_cfg_get_key. The key is valid for any MppEncCfg in the process
+ * and the *_by_key functions skip the name lookup on each access.
+ */
+typedef void* MppEncCfgKey;
+
+typedef struct MppEncCfgKeyVal_t {
+    MppEncCfgKey      key;
+    /* value of the key type, struct data pointer for struct type */
+    union {
+        RK_S32          s32;
+        RK_U32          u32;
+        RK_S64          s64;
+        RK_U64          u64;
+        void            *ptr;
+    } val;
+} MppEncCfgKeyVal;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -43,6 +62,25 @@ MPP_RET mpp_enc_cfg_get_u64(MppEncCfg cfg, const char *name, RK_U64 *val);
 MPP_RET mpp_enc_cfg_get_ptr(MppEncCfg cfg, const char *name, void **val);
 MPP_RET mpp_enc_cfg_get_st(MppEncCfg cfg, const char *name, void *val);
 
+MPP_RET mpp_enc_cfg_get_key(const char *name, MppEncCfgKey *key);
+
+MPP_RET mpp_enc_cfg_set_s32_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_S32 val);
+MPP_RET mpp_enc_cfg_set_u32_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_U32 val);
+MPP_RET mpp_enc_cfg_set_s64_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_S64 val);
+MPP_RET mpp_enc_cfg_set_u64_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_U64 val);
+MPP_RET mpp_enc_cfg_set_ptr_by_key(MppEncCfg cfg, MppEncCfgKey key, void *val);
+MPP_RET mpp_enc_cfg_set_st_by_key(MppEncCfg cfg, MppEncCfgKey key, void *val);
+
+MPP_RET mpp_enc_cfg_get_s32_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_S32 *val);
+MPP_RET mpp_enc_cfg_get_u32_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_U32 *val);
+MPP_RET mpp_enc_cfg_get_s64_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_S64 *val);
+MPP_RET mpp_enc_cfg_get_u64_by_key(MppEncCfg cfg, MppEncCfgKey key, RK_U64 *val);
+MPP_RET mpp_enc_cfg_get_ptr_by_key(MppEncCfg cfg, MppEncCfgKey key, void **val);
+MPP_RET mpp_enc_cfg_get_st_by_key(MppEncCfg cfg, MppEncCfgKey key, void *val);
+
+/* set count key value pairs in one call, stop on the first failure */
+MPP_RET mpp_enc_cfg_set_batch(MppEncCfg cfg, MppEncCfgKeyVal *kv, RK_S32 count);
+
 void mpp_enc_cfg_show(void);
 
 #ifdef __cplusplus
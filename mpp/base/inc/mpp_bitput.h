@@ -36,11 +36,47 @@ extern "C" {
 #endif
 
 RK_S32 mpp_set_bitput_ctx(BitputCtx_t *bp, RK_U64 *data, RK_U32 len);
-void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits);
 void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag);
+/* put len 8 bit values, whole words are copied when the writer is byte aligned */
+void mpp_put_bytes(BitputCtx_t *bp, const RK_U8 *data, RK_S32 len);
+/* put count values of lbits (1 ~ 8) each from a byte array */
+void mpp_put_array(BitputCtx_t *bp, const RK_U8 *data, RK_S32 count, RK_S32 lbits);
+
+/* one field per call reference version for comparison */
+void mpp_put_bits_c(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits);
+void mpp_put_align_c(BitputCtx_t *bp, RK_S32 align_bits, int flag);
 
 #ifdef  __cplusplus
 }
 #endif
 
+/*
+ * Put the low lbits (1 ~ 64) of invalue. The word under writing is stored on
+ * each call so the buffer is always ready to use without flush. Writing stops
+ * at buflen words.
+ */
+static inline void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits)
+{
+    RK_U32 bitpos = bp->bitpos;
+    RK_U32 end = bitpos + lbits;
+
+    if (!lbits || bp->index >= bp->buflen)
+        return;
+
+    invalue &= (~(RK_U64)0) >> (64 - lbits);
+    bp->bvalue |= invalue << bitpos;
+
+    if (end >= 64) {
+        bp->pbuf[bp->index++] = bp->bvalue;
+        /* high bits left for next word */
+        bp->bvalue = (end & 63) ? invalue >> (64 - bitpos) : 0;
+
+        if (bp->index >= bp->buflen)
+            return;
+    }
+
+    bp->pbuf[bp->index] = bp->bvalue;
+    bp->bitpos = end & 63;
+}
+
 #endif
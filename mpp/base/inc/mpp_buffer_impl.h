@@ -73,6 +73,12 @@ typedef struct MppBufLogs_t {
     MppBufLog           *logs;
 } MppBufLogs;
 
+/*
+ * unused buffers in group are kept in lists of size class
+ * size class is log2 of size in 4K unit and all size below 8K is class 0
+ */
+#define BUF_SIZE_CLASS_NUM      32
+
 typedef struct MppBufferImpl_t          MppBufferImpl;
 typedef struct MppBufferGroupImpl_t     MppBufferGroupImpl;
 typedef void (*MppBufCallback)(void *, void *);
@@ -158,7 +164,9 @@ struct MppBufferGroupImpl_t {
     pthread_mutex_t     buf_lock;
     struct hlist_node   hlist;
     struct list_head    list_used;
-    struct list_head    list_unused;
+    struct list_head    list_unused[BUF_SIZE_CLASS_NUM];
+    // bit of size class which may have unused buffer
+    RK_U32              unused_mask;
     RK_S32              count_used;
     RK_S32              count_unused;
 
@@ -185,8 +193,9 @@ extern RK_U32 mpp_buffer_debug;
  *                            for reducing virtual memory usage.
  *
  *  mpp_buffer_get_unused   : get unused buffer with size. it will first search
- *                            the unused list. if failed it will create on from
- *                            group allocator.
+ *                            the unused list of the same size class then the
+ *                            larger size class. if failed it will create on
+ *                            from group allocator.
  *
  *  mpp_buffer_ref_inc      : increase buffer's reference counter. if it is unused
  *                            then it will be moved to used list.
@@ -47,6 +47,8 @@ typedef struct MppMetaImpl_t {
 
     struct list_head    list_meta;
     RK_S32              node_count;
+    /* bit of key index which has been set once, for fast lookup miss */
+    RK_U64              key_mask;
     MppMetaVal          vals[];
 } MppMetaImpl;
 
@@ -76,6 +76,20 @@ typedef struct MppPacketImpl_t {
     MppPktSeg       *segments;
 } MppPacketImpl;
 
+/* statistic of the data pool used by mpp_packet_copy_init */
+typedef struct MppPacketPoolStat_t {
+    RK_U64          get_count;
+    /* get served by a cached block */
+    RK_U64          hit_count;
+    /* block freed on put due to cache limit or size */
+    RK_U64          drop_count;
+    size_t          used_bytes;
+    size_t          cached_bytes;
+    /* high-water mark of used and cached bytes */
+    size_t          peak_bytes;
+    size_t          limit_bytes;
+} MppPacketPoolStat;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -96,6 +110,8 @@ void    mpp_packet_set_segment_nb(MppPacket packet, RK_U32 segment_nb);
 MPP_RET mpp_packet_add_segment_info(MppPacket packet, RK_S32 type, RK_S32 offset, RK_S32 len);
 void    mpp_packet_copy_segment_info(MppPacket dst, MppPacket src);
 
+MPP_RET mpp_packet_pool_get_stat(MppPacketPoolStat *stat);
+
 /* pointer check function */
 MPP_RET check_is_mpp_packet(void *ptr);
 
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Find the first 00 00 01 start code in data[0, size).
+ *
+ * prefix holds the bytes seen before data with the latest byte in the lowest
+ * eight bits, so start codes split across two input chunks are detected as
+ * well. Pass 0xffffffff when there is no history.
+ *
+ * Return the index of the 0x01 byte which terminates the start code, or -1
+ * when no start code ends inside data.
+ */
+RK_S32 mpp_find_start_code(const RK_U8 *data, RK_S32 size, RK_U32 prefix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MPP_STARTCODE_H__ */
@@ -30,7 +30,7 @@ RK_S32 mpp_set_bitput_ctx(BitputCtx_t *bp, RK_U64 *data, RK_U32 len)
     return 0;
 }
 
-void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits)
+void mpp_put_bits_c(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits)
 {
     RK_U8 hbits = 0;
 
@@ -55,7 +55,7 @@ void mpp_put_bits(BitputCtx_t *bp, RK_U64 invalue, RK_S32 lbits)
     // mpp_log("bp->index = %d bp->bitpos = %d lbits = %d invalue 0x%x bp->hvalue 0x%x  bp->lvalue 0x%x",bp->index,bp->bitpos,lbits, (RK_U32)invalue,(RK_U32)(bp->bvalue >> 32),(RK_U32)bp->bvalue);
 }
 
-void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag)
+void mpp_put_align_c(BitputCtx_t *bp, RK_S32 align_bits, int flag)
 {
     RK_U32 word_offset = 0,  len = 0;
 
@@ -64,17 +64,108 @@ void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag)
     while (len > 0) {
         if (len >= 8) {
             if (flag == 0)
-                mpp_put_bits(bp, ((RK_U64)0 << (64 - 8)) >> (64 - 8), 8);
+                mpp_put_bits_c(bp, ((RK_U64)0 << (64 - 8)) >> (64 - 8), 8);
             else
-                mpp_put_bits(bp, (0xffffffffffffffff << (64 - 8)) >> (64 - 8), 8);
+                mpp_put_bits_c(bp, (0xffffffffffffffff << (64 - 8)) >> (64 - 8), 8);
             len -= 8;
         } else {
             if (flag == 0)
-                mpp_put_bits(bp, ((RK_U64)0 << (64 - len)) >> (64 - len), len);
+                mpp_put_bits_c(bp, ((RK_U64)0 << (64 - len)) >> (64 - len), len);
             else
-                mpp_put_bits(bp, (0xffffffffffffffff << (64 - len)) >> (64 - len), len);
+                mpp_put_bits_c(bp, (0xffffffffffffffff << (64 - len)) >> (64 - len), len);
             len -= len;
         }
     }
 }
 
+void mpp_put_align(BitputCtx_t *bp, RK_S32 align_bits, int flag)
+{
+    RK_U32 word_offset = 0,  len = 0;
+    RK_U64 pad = flag ? ~(RK_U64)0 : 0;
+
+    word_offset = (align_bits >= 64) ? ((bp->index & (((align_bits & 0xfe0) >> 6) - 1)) << 6) : 0;
+    len = (align_bits - (word_offset + (bp->bitpos % align_bits))) % align_bits;
+
+    /* pad up to the end of current word at most on each put */
+    while (len > 0) {
+        RK_U32 bits = MPP_MIN(len, 64 - (RK_U32)bp->bitpos);
+
+        if (bp->index >= bp->buflen)
+            break;
+
+        mpp_put_bits(bp, pad, bits);
+        len -= bits;
+    }
+}
+
+void mpp_put_bytes(BitputCtx_t *bp, const RK_U8 *data, RK_S32 len)
+{
+    RK_S32 i = 0;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    /* the LSB first word is the bytes in memory order on little endian */
+    if (!(bp->bitpos & 7)) {
+        RK_S32 words;
+
+        while (i < len && bp->bitpos)
+            mpp_put_bits(bp, data[i++], 8);
+
+        words = (len - i) >> 3;
+        /* leave the last word of buffer to mpp_put_bits for the end check */
+        if (bp->index + 1 >= bp->buflen)
+            words = 0;
+        else if (words > (RK_S32)(bp->buflen - bp->index - 1))
+            words = bp->buflen - bp->index - 1;
+
+        if (words > 0 && !bp->bitpos && !bp->bvalue) {
+            memcpy(bp->pbuf + bp->index, data + i, words * 8);
+            bp->index += words;
+            bp->pbuf[bp->index] = 0;
+            i += words * 8;
+        }
+    }
+#endif
+
+    for (; i < len; i++)
+        mpp_put_bits(bp, data[i], 8);
+}
+
+void mpp_put_array(BitputCtx_t *bp, const RK_U8 *data, RK_S32 count, RK_S32 lbits)
+{
+    RK_S32 i;
+
+    if (lbits == 8) {
+        mpp_put_bytes(bp, data, count);
+        return;
+    }
+
+    /* pack in local word and store on word end while far from buffer end */
+    if (lbits > 0 && lbits < 8 && count > 0 &&
+        bp->index + ((bp->bitpos + (RK_U64)count * lbits) >> 6) + 1 < bp->buflen) {
+        RK_U64 *p = bp->pbuf + bp->index;
+        RK_U64 val = bp->bvalue;
+        RK_U32 pos = bp->bitpos;
+        RK_U32 mask = (1 << lbits) - 1;
+
+        for (i = 0; i < count; i++) {
+            RK_U64 v = data[i] & mask;
+
+            val |= v << pos;
+            pos += lbits;
+            if (pos >= 64) {
+                *p++ = val;
+                pos -= 64;
+                val = pos ? v >> (lbits - pos) : 0;
+            }
+        }
+
+        *p = val;
+        bp->index = p - bp->pbuf;
+        bp->bvalue = val;
+        bp->bitpos = pos;
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+        mpp_put_bits(bp, data[i], lbits);
+}
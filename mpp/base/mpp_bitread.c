@@ -19,6 +19,7 @@
 #include <string.h>
 #include "rk_type.h"
 #include "mpp_mem.h"
+#include "mpp_common.h"
 #include "mpp_bitread.h"
 
 static MPP_RET update_curbyte_default(BitReadCtx_t *bitctx)
@@ -107,6 +108,35 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
     return MPP_OK;
 }
 
+/*
+ * Byte value larger than 0x03 can not be the emulation prevention byte of
+ * H.264 / H.265 nor the 0x02 pseudo start code byte of AVS2. Then all the
+ * update_curbyte functions do the same thing and the byte can be loaded
+ * inline without the function pointer call.
+ */
+static inline MPP_RET update_curbyte(BitReadCtx_t *bitctx)
+{
+    if (bitctx->bytes_left_ && *bitctx->data_ > 0x03) {
+        bitctx->curr_byte_ = *bitctx->data_++;
+        --bitctx->bytes_left_;
+        bitctx->num_remaining_bits_in_curr_byte_ = 8;
+        bitctx->prev_two_bytes_ = (bitctx->prev_two_bytes_ << 8) | bitctx->curr_byte_;
+        return MPP_OK;
+    }
+
+    return bitctx->update_curbyte(bitctx);
+}
+
+/* count leading zero bits of a non-zero value in 8 bits */
+static inline RK_S32 count_leading_zeros_8bit(RK_U32 val)
+{
+#if defined(__GNUC__)
+    return __builtin_clz(val) - 24;
+#else
+    return 7 - mpp_log2(val);
+#endif
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -118,20 +148,25 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
 MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
     RK_S32 bits_left = num_bits;
+    RK_U64 val = 0;
+
     *out = 0;
     if (num_bits > 31) {
         return  MPP_ERR_READ_BIT;
     }
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
-        *out |= (bitctx->curr_byte_ << (bits_left - bitctx->num_remaining_bits_in_curr_byte_));
-        bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (bitctx->update_curbyte(bitctx)) {
+        RK_S32 remain = bitctx->num_remaining_bits_in_curr_byte_;
+
+        val = (val << remain) | (bitctx->curr_byte_ & ((1 << remain) - 1));
+        bits_left -= remain;
+        if (update_curbyte(bitctx)) {
             return  MPP_ERR_READ_BIT;
         }
     }
-    *out |= (bitctx->curr_byte_ >> (bitctx->num_remaining_bits_in_curr_byte_ - bits_left));
-    *out &= ((1 << num_bits) - 1);
+    val = (val << bits_left) |
+          (bitctx->curr_byte_ >> (bitctx->num_remaining_bits_in_curr_byte_ - bits_left));
+    *out = (RK_S32)(val & ((1 << num_bits) - 1));
     bitctx->num_remaining_bits_in_curr_byte_ -= bits_left;
     bitctx->used_bits += num_bits;
 
@@ -174,7 +209,7 @@ MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
         bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (bitctx->update_curbyte(bitctx)) {
+        if (update_curbyte(bitctx)) {
             return  MPP_ERR_READ_BIT;
         }
     }
@@ -243,16 +278,31 @@ MPP_RET mpp_show_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 */
 MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
 {
-    RK_S32 num_bits = -1;
-    RK_S32 bit;
+    RK_S32 num_bits = 0;
     RK_S32 rest;
-    // Count the number of contiguous zero bits.
-    do {
-        if (mpp_read_bits(bitctx, 1, &bit)) {
+
+    // Count the number of contiguous zero bits byte by byte and consume the
+    // first one bit after them.
+    while (1) {
+        RK_S32 remain = bitctx->num_remaining_bits_in_curr_byte_;
+        RK_U32 bits = (RK_U32)bitctx->curr_byte_ & ((1 << remain) - 1);
+
+        if (bits) {
+            RK_S32 zeros = count_leading_zeros_8bit(bits) - (8 - remain);
+
+            num_bits += zeros;
+            bitctx->num_remaining_bits_in_curr_byte_ -= zeros + 1;
+            bitctx->used_bits += zeros + 1;
+            break;
+        }
+
+        num_bits += remain;
+        bitctx->num_remaining_bits_in_curr_byte_ = 0;
+        bitctx->used_bits += remain;
+        if (num_bits > 31 || update_curbyte(bitctx)) {
             return  MPP_ERR_READ_BIT;
         }
-        num_bits++;
-    } while (bit == 0);
+    }
     if (num_bits > 31) {
         return  MPP_ERR_READ_BIT;
     }
@@ -303,7 +353,7 @@ RK_U32 mpp_has_more_rbsp_data(BitReadCtx_t *bitctx)
 
     // Make sure we have more bits, if we are at 0 bits in current byte
     // and updating current byte fails, we don't have more data anyway.
-    if (bitctx->num_remaining_bits_in_curr_byte_ == 0 && bitctx->update_curbyte(bitctx))
+    if (bitctx->num_remaining_bits_in_curr_byte_ == 0 && update_curbyte(bitctx))
         return 0;
     // On last byte?
     if (bitctx->bytes_left_)
@@ -77,7 +77,7 @@ public:
         return &instance;
     }
     static Mutex *get_lock() {
-        static Mutex lock;
+        static Mutex lock(mpp_lock_stat_get(MODULE_TAG));
         return &lock;
     }
 
@@ -233,6 +233,42 @@ static void buf_grp_add_log(MppBufferGroupImpl *group, MppBufOps ops, const char
         buf_logs_write(group->logs, group->group_id, -1, ops, 0, caller);
 }
 
+static RK_S32 buf_size_class(size_t size)
+{
+    size_t unit = size >> 12;
+
+    if ((RK_U64)unit >> 32)
+        return BUF_SIZE_CLASS_NUM - 1;
+
+    return MPP_MIN(mpp_log2((RK_U32)unit), BUF_SIZE_CLASS_NUM - 1);
+}
+
+static void buf_grp_add_unused(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    RK_S32 size_class = buf_size_class(buffer->info.size);
+
+    list_add_tail(&buffer->list_status, &group->list_unused[size_class]);
+    group->unused_mask |= 1U << size_class;
+    group->count_unused++;
+}
+
+static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
+                          RK_U32 reuse, const char *caller);
+
+static void buf_grp_put_unused(MppBufferGroupImpl *group, const char *caller)
+{
+    RK_S32 i;
+
+    for (i = 0; i < BUF_SIZE_CLASS_NUM; i++) {
+        MppBufferImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            put_buffer(group, pos, 0, caller);
+        }
+    }
+    group->unused_mask = 0;
+}
+
 static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
                           RK_U32 reuse, const char *caller)
 {
@@ -273,8 +309,7 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
     if (reuse) {
         if (buffer->used && group) {
             group->count_used--;
-            list_add_tail(&buffer->list_status, &group->list_unused);
-            group->count_unused++;
+            buf_grp_add_unused(group, buffer);
         } else {
             mpp_err_f("can not reuse unused buffer %d at group %p:%d\n",
                       buffer->buffer_id, group, buffer->group_id);
@@ -442,8 +477,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         group->count_used++;
         *buffer = p;
     } else {
-        list_add_tail(&p->list_status, &group->list_unused);
-        group->count_unused++;
+        buf_grp_add_unused(group, p);
     }
 
     group->usage += info->size;
@@ -558,8 +592,10 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
     }
 
     mpp_log("unused buffer count %d\n", group->count_unused);
-    list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
-        dump_buffer_info(pos);
+    for (RK_S32 i = 0; i < BUF_SIZE_CLASS_NUM; i++) {
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            dump_buffer_info(pos);
+        }
     }
 
     if (group->logs)
@@ -573,36 +609,51 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size, const c
     MppBufferImpl *buffer = NULL;
 
     pthread_mutex_lock(&p->buf_lock);
-    if (!list_empty(&p->list_unused)) {
+    if (p->count_unused) {
         MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
+        RK_S32 size_class = buf_size_class(size);
+        RK_U32 mask;
 
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+        /* buffer in the same size class may be smaller than required */
+        list_for_each_entry_safe(pos, n, &p->list_unused[size_class], MppBufferImpl, list_status) {
             mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
                         size, pos->buffer_id, pos->info.size);
             if (pos->info.size >= size) {
                 buffer = pos;
-                pthread_mutex_lock(&buffer->lock);
-                buf_add_log(buffer, BUF_REF_INC, caller);
-                buffer->ref_count++;
-                buffer->used = 1;
-                list_del_init(&buffer->list_status);
-                list_add_tail(&buffer->list_status, &p->list_used);
-                p->count_used++;
-                p->count_unused--;
-                pthread_mutex_unlock(&buffer->lock);
-                found = 1;
                 break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
-                    put_buffer(p, pos, 0, caller);
-                } else
-                    search_count++;
             }
+
+            if (MPP_BUFFER_INTERNAL == p->mode)
+                put_buffer(p, pos, 0, caller);
+        }
+
+        /* buffer in larger size class is always large enough */
+        mask = p->unused_mask & ~((2U << size_class) - 1);
+        while (!buffer && mask) {
+            RK_S32 i = mpp_log2(mask & (~mask + 1));
+
+            if (list_empty(&p->list_unused[i]))
+                p->unused_mask &= ~(1U << i);
+            else
+                buffer = list_first_entry(&p->list_unused[i], MppBufferImpl, list_status);
+
+            mask &= ~(1U << i);
         }
 
-        if (!found && search_count) {
+        if (buffer) {
+            pthread_mutex_lock(&buffer->lock);
+            buf_add_log(buffer, BUF_REF_INC, caller);
+            buffer->ref_count++;
+            buffer->used = 1;
+            list_del_init(&buffer->list_status);
+            list_add_tail(&buffer->list_status, &p->list_used);
+            p->count_used++;
+            p->count_unused--;
+            pthread_mutex_unlock(&buffer->lock);
+        } else if (MPP_BUFFER_INTERNAL == p->mode) {
+            /* all unused buffer are too small, release them for new allocation */
+            buf_grp_put_unused(p, caller);
+        } else if (p->count_unused) {
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
             mpp_buffer_group_dump(p, caller);
         }
@@ -773,12 +824,7 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
     }
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            put_buffer(p, pos, 0, __FUNCTION__);
-        }
-    }
+    buf_grp_put_unused(p, __FUNCTION__);
 
     pthread_mutex_unlock(&p->buf_lock);
 
@@ -987,6 +1033,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     MppBufferType buffer_type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
     MppBufferGroupImpl *p = NULL;
     RK_U32 flag = MPP_ALLOC_FLAG_NONE;
+    RK_S32 i;
 
     /* env update */
     mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, mpp_buffer_debug);
@@ -1041,7 +1088,9 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
 
     INIT_LIST_HEAD(&p->list_group);
     INIT_LIST_HEAD(&p->list_used);
-    INIT_LIST_HEAD(&p->list_unused);
+    for (i = 0; i < BUF_SIZE_CLASS_NUM; i++)
+        INIT_LIST_HEAD(&p->list_unused[i]);
+    p->unused_mask = 0;
     INIT_HLIST_NODE(&p->hlist);
 
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
@@ -1112,13 +1161,7 @@ void MppBufferService::put_group(const char *caller, MppBufferGroupImpl *p)
     buf_grp_add_log(p, GRP_RELEASE, caller);
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            put_buffer(p, pos, 0, caller);
-        }
-    }
+    buf_grp_put_unused(p, caller);
 
     if (list_empty(&p->list_used)) {
         destroy_group(p);
@@ -259,3 +259,34 @@ MPP_RET check_cfg_info(MppCfgInfoNode *node, const char *name, CfgType type,
 
     return ret;
 }
+
+MPP_RET mpp_cfg_set_by_type(MppCfgInfoNode *info, void *cfg, void *val)
+{
+    MPP_RET ret = MPP_NOK;
+
+    switch (info->data_type) {
+    case CFG_FUNC_TYPE_S32 : {
+        ret = MPP_CFG_SET_S32(info, cfg, *(RK_S32 *)val);
+    } break;
+    case CFG_FUNC_TYPE_U32 : {
+        ret = MPP_CFG_SET_U32(info, cfg, *(RK_U32 *)val);
+    } break;
+    case CFG_FUNC_TYPE_S64 : {
+        ret = MPP_CFG_SET_S64(info, cfg, *(RK_S64 *)val);
+    } break;
+    case CFG_FUNC_TYPE_U64 : {
+        ret = MPP_CFG_SET_U64(info, cfg, *(RK_U64 *)val);
+    } break;
+    case CFG_FUNC_TYPE_St : {
+        ret = MPP_CFG_SET_St(info, cfg, *(void **)val);
+    } break;
+    case CFG_FUNC_TYPE_Ptr : {
+        ret = MPP_CFG_SET_Ptr(info, cfg, *(void **)val);
+    } break;
+    default : {
+        mpp_err("cfg %s found invalid cfg type %d\n", info->name, info->data_type);
+    } break;
+    }
+
+    return ret;
+}
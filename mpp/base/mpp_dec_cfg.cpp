@@ -43,6 +43,10 @@
 
 RK_U32 mpp_dec_cfg_debug = 0;
 
+/* info node range of the service for the config key check */
+static char *dec_cfg_key_start = NULL;
+static char *dec_cfg_key_end = NULL;
+
 typedef struct MppDecCfgInfo_t {
     MppCfgInfoHead      head;
     MppTrieNode         trie_node[];
@@ -124,6 +128,7 @@ public:
     ENTRY(base, enable_hdr_meta, U32, RK_U32,           MPP_DEC_CFG_CHANGE_ENABLE_HDR_META, base, enable_hdr_meta) \
     ENTRY(base, enable_thumbnail, U32, RK_U32,          MPP_DEC_CFG_CHANGE_ENABLE_THUMBNAIL, base, enable_thumbnail) \
     ENTRY(base, enable_mvc,     U32, RK_U32,            MPP_DEC_CFG_CHANGE_ENABLE_MVC,      base, enable_mvc) \
+    ENTRY(base, task_count,     U32, RK_U32,            MPP_DEC_CFG_CHANGE_TASK_COUNT,      base, task_count) \
     ENTRY(base, disable_thread, U32, RK_U32,            MPP_DEC_CFG_CHANGE_DISABLE_THREAD,  base, disable_thread) \
     ENTRY(cb, pkt_rdy_cb,       Ptr, MppExtCbFunc,      MPP_DEC_CB_CFG_CHANGE_PKT_RDY,      cb, pkt_rdy_cb) \
     ENTRY(cb, pkt_rdy_ctx,      Ptr, MppExtCbCtx,       MPP_DEC_CB_CFG_CHANGE_PKT_RDY,      cb, pkt_rdy_ctx) \
@@ -243,6 +248,9 @@ MppDecCfgService::MppDecCfgService() :
     mInfo = mpp_dec_cfg_flaten(trie, cfgs);
     mCfgSize = mInfo->head.cfg_size;
 
+    dec_cfg_key_start = (char *)get_info_root();
+    dec_cfg_key_end = (char *)mInfo->trie_node + mInfo->head.info_size;
+
     mpp_trie_deinit(trie);
 }
 
@@ -361,6 +369,103 @@ ENC_CFG_GET_ACCESS(mpp_dec_cfg_get_u64, RK_U64, U64);
 ENC_CFG_GET_ACCESS(mpp_dec_cfg_get_ptr, void *, Ptr);
 ENC_CFG_GET_ACCESS(mpp_dec_cfg_get_st,  void  , St);
 
+MPP_RET mpp_dec_cfg_get_key(const char *name, MppDecCfgKey *key)
+{
+    MppCfgInfoNode *info;
+
+    if (NULL == name || NULL == key) {
+        mpp_err_f("invalid input name %p key %p\n", name, key);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    info = MppDecCfgService::get()->get_info(name);
+    *key = info;
+    if (NULL == info) {
+        mpp_err_f("cfg %s is invalid\n", name);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MppCfgInfoNode *dec_cfg_key_to_info(MppDecCfg cfg, MppDecCfgKey key, const char *func)
+{
+    char *info = (char *)key;
+
+    if (NULL == cfg || info < dec_cfg_key_start || info >= dec_cfg_key_end) {
+        mpp_err("%s: invalid input cfg %p key %p\n", func, cfg, key);
+        return NULL;
+    }
+
+    return (MppCfgInfoNode *)info;
+}
+
+#define ENC_CFG_SET_KEY_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppDecCfg cfg, MppDecCfgKey key, in_type val) \
+    { \
+        MppCfgInfoNode *info = dec_cfg_key_to_info(cfg, key, __FUNCTION__); \
+        if (NULL == info) \
+            return MPP_ERR_NULL_PTR; \
+        if (CHECK_CFG_INFO(info, info->name, CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_dec_cfg_dbg_set("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_SET_##cfg_type(info, &((MppDecCfgImpl *)cfg)->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_SET_KEY_ACCESS(mpp_dec_cfg_set_s32_by_key, RK_S32, S32);
+ENC_CFG_SET_KEY_ACCESS(mpp_dec_cfg_set_u32_by_key, RK_U32, U32);
+ENC_CFG_SET_KEY_ACCESS(mpp_dec_cfg_set_s64_by_key, RK_S64, S64);
+ENC_CFG_SET_KEY_ACCESS(mpp_dec_cfg_set_u64_by_key, RK_U64, U64);
+ENC_CFG_SET_KEY_ACCESS(mpp_dec_cfg_set_ptr_by_key, void *, Ptr);
+
+#define ENC_CFG_GET_KEY_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppDecCfg cfg, MppDecCfgKey key, in_type *val) \
+    { \
+        MppCfgInfoNode *info = dec_cfg_key_to_info(cfg, key, __FUNCTION__); \
+        if (NULL == info) \
+            return MPP_ERR_NULL_PTR; \
+        if (CHECK_CFG_INFO(info, info->name, CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_dec_cfg_dbg_get("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_GET_##cfg_type(info, &((MppDecCfgImpl *)cfg)->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_GET_KEY_ACCESS(mpp_dec_cfg_get_s32_by_key, RK_S32, S32);
+ENC_CFG_GET_KEY_ACCESS(mpp_dec_cfg_get_u32_by_key, RK_U32, U32);
+ENC_CFG_GET_KEY_ACCESS(mpp_dec_cfg_get_s64_by_key, RK_S64, S64);
+ENC_CFG_GET_KEY_ACCESS(mpp_dec_cfg_get_u64_by_key, RK_U64, U64);
+ENC_CFG_GET_KEY_ACCESS(mpp_dec_cfg_get_ptr_by_key, void *, Ptr);
+
+MPP_RET mpp_dec_cfg_set_batch(MppDecCfg cfg, MppDecCfgKeyVal *kv, RK_S32 count)
+{
+    MppDecCfgImpl *p = (MppDecCfgImpl *)cfg;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    if (NULL == cfg || (NULL == kv && count)) {
+        mpp_err_f("invalid input cfg %p kv %p\n", cfg, kv);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < count; i++) {
+        MppCfgInfoNode *info = dec_cfg_key_to_info(cfg, kv[i].key, __FUNCTION__);
+
+        if (NULL == info)
+            return MPP_ERR_NULL_PTR;
+
+        mpp_dec_cfg_dbg_set("name %s type %s\n", info->name, cfg_type_names[info->data_type]);
+        ret = mpp_cfg_set_by_type(info, &p->cfg, &kv[i].val);
+        if (ret)
+            break;
+    }
+
+    return ret;
+}
+
 void mpp_dec_cfg_show(void)
 {
     RK_S32 node_count = MppDecCfgService::get()->get_node_count();
@@ -44,6 +44,10 @@
 
 RK_U32 mpp_enc_cfg_debug = 0;
 
+/* info node range of the service for the config key check */
+static char *enc_cfg_key_start = NULL;
+static char *enc_cfg_key_end = NULL;
+
 /*
  * MppEncCfgInfo data struct
  *
@@ -395,6 +399,9 @@ MppEncCfgService::MppEncCfgService() :
     mInfo = mpp_enc_cfg_flaten(trie, cfgs);
     mCfgSize = mInfo->head.cfg_size;
 
+    enc_cfg_key_start = (char *)get_info_root();
+    enc_cfg_key_end = (char *)mInfo->trie_node + mInfo->head.info_size;
+
     mpp_enc_cfg_dbg_func("node cnt: %d\n", get_node_count());
 
     mpp_trie_deinit(trie);
@@ -523,6 +530,105 @@ ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_u64, RK_U64, U64);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_ptr, void *, Ptr);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_st,  void  , St);
 
+MPP_RET mpp_enc_cfg_get_key(const char *name, MppEncCfgKey *key)
+{
+    MppCfgInfoNode *info;
+
+    if (NULL == name || NULL == key) {
+        mpp_err_f("invalid input name %p key %p\n", name, key);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    info = MppEncCfgService::get()->get_info(name);
+    *key = info;
+    if (NULL == info) {
+        mpp_err_f("cfg %s is invalid\n", name);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+static MppCfgInfoNode *enc_cfg_key_to_info(MppEncCfg cfg, MppEncCfgKey key, const char *func)
+{
+    char *info = (char *)key;
+
+    if (NULL == cfg || info < enc_cfg_key_start || info >= enc_cfg_key_end) {
+        mpp_err("%s: invalid input cfg %p key %p\n", func, cfg, key);
+        return NULL;
+    }
+
+    return (MppCfgInfoNode *)info;
+}
+
+#define ENC_CFG_SET_KEY_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppEncCfg cfg, MppEncCfgKey key, in_type val) \
+    { \
+        MppCfgInfoNode *info = enc_cfg_key_to_info(cfg, key, __FUNCTION__); \
+        if (NULL == info) \
+            return MPP_ERR_NULL_PTR; \
+        if (CHECK_CFG_INFO(info, info->name, CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_enc_cfg_dbg_set("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_SET_##cfg_type(info, &((MppEncCfgImpl *)cfg)->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_s32_by_key, RK_S32, S32);
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_u32_by_key, RK_U32, U32);
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_s64_by_key, RK_S64, S64);
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_u64_by_key, RK_U64, U64);
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_ptr_by_key, void *, Ptr);
+ENC_CFG_SET_KEY_ACCESS(mpp_enc_cfg_set_st_by_key,  void *, St);
+
+#define ENC_CFG_GET_KEY_ACCESS(func_name, in_type, cfg_type) \
+    MPP_RET func_name(MppEncCfg cfg, MppEncCfgKey key, in_type *val) \
+    { \
+        MppCfgInfoNode *info = enc_cfg_key_to_info(cfg, key, __FUNCTION__); \
+        if (NULL == info) \
+            return MPP_ERR_NULL_PTR; \
+        if (CHECK_CFG_INFO(info, info->name, CFG_FUNC_TYPE_##cfg_type)) { \
+            return MPP_NOK; \
+        } \
+        mpp_enc_cfg_dbg_get("name %s type %s\n", info->name, cfg_type_names[info->data_type]); \
+        MPP_RET ret = MPP_CFG_GET_##cfg_type(info, &((MppEncCfgImpl *)cfg)->cfg, val); \
+        return ret; \
+    }
+
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_s32_by_key, RK_S32, S32);
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_u32_by_key, RK_U32, U32);
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_s64_by_key, RK_S64, S64);
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_u64_by_key, RK_U64, U64);
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_ptr_by_key, void *, Ptr);
+ENC_CFG_GET_KEY_ACCESS(mpp_enc_cfg_get_st_by_key,  void  , St);
+
+MPP_RET mpp_enc_cfg_set_batch(MppEncCfg cfg, MppEncCfgKeyVal *kv, RK_S32 count)
+{
+    MppEncCfgImpl *p = (MppEncCfgImpl *)cfg;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+
+    if (NULL == cfg || (NULL == kv && count)) {
+        mpp_err_f("invalid input cfg %p kv %p\n", cfg, kv);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < count; i++) {
+        MppCfgInfoNode *info = enc_cfg_key_to_info(cfg, kv[i].key, __FUNCTION__);
+
+        if (NULL == info)
+            return MPP_ERR_NULL_PTR;
+
+        mpp_enc_cfg_dbg_set("name %s type %s\n", info->name, cfg_type_names[info->data_type]);
+        ret = mpp_cfg_set_by_type(info, &p->cfg, &kv[i].val);
+        if (ret)
+            break;
+    }
+
+    return ret;
+}
+
 void mpp_enc_cfg_show(void)
 {
     RK_S32 node_count = MppEncCfgService::get()->get_node_count();
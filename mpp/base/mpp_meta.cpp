@@ -21,6 +21,7 @@
 #include "mpp_mem.h"
 #include "mpp_list.h"
 #include "mpp_lock.h"
+#include "mpp_mem_pool.h"
 
 #include "mpp_meta_impl.h"
 
@@ -31,6 +32,11 @@
 #define WRITE_ONCE(x, val)  ((*(volatile typeof(x) *) &(x)) = (val))
 #define READ_ONCE(var)      (*((volatile typeof(var) *)(&(var))))
 
+/* key hash table size for perfect hash of meta_defs */
+#define META_HASH_BITS_MIN  6
+#define META_HASH_BITS_MAX  10
+#define META_HASH_TRY_MAX   65536
+
 static MppMetaDef meta_defs[] = {
     /* categorized by type */
     /* data flow type */
@@ -96,12 +102,21 @@ private:
     MppMetaService &operator=(const MppMetaService &);
 
     spinlock_t          mLock;
+    MppLockStat         *mLockStat;
     struct list_head    mlist_meta;
+    MppMemPool          mPool;
 
     RK_U32              meta_id;
     RK_S32              meta_count;
     RK_U32              finished;
 
+    /* perfect hash from key to meta_defs index */
+    RK_U32              mHashMul;
+    RK_U32              mHashShift;
+    RK_S8               mHashIdx[1 << META_HASH_BITS_MAX];
+
+    void                init_hash();
+
 public:
     static MppMetaService *get_inst() {
         static MppMetaService instance;
@@ -112,9 +127,17 @@ public:
      * get_index_of_key does two things:
      * 1. Check the key / type pair is correct or not.
      *    If failed on check return negative value
-     * 2. Compare all exsisting meta data defines to find the non-negative index
+     * 2. Find the non-negative index of the key in meta data defines by
+     *    perfect hash
      */
-    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
+    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type) {
+        RK_S32 index = mHashIdx[((RK_U32)key * mHashMul) >> mHashShift];
+
+        if (index >= 0 && meta_defs[index].key == key && meta_defs[index].type == type)
+            return index;
+
+        return -1;
+    }
 
     MppMetaImpl  *get_meta(const char *tag, const char *caller);
     void          put_meta(MppMetaImpl *meta);
@@ -126,7 +149,11 @@ MppMetaService::MppMetaService()
       finished(0)
 {
     mpp_spinlock_init(&mLock);
+    mLockStat = mpp_lock_stat_get(MODULE_TAG);
     INIT_LIST_HEAD(&mlist_meta);
+    init_hash();
+    mPool = mpp_mem_pool_init_f(MODULE_TAG, sizeof(MppMetaImpl) +
+                                sizeof(MppMetaVal) * MPP_ARRAY_ELEMS(meta_defs));
 }
 
 MppMetaService::~MppMetaService()
@@ -142,29 +169,65 @@ MppMetaService::~MppMetaService()
     }
 
     mpp_assert(meta_count == 0);
+    mpp_mem_pool_deinit_f(MODULE_TAG, mPool);
     finished = 1;
 }
 
-RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
+/*
+ * Search a multiplier which maps all keys to different slots of the table.
+ * The keys are fixed at build time so the search always ends with the same
+ * result on the first call.
+ */
+void MppMetaService::init_hash()
 {
-    RK_S32 i = 0;
-    RK_S32 num = MPP_ARRAY_ELEMS(meta_defs);
+    RK_U32 num = MPP_ARRAY_ELEMS(meta_defs);
+    RK_U32 bits;
+    RK_U32 i, j;
+
+    /* key_mask has one bit for each key */
+    mpp_assert(num <= 64);
+
+    for (bits = META_HASH_BITS_MIN; bits <= META_HASH_BITS_MAX; bits++) {
+        RK_U32 shift = 32 - bits;
 
-    for (i = 0; i < num; i++) {
-        if ((meta_defs[i].key == key) && (meta_defs[i].type == type))
-            break;
+        if ((1U << bits) < num)
+            continue;
+
+        for (i = 0; i < META_HASH_TRY_MAX; i++) {
+            RK_U32 mul = ((2 * i + 1) * 0x9E3779B1) | 1;
+
+            memset(mHashIdx, -1, sizeof(mHashIdx));
+
+            for (j = 0; j < num; j++) {
+                RK_U32 hash = ((RK_U32)meta_defs[j].key * mul) >> shift;
+
+                if (mHashIdx[hash] >= 0)
+                    break;
+
+                mHashIdx[hash] = j;
+            }
+
+            if (j == num) {
+                mHashMul = mul;
+                mHashShift = shift;
+                return;
+            }
+        }
     }
 
-    return (i < num) ? (i) : (-1);
+    /* all key will fail on lookup */
+    mpp_err_f("failed to find perfect hash for %d keys\n", num);
+    memset(mHashIdx, -1, sizeof(mHashIdx));
+    mHashMul = 0;
+    mHashShift = 31;
 }
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc_size(MppMetaImpl, sizeof(MppMetaImpl) +
-                                        sizeof(MppMetaVal) * MPP_ARRAY_ELEMS(meta_defs));
+    /* node from pool is zeroed so all values are invalid */
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get_f(caller, mPool);
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
-        RK_U32 i;
 
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
         impl->caller = caller;
@@ -172,11 +235,9 @@ MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
         INIT_LIST_HEAD(&impl->list_meta);
         impl->ref_count = 1;
         impl->node_count = 0;
+        impl->key_mask = 0;
 
-        for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++)
-            impl->vals[i].state = 0;
-
-        mpp_spinlock_lock(&mLock);
+        mpp_spinlock_lock_stat(&mLock, mLockStat);
         list_add_tail(&impl->list_meta, &mlist_meta);
         mpp_spinlock_unlock(&mLock);
         MPP_FETCH_ADD(&meta_count, 1);
@@ -201,12 +262,12 @@ void MppMetaService::put_meta(MppMetaImpl *meta)
         return;
     }
 
-    mpp_spinlock_lock(&mLock);
+    mpp_spinlock_lock_stat(&mLock, mLockStat);
     list_del_init(&meta->list_meta);
     mpp_spinlock_unlock(&mLock);
     MPP_FETCH_SUB(&meta_count, 1);
 
-    mpp_free(meta);
+    mpp_mem_pool_put_f(__FUNCTION__, mPool, meta);
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -269,12 +330,13 @@ MPP_RET mpp_meta_dump(MppMeta meta)
     }
 
     MppMetaImpl *impl = (MppMetaImpl *)meta;
+    RK_U64 mask = impl->key_mask;
     RK_U32 i;
 
     mpp_log("dumping meta %d node count %d\n", impl->meta_id, impl->node_count);
 
-    for (i = 0; i < MPP_ARRAY_ELEMS(meta_defs); i++) {
-        if (!impl->vals[i].state)
+    for (i = 0; mask; i++, mask >>= 1) {
+        if (!(mask & 1) || !impl->vals[i].state)
             continue;
 
         const char *key = (const char *)&meta_defs[i].key;
@@ -301,8 +363,11 @@ MPP_RET mpp_meta_dump(MppMeta meta)
             return MPP_NOK; \
         MppMetaImpl *impl = (MppMetaImpl *)meta; \
         MppMetaVal *meta_val = &impl->vals[index]; \
-        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_INVALID, META_VAL_VALID)) \
+        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_INVALID, META_VAL_VALID)) { \
             MPP_FETCH_ADD(&impl->node_count, 1); \
+            if (!(impl->key_mask & (1ULL << index))) \
+                MPP_FETCH_OR(&impl->key_mask, 1ULL << index); \
+        } \
         meta_val->key_field = val; \
         MPP_FETCH_OR(&meta_val->state, META_VAL_READY); \
         return MPP_OK; \
@@ -320,7 +385,8 @@ MPP_RET mpp_meta_dump(MppMeta meta)
         MppMetaImpl *impl = (MppMetaImpl *)meta; \
         MppMetaVal *meta_val = &impl->vals[index]; \
         MPP_RET ret = MPP_NOK; \
-        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
+        if ((READ_ONCE(impl->key_mask) & (1ULL << index)) && \
+            MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
             *val = meta_val->key_field; \
             MPP_FETCH_SUB(&impl->node_count, 1); \
             ret = MPP_OK; \
@@ -340,7 +406,8 @@ MPP_RET mpp_meta_dump(MppMeta meta)
         MppMetaImpl *impl = (MppMetaImpl *)meta; \
         MppMetaVal *meta_val = &impl->vals[index]; \
         MPP_RET ret = MPP_NOK; \
-        if (MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
+        if ((READ_ONCE(impl->key_mask) & (1ULL << index)) && \
+            MPP_BOOL_CAS(&meta_val->state, META_VAL_VALID | META_VAL_READY, META_VAL_INVALID)) { \
             *val = meta_val->key_field; \
             MPP_FETCH_SUB(&impl->node_count, 1); \
             ret = MPP_OK; \
@@ -18,7 +18,9 @@
 
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_debug.h"
+#include "mpp_thread.h"
 #include "mpp_mem_pool.h"
 #include "mpp_packet_impl.h"
 #include "mpp_meta_impl.h"
@@ -29,6 +31,160 @@ static MppMemPool mpp_packet_pool = mpp_mem_pool_init_f(module_name, sizeof(MppP
 #define setup_mpp_packet_name(packet) \
     ((MppPacketImpl*)packet)->name = module_name;
 
+/*
+ * Packet data pool for the copy path of mpp_packet_copy_init.
+ *
+ * Data block is size classed by power of two from 4K to 4M. Freed block is
+ * kept in the free list of its class and total cached size is bounded by
+ * env mpp_packet_pool_max (in KB). Block larger than the max class is not
+ * cached.
+ */
+#define PKT_POOL_CLASS_SHIFT    12
+#define PKT_POOL_CLASS_NUM      11
+#define PKT_POOL_CACHE_MAX      SZ_16M
+/* extra data padding for 32 bit read in parser and the part to be zeroed */
+#define PKT_DATA_PAD_SIZE       256
+#define PKT_DATA_ZERO_SIZE      64
+/* keep the data pointer aligned as mpp_malloc */
+#define PKT_BLK_HDR_SIZE        64
+
+typedef struct MppPktBlk_t {
+    struct MppPktBlk_t  *next;
+    size_t              size;
+    RK_S32              index;
+} MppPktBlk;
+
+class MppPktDataPool
+{
+private:
+    Mutex               mLock;
+    MppPktBlk           *mFree[PKT_POOL_CLASS_NUM];
+    MppPacketPoolStat   mStat;
+    RK_S32              mFinalized;
+
+public:
+    MppPktDataPool();
+    ~MppPktDataPool();
+
+    void *get(size_t length);
+    void put(void *data);
+    void get_stat(MppPacketPoolStat *stat);
+};
+
+MppPktDataPool::MppPktDataPool()
+    : mFinalized(0)
+{
+    RK_U32 max_kb = 0;
+
+    memset(mFree, 0, sizeof(mFree));
+    memset(&mStat, 0, sizeof(mStat));
+
+    mpp_env_get_u32("mpp_packet_pool_max", &max_kb, PKT_POOL_CACHE_MAX / SZ_1K);
+    mStat.limit_bytes = (size_t)max_kb * SZ_1K;
+}
+
+MppPktDataPool::~MppPktDataPool()
+{
+    RK_S32 i;
+
+    AutoMutex auto_lock(&mLock);
+
+    for (i = 0; i < PKT_POOL_CLASS_NUM; i++) {
+        MppPktBlk *blk = mFree[i];
+
+        while (blk) {
+            MppPktBlk *next = blk->next;
+
+            mpp_free(blk);
+            blk = next;
+        }
+        mFree[i] = NULL;
+    }
+    mStat.cached_bytes = 0;
+    /* packet deinit after static destruction will free block directly */
+    mFinalized = 1;
+}
+
+void *MppPktDataPool::get(size_t length)
+{
+    size_t need = length + PKT_DATA_PAD_SIZE;
+    size_t size = (size_t)1 << PKT_POOL_CLASS_SHIFT;
+    RK_S32 index = 0;
+    MppPktBlk *blk = NULL;
+
+    while (size < need && index < PKT_POOL_CLASS_NUM) {
+        size <<= 1;
+        index++;
+    }
+
+    if (index >= PKT_POOL_CLASS_NUM) {
+        index = -1;
+        size = need;
+    }
+
+    {
+        AutoMutex auto_lock(&mLock);
+
+        mStat.get_count++;
+        if (index >= 0 && mFree[index]) {
+            blk = mFree[index];
+            mFree[index] = blk->next;
+            mStat.cached_bytes -= size;
+            mStat.hit_count++;
+        }
+        mStat.used_bytes += size;
+        if (mStat.used_bytes + mStat.cached_bytes > mStat.peak_bytes)
+            mStat.peak_bytes = mStat.used_bytes + mStat.cached_bytes;
+    }
+
+    if (NULL == blk) {
+        blk = (MppPktBlk *)mpp_malloc_size(RK_U8, PKT_BLK_HDR_SIZE + size);
+        if (NULL == blk) {
+            AutoMutex auto_lock(&mLock);
+
+            mStat.used_bytes -= size;
+            return NULL;
+        }
+
+        blk->size = size;
+        blk->index = index;
+    }
+    blk->next = NULL;
+
+    return (RK_U8 *)blk + PKT_BLK_HDR_SIZE;
+}
+
+void MppPktDataPool::put(void *data)
+{
+    MppPktBlk *blk = (MppPktBlk *)((RK_U8 *)data - PKT_BLK_HDR_SIZE);
+    size_t size = blk->size;
+    RK_S32 index = blk->index;
+
+    if (!mFinalized) {
+        AutoMutex auto_lock(&mLock);
+
+        mStat.used_bytes -= size;
+        if (index >= 0 && mStat.cached_bytes + size <= mStat.limit_bytes) {
+            blk->next = mFree[index];
+            mFree[index] = blk;
+            mStat.cached_bytes += size;
+            return;
+        }
+        mStat.drop_count++;
+    }
+
+    mpp_free(blk);
+}
+
+void MppPktDataPool::get_stat(MppPacketPoolStat *stat)
+{
+    AutoMutex auto_lock(&mLock);
+
+    memcpy(stat, &mStat, sizeof(*stat));
+}
+
+static MppPktDataPool mpp_packet_data_pool;
+
 MPP_RET check_is_mpp_packet(void *packet)
 {
     if (packet && ((MppPacketImpl*)packet)->name == module_name)
@@ -132,7 +288,7 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
          * due to parser may be read 32 bit interface so we must alloc more size
          * then real size to avoid read carsh
          */
-        void *pos = mpp_malloc_size(void, length + 256);
+        void *pos = mpp_packet_data_pool.get(length);
         if (NULL == pos) {
             mpp_err_f("malloc failed, size %d\n", length);
             mpp_packet_deinit(&pkt);
@@ -144,13 +300,13 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
         p->size = p->length = length;
         p->flag |= MPP_PACKET_FLAG_INTERNAL;
 
-        if (length) {
+        if (length)
             memcpy(pos, src_impl->pos, length);
-            /*
-             * clean more alloc byte to zero
-             */
-            memset((RK_U8*)pos + length, 0, 256);
-        }
+        /*
+         * recycled block may have stale data after the valid data so only
+         * clean the bytes that may be read ahead by parser
+         */
+        memset((RK_U8*)pos + length, 0, PKT_DATA_ZERO_SIZE);
     }
 
     *packet = pkt;
@@ -171,7 +327,7 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
         mpp_buffer_put(p->buffer);
 
     if (p->flag & MPP_PACKET_FLAG_INTERNAL)
-        mpp_free(p->data);
+        mpp_packet_data_pool.put(p->data);
 
     if (p->meta)
         mpp_meta_put(p->meta);
@@ -632,3 +788,14 @@ MPP_PACKET_ACCESSORS(RK_S64, dts)
 MPP_PACKET_ACCESSORS(RK_U32, flag)
 MPP_PACKET_ACCESSORS(MppTask, task)
 MPP_PACKET_ACCESSOR_GET(RK_U32, segment_nb)
+
+MPP_RET mpp_packet_pool_get_stat(MppPacketPoolStat *stat)
+{
+    if (NULL == stat) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_packet_data_pool.get_stat(stat);
+    return MPP_OK;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode"
+
+#include <string.h>
+
+#include "mpp_startcode.h"
+
+#define WORD_ONES       0x0101010101010101ULL
+#define WORD_HIGHS      0x8080808080808080ULL
+
+/* non-zero when any byte in the word is zero */
+#define WORD_HAS_ZERO(x)    (((x) - WORD_ONES) & ~(x) & WORD_HIGHS)
+
+RK_S32 mpp_find_start_code(const RK_U8 *data, RK_S32 size, RK_U32 prefix)
+{
+    RK_S32 i;
+
+    if (!data || size <= 0)
+        return -1;
+
+    /* start code ending in the first two bytes needs the history bytes */
+    for (i = 0; i < 2 && i < size; i++) {
+        prefix = (prefix << 8) | data[i];
+        if ((prefix & 0x00FFFFFF) == 0x00000001)
+            return i;
+    }
+
+    /*
+     * A start code beginning at data[i + k] (k = 0 ~ 7) has two zero bytes at
+     * data[i + k] and data[i + k + 1] and one of them is at odd offset. So an
+     * eight byte word without zero byte can be skipped as a whole and only
+     * the zero bytes at odd offset need to be checked. The word is loaded by
+     * memcpy to avoid unaligned access fault.
+     */
+    i = 0;
+    for (; i + 10 <= size; i += 8) {
+        const RK_U8 *p = data + i;
+        RK_U64 word;
+        RK_S32 k;
+
+        memcpy(&word, p, sizeof(word));
+        if (!WORD_HAS_ZERO(word))
+            continue;
+
+        for (k = 1; k < 8; k += 2) {
+            if (p[k])
+                continue;
+            if (!p[k - 1] && p[k + 1] == 1)
+                return i + k + 1;
+            if (!p[k + 1] && p[k + 2] == 1)
+                return i + k + 2;
+        }
+    }
+
+    for (; i + 2 < size; i++) {
+        if (!data[i] && !data[i + 1] && data[i + 2] == 1)
+            return i + 2;
+    }
+
+    return -1;
+}
@@ -20,10 +20,17 @@
 #include <string.h>
 
 #include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_bitread.h"
+#include "mpp_bitwrite.h"
 
 #define BIT_READ_BUFFER_SIZE        (1024)
+#define RANDOM_OPS_COUNT            (64 * 1024)
+#define RANDOM_BUFFER_SIZE          (RANDOM_OPS_COUNT * 8)
+#define BENCH_HEADER_LOOP           (100000)
+#define BENCH_RANDOM_LOOP           (20)
 
 typedef enum BitOpsType_e {
     BIT_GET,
@@ -328,6 +335,174 @@ __NORMAL:
     return ret;
 }
 
+/*
+ * Write random syntax elements with emulation prevention and read them back.
+ * Zero values are frequent to generate plenty of 00 00 03 sequences.
+ */
+static RK_S32 gen_random_ops(BitOps *ops, RK_S32 count, RK_U8 *buf, RK_S32 size)
+{
+    MppWriteCtx writer;
+    RK_S32 i;
+
+    mpp_writer_init(&writer, buf, size);
+
+    for (i = 0; i < count; i++) {
+        BitOps *op = &ops[i];
+        RK_S32 zero = !(rand() & 3);
+
+        op->type = (BitOpsType)(rand() % 3);
+        op->syntax[0] = '\0';
+
+        switch (op->type) {
+        case BIT_GET : {
+            op->len = rand() % 24 + 1;
+            op->val = zero ? 0 : rand() & ((1 << op->len) - 1);
+            mpp_writer_put_bits(&writer, op->val, op->len);
+        } break;
+        case BIT_GET_UE : {
+            op->len = 0;
+            op->val = zero ? 0 : rand() & ((1 << (rand() % 20)) - 1);
+            mpp_writer_put_ue(&writer, op->val);
+        } break;
+        case BIT_GET_SE :
+        default : {
+            op->len = 0;
+            op->val = zero ? 0 : rand() & ((1 << (rand() % 20)) - 1);
+            if (rand() & 1)
+                op->val = -op->val;
+            mpp_writer_put_se(&writer, op->val);
+        } break;
+        }
+    }
+
+    mpp_writer_trailing(&writer);
+
+    return mpp_writer_status(&writer) ? 0 : mpp_writer_bytes(&writer);
+}
+
+static MPP_RET read_random_ops(BitOps *ops, RK_S32 count, RK_U8 *buf, RK_S32 size,
+                               RK_S32 check)
+{
+    BitReadCtx_t reader;
+    RK_S32 val = 0;
+    RK_S32 i;
+
+    mpp_set_bitread_ctx(&reader, buf, size);
+    mpp_set_bitread_pseudo_code_type(&reader, PSEUDO_CODE_H264_H265);
+
+    for (i = 0; i < count; i++) {
+        BitOps *op = &ops[i];
+        BitReadCtx_t *ctx = &reader;
+
+        switch (op->type) {
+        case BIT_GET :
+            READ_BITS(ctx, op->len, &val);
+            break;
+        case BIT_GET_UE :
+            READ_UE(ctx, &val);
+            break;
+        case BIT_GET_SE :
+        default :
+            READ_SE(ctx, &val);
+            break;
+        }
+
+        if (check && val != op->val) {
+            mpp_err("random op %d %s expect %d but %d\n", i, bitOpsStr[op->type],
+                    op->val, val);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+__BITREAD_ERR:
+    mpp_err("random op %d %s read failed\n", i, bitOpsStr[ops[i].type]);
+    return MPP_NOK;
+}
+
+static MPP_RET read_header(BitOps *ops, RK_S32 count, RK_U8 *buf, RK_S32 size)
+{
+    BitReadCtx_t reader;
+    RK_S32 val = 0;
+    RK_S32 i;
+
+    mpp_set_bitread_ctx(&reader, buf, size);
+    mpp_set_bitread_pseudo_code_type(&reader, PSEUDO_CODE_H264_H265);
+
+    for (i = 0; i < count; i++) {
+        BitReadCtx_t *ctx = &reader;
+
+        switch (ops[i].type) {
+        case BIT_GET :
+            if (ops[i].len >= 32) {
+                READ_BITS_LONG(ctx, ops[i].len, &val);
+            } else {
+                READ_BITS(ctx, ops[i].len, &val);
+            }
+            break;
+        case BIT_GET_UE :
+            READ_UE(ctx, &val);
+            break;
+        case BIT_GET_SE :
+            READ_SE(ctx, &val);
+            break;
+        case BIT_SKIP :
+            SKIP_BITS_LONG(ctx, ops[i].len);
+            break;
+        }
+    }
+
+    return (MPP_RET)val;
+__BITREAD_ERR:
+    return MPP_NOK;
+}
+
+static MPP_RET bit_read_bench(void)
+{
+    BitOps *ops = mpp_calloc(BitOps, RANDOM_OPS_COUNT);
+    RK_U8 *buf = mpp_malloc(RK_U8, RANDOM_BUFFER_SIZE);
+    MPP_RET ret = MPP_NOK;
+    RK_S64 start;
+    RK_S64 time;
+    RK_S32 size;
+    RK_S32 i;
+
+    if (!ops || !buf)
+        goto DONE;
+
+    srand(0x5a5a);
+    size = gen_random_ops(ops, RANDOM_OPS_COUNT, buf, RANDOM_BUFFER_SIZE);
+    if (!size) {
+        mpp_err("random ops write failed\n");
+        goto DONE;
+    }
+
+    mpp_log("Reading %d random syntax elements in %d bytes...", RANDOM_OPS_COUNT, size);
+    ret = read_random_ops(ops, RANDOM_OPS_COUNT, buf, size, 1);
+    if (ret)
+        goto DONE;
+
+    start = mpp_time();
+    for (i = 0; i < BENCH_RANDOM_LOOP; i++)
+        read_random_ops(ops, RANDOM_OPS_COUNT, buf, size, 0);
+    time = MPP_MAX(mpp_time() - start, 1);
+    mpp_log("random syntax read %.2f M elements/s %.2f MB/s\n",
+            (double)RANDOM_OPS_COUNT * BENCH_RANDOM_LOOP / time,
+            (double)size * BENCH_RANDOM_LOOP / time);
+
+    start = mpp_time();
+    for (i = 0; i < BENCH_HEADER_LOOP; i++)
+        read_header(bit_ops_3, MPP_ARRAY_ELEMS(bit_ops_3), test_data_3, sizeof(test_data_3));
+    time = MPP_MAX(mpp_time() - start, 1);
+    mpp_log("H264 SPS header parse %.2f K headers/s\n",
+            (double)BENCH_HEADER_LOOP * 1000 / time);
+
+DONE:
+    MPP_FREE(ops);
+    MPP_FREE(buf);
+    return ret;
+}
+
 int main()
 {
     BitReadCtx_t reader;
@@ -381,6 +556,9 @@ int main()
 
         tmp = 0;
     }
+    if (bit_read_bench())
+        goto __READ_FAILED;
+
     mpp_log("mpp bit read test end\n");
     return 0;
 __READ_FAILED:
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_bitput_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_bitput.h"
+
+/*
+ * Run random sequences of put bits / align / bytes / array on the writer and
+ * on the one field per call reference with random buffer length, including
+ * writing over the buffer end, and compare the buffer and the writer state.
+ * Then time a register table like mix and a byte table on both.
+ */
+#define BUF_WORDS           128
+#define GUARD_WORDS         4
+#define FUZZ_ROUNDS         20000
+#define FUZZ_OPS            64
+#define BENCH_WORDS         (4864 / 8)
+#define BENCH_LOOP          20000
+
+static RK_U32 test_rand(RK_U32 *seed)
+{
+    /* xorshift32 for the reproducible sequence */
+    RK_U32 x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+
+    return x;
+}
+
+static RK_U64 test_rand64(RK_U32 *seed)
+{
+    RK_U64 val = test_rand(seed);
+
+    return (val << 32) | test_rand(seed);
+}
+
+static void put_bytes_ref(BitputCtx_t *bp, const RK_U8 *data, RK_S32 len, RK_S32 lbits)
+{
+    RK_S32 i;
+
+    for (i = 0; i < len; i++)
+        mpp_put_bits_c(bp, data[i], lbits);
+}
+
+static MPP_RET test_fuzz(void)
+{
+    static const RK_S32 aligns[] = { 8, 32, 64, 128, 256 };
+    RK_U64 buf0[BUF_WORDS + GUARD_WORDS];
+    RK_U64 buf1[BUF_WORDS + GUARD_WORDS];
+    RK_U8 data[96];
+    RK_U32 seed = 0x12345678;
+    RK_S32 r, n;
+    RK_U32 i;
+
+    for (r = 0; r < FUZZ_ROUNDS; r++) {
+        /* short buffer on some round for the end of buffer check */
+        RK_U32 len = (r & 3) ? BUF_WORDS : test_rand(&seed) % 16 + 1;
+        BitputCtx_t bp0;
+        BitputCtx_t bp1;
+
+        memset(buf0, 0xcc, sizeof(buf0));
+        memset(buf1, 0xcc, sizeof(buf1));
+        mpp_set_bitput_ctx(&bp0, buf0, len);
+        mpp_set_bitput_ctx(&bp1, buf1, len);
+
+        for (n = 0; n < FUZZ_OPS; n++) {
+            RK_U32 op = test_rand(&seed) % 8;
+            RK_S32 lbits;
+            RK_S32 count;
+
+            switch (op) {
+            case 0 :
+            case 1 :
+            case 2 : {
+                RK_U64 val = test_rand64(&seed);
+
+                lbits = test_rand(&seed) % 64 + 1;
+                /* the reference keeps 64 bit value on word boundary */
+                if (lbits == 64)
+                    val = 0;
+
+                mpp_put_bits_c(&bp0, val, lbits);
+                mpp_put_bits(&bp1, val, lbits);
+            } break;
+            case 3 : {
+                /* byte put to make byte aligned state for bulk copy */
+                lbits = 8;
+                count = test_rand(&seed) % 4;
+                for (i = 0; i < (RK_U32)count; i++)
+                    data[i] = test_rand(&seed);
+
+                put_bytes_ref(&bp0, data, count, lbits);
+                mpp_put_bytes(&bp1, data, count);
+            } break;
+            case 4 : {
+                RK_S32 align = aligns[test_rand(&seed) % MPP_ARRAY_ELEMS(aligns)];
+                RK_S32 flag = (test_rand(&seed) & 1) ? 0xf : 0;
+
+                mpp_put_align_c(&bp0, align, flag);
+                mpp_put_align(&bp1, align, flag);
+            } break;
+            case 5 :
+            case 6 : {
+                count = test_rand(&seed) % sizeof(data);
+                for (i = 0; i < (RK_U32)count; i++)
+                    data[i] = test_rand(&seed);
+
+                put_bytes_ref(&bp0, data, count, 8);
+                mpp_put_bytes(&bp1, data, count);
+            } break;
+            default : {
+                lbits = test_rand(&seed) % 8 + 1;
+                count = test_rand(&seed) % sizeof(data);
+                for (i = 0; i < (RK_U32)count; i++)
+                    data[i] = test_rand(&seed);
+
+                put_bytes_ref(&bp0, data, count, lbits);
+                mpp_put_array(&bp1, data, count, lbits);
+            } break;
+            }
+
+            /* bit position is not updated any more after buffer is full */
+            if (memcmp(buf0, buf1, sizeof(buf0)) || bp0.index != bp1.index ||
+                (bp0.index < len && (bp0.bitpos != bp1.bitpos || bp0.bvalue != bp1.bvalue))) {
+                mpp_err("round %d op %d type %d mismatch index %d:%d bitpos %d:%d\n",
+                        r, n, op, bp0.index, bp1.index, bp0.bitpos, bp1.bitpos);
+                for (i = 0; i < MPP_ARRAY_ELEMS(buf0); i++) {
+                    if (buf0[i] != buf1[i])
+                        mpp_err("word %d %016llx vs %016llx\n", i, buf0[i], buf1[i]);
+                }
+                return MPP_NOK;
+            }
+        }
+    }
+
+    mpp_log("bit exact on %d rounds of %d random puts\n", FUZZ_ROUNDS, FUZZ_OPS);
+
+    return MPP_OK;
+}
+
+static void test_bench(void)
+{
+    static RK_U64 buf[BENCH_WORDS];
+    RK_U8 fields[BENCH_WORDS * 8];
+    RK_U8 lbits[BENCH_WORDS * 8];
+    RK_S32 nfields = 0;
+    RK_S32 total = 0;
+    RK_U32 seed = 0x9e3779b9;
+    BitputCtx_t bp;
+    RK_S64 time_ref;
+    RK_S64 time_new;
+    RK_S32 i, j;
+
+    /* register table like fields of 1 ~ 16 bits */
+    while (total + 16 < BENCH_WORDS * 64 - 64) {
+        lbits[nfields] = test_rand(&seed) % 16 + 1;
+        fields[nfields] = test_rand(&seed);
+        total += lbits[nfields];
+        nfields++;
+    }
+
+    time_ref = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        for (j = 0; j < nfields; j++)
+            mpp_put_bits_c(&bp, fields[j], lbits[j]);
+        mpp_put_align_c(&bp, 128, 0);
+    }
+    time_ref = mpp_time() - time_ref;
+
+    time_new = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        for (j = 0; j < nfields; j++)
+            mpp_put_bits(&bp, fields[j], lbits[j]);
+        mpp_put_align(&bp, 128, 0);
+    }
+    time_new = mpp_time() - time_new;
+
+    mpp_log("put %d fields ref %.3f us new %.3f us speedup %.2f\n", nfields,
+            (double)time_ref / BENCH_LOOP, (double)time_new / BENCH_LOOP,
+            time_new ? (double)time_ref / time_new : 0.0);
+
+    /* probability table like 8 bit run */
+    time_ref = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        for (j = 0; j < BENCH_WORDS * 8; j++)
+            mpp_put_bits_c(&bp, fields[j], 8);
+    }
+    time_ref = mpp_time() - time_ref;
+
+    time_new = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        mpp_put_bytes(&bp, fields, BENCH_WORDS * 8);
+    }
+    time_new = mpp_time() - time_new;
+
+    mpp_log("put %d bytes ref %.3f us new %.3f us speedup %.2f\n", BENCH_WORDS * 8,
+            (double)time_ref / BENCH_LOOP, (double)time_new / BENCH_LOOP,
+            time_new ? (double)time_ref / time_new : 0.0);
+
+    /* flag table like 1 bit run */
+    time_ref = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        for (j = 0; j < BENCH_WORDS * 8; j++)
+            mpp_put_bits_c(&bp, fields[j], 1);
+    }
+    time_ref = mpp_time() - time_ref;
+
+    time_new = mpp_time();
+    for (i = 0; i < BENCH_LOOP; i++) {
+        mpp_set_bitput_ctx(&bp, buf, BENCH_WORDS);
+        mpp_put_array(&bp, fields, BENCH_WORDS * 8, 1);
+    }
+    time_new = mpp_time() - time_new;
+
+    mpp_log("put %d flags ref %.3f us new %.3f us speedup %.2f\n", BENCH_WORDS * 8,
+            (double)time_ref / BENCH_LOOP, (double)time_new / BENCH_LOOP,
+            time_new ? (double)time_ref / time_new : 0.0);
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_bitput_test start\n");
+
+    ret = test_fuzz();
+    if (!ret)
+        test_bench();
+
+    mpp_log("mpp_bitput_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buffer_std_test"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+/*
+ * Normal buffer on memfd with transparent huge page enabled.
+ * Buffers not smaller than 2M are rounded up to whole huge pages. The whole
+ * requested range is written through the mapping before the buffer is freed.
+ */
+static MPP_RET mpp_buffer_std_check(MppBufferGroup group, size_t size)
+{
+    MppBuffer buffer = NULL;
+    RK_U8 *ptr;
+    size_t buf_size;
+    MPP_RET ret;
+
+    ret = mpp_buffer_get(group, &buffer, size);
+    if (ret || NULL == buffer) {
+        mpp_err("get buffer size %d failed ret %d\n", size, ret);
+        return MPP_NOK;
+    }
+
+    buf_size = mpp_buffer_get_size(buffer);
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+
+    if (NULL == ptr || mpp_buffer_get_fd(buffer) < 0 || buf_size < size) {
+        mpp_err("buffer size %d invalid ptr %p fd %d size %d\n", size, ptr,
+                mpp_buffer_get_fd(buffer), buf_size);
+        ret = MPP_NOK;
+    } else if (size >= SZ_2M && (buf_size & (SZ_2M - 1))) {
+        mpp_err("buffer size %d is not rounded to huge page %d\n", size, buf_size);
+        ret = MPP_NOK;
+    } else {
+        /* touch the whole mapping including the rounded tail */
+        memset(ptr, 0x5a, buf_size);
+        if (ptr[0] != 0x5a || ptr[size - 1] != 0x5a || ptr[buf_size - 1] != 0x5a) {
+            mpp_err("buffer size %d read back mismatch\n", size);
+            ret = MPP_NOK;
+        }
+    }
+
+    mpp_log("buffer size %d -> %d %s\n", size, buf_size, ret ? "failed" : "ok");
+
+    mpp_buffer_put(buffer);
+
+    return ret;
+}
+
+int main()
+{
+    static const size_t sizes[] = { SZ_4K + 1, SZ_2M, SZ_2M + SZ_1M + 123, SZ_8M };
+    MppBufferGroup group = NULL;
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("mpp_buffer_std_test start\n");
+
+    /* read by the normal buffer allocator on its first open */
+    mpp_env_set_u32("allocator_std_thp", 1);
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret) {
+        mpp_err("mpp_buffer_group_get_internal failed\n");
+        goto DONE;
+    }
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(sizes); i++)
+        ret |= mpp_buffer_std_check(group, sizes[i]);
+
+    mpp_buffer_group_put(group);
+
+DONE:
+    mpp_log("mpp_buffer_std_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
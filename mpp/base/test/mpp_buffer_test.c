@@ -22,6 +22,8 @@
 #include "vld.h"
 #endif
 #include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
 #include "mpp_buffer.h"
@@ -31,6 +33,82 @@
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
 #define MPP_BUFFER_TEST_COMMIT_COUNT    10
 #define MPP_BUFFER_TEST_NORMAL_COUNT    10
+#define MPP_BUFFER_BENCH_LOOP           20000
+#define MPP_BUFFER_BENCH_HOLD           4
+
+/*
+ * Benchmark buffer get / put on one external group with mixed size buffers
+ * like the group shared by several decoder instances. One quarter of the
+ * buffers are large frame buffers and the others are smaller buffers left by
+ * other instances. Each loop gets and puts several frame buffers. All buffers
+ * share one memory block for only the buffer management cost is measured.
+ */
+static MPP_RET mpp_buffer_bench(RK_S32 count)
+{
+    static const size_t sizes[] = { SZ_4K, SZ_64K, SZ_512K, SZ_4M };
+    RK_S32 size_cnt = MPP_ARRAY_ELEMS(sizes);
+    size_t frame_size = sizes[size_cnt - 1];
+    MppBufferGroup group = NULL;
+    MppBuffer buffers[MPP_BUFFER_BENCH_HOLD];
+    MppBufferInfo commit;
+    void *ptr = NULL;
+    RK_S64 time;
+    RK_S32 i, j;
+    MPP_RET ret = MPP_NOK;
+
+    ptr = mpp_malloc_size(void, frame_size);
+    if (NULL == ptr) {
+        mpp_err("mpp_buffer_bench malloc failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    ret = mpp_buffer_group_get_external(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret) {
+        mpp_err("mpp_buffer_bench mpp_buffer_group_get failed\n");
+        goto DONE;
+    }
+
+    memset(&commit, 0, sizeof(commit));
+    commit.type = MPP_BUFFER_TYPE_NORMAL;
+    commit.ptr = ptr;
+
+    for (i = 0; i < count; i++) {
+        commit.size = sizes[i * size_cnt / count];
+        commit.index = i;
+
+        ret = mpp_buffer_commit(group, &commit);
+        if (ret) {
+            mpp_err("mpp_buffer_bench mpp_buffer_commit failed\n");
+            goto DONE;
+        }
+    }
+
+    time = mpp_time();
+    for (i = 0; i < MPP_BUFFER_BENCH_LOOP; i++) {
+        for (j = 0; j < MPP_BUFFER_BENCH_HOLD; j++) {
+            ret = mpp_buffer_get(group, &buffers[j], frame_size);
+            if (ret || mpp_buffer_get_size(buffers[j]) < frame_size) {
+                mpp_err("mpp_buffer_bench mpp_buffer_get failed\n");
+                goto DONE;
+            }
+        }
+
+        for (j = 0; j < MPP_BUFFER_BENCH_HOLD; j++)
+            mpp_buffer_put(buffers[j]);
+    }
+    time = mpp_time() - time;
+
+    mpp_log("mpp_buffer_bench group with %4d buffers get + put %6.3f us\n",
+            count, (double)time / (MPP_BUFFER_BENCH_LOOP * MPP_BUFFER_BENCH_HOLD));
+
+DONE:
+    if (group)
+        mpp_buffer_group_put(group);
+
+    MPP_FREE(ptr);
+
+    return ret;
+}
 
 int main()
 {
@@ -255,6 +333,12 @@ int main()
 
     mpp_env_set_u32("mpp_buffer_debug", 0);
 
+    for (i = 16; i <= 1024; i *= 4) {
+        ret = mpp_buffer_bench(i);
+        if (ret)
+            break;
+    }
+
     return ret;
 
 MPP_BUFFER_failed:
@@ -16,6 +16,8 @@
 
 #define MODULE_TAG "mpp_enc_cfg_test"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_time.h"
@@ -24,6 +26,113 @@
 #include "rk_venc_cfg.h"
 #include "mpp_enc_cfg_impl.h"
 
+#define KEY_BENCH_LOOP      100000
+
+/* rate control items an application may update on each frame */
+static const char *key_names[] = {
+    "rc:bps_target",
+    "rc:bps_max",
+    "rc:bps_min",
+    "rc:qp_init",
+    "rc:qp_min",
+    "rc:qp_max",
+    "rc:qp_min_i",
+    "rc:qp_max_i",
+};
+
+/*
+ * Set the items by name, by key and by batch on three configs, check the
+ * configs are the same including the change flags and time the three ways.
+ */
+static MPP_RET test_cfg_key(void)
+{
+    MppEncCfgKey keys[MPP_ARRAY_ELEMS(key_names)];
+    MppEncCfgKeyVal kv[MPP_ARRAY_ELEMS(key_names)];
+    MppEncCfg cfgs[3] = { NULL, NULL, NULL };
+    RK_S64 times[3] = { 0, 0, 0 };
+    MPP_RET ret = MPP_NOK;
+    RK_S32 val = 0;
+    RK_U32 i, j;
+    RK_S32 k;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(key_names); i++) {
+        if (mpp_enc_cfg_get_key(key_names[i], &keys[i]))
+            goto DONE;
+        kv[i].key = keys[i];
+    }
+
+    if (!mpp_enc_cfg_get_key("rc:not_exist", &keys[0])) {
+        mpp_err("invalid name should not get key\n");
+        goto DONE;
+    }
+    keys[0] = kv[0].key;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(cfgs); i++) {
+        if (mpp_enc_cfg_init(&cfgs[i]))
+            goto DONE;
+    }
+
+    /* type mismatch should be rejected as the name access */
+    if (!mpp_enc_cfg_set_s64_by_key(cfgs[0], keys[0], 1) ||
+        !mpp_enc_cfg_set_s32_by_key(cfgs[0], &val, 1)) {
+        mpp_err("invalid key access should fail\n");
+        goto DONE;
+    }
+
+    for (k = 0; k < KEY_BENCH_LOOP; k++) {
+        RK_S64 start;
+
+        start = mpp_time();
+        for (i = 0; i < MPP_ARRAY_ELEMS(key_names); i++)
+            mpp_enc_cfg_set_s32(cfgs[0], key_names[i], k + i);
+        times[0] += mpp_time() - start;
+
+        start = mpp_time();
+        for (i = 0; i < MPP_ARRAY_ELEMS(key_names); i++)
+            mpp_enc_cfg_set_s32_by_key(cfgs[1], keys[i], k + i);
+        times[1] += mpp_time() - start;
+
+        start = mpp_time();
+        for (i = 0; i < MPP_ARRAY_ELEMS(key_names); i++)
+            kv[i].val.s32 = k + i;
+        mpp_enc_cfg_set_batch(cfgs[2], kv, MPP_ARRAY_ELEMS(kv));
+        times[2] += mpp_time() - start;
+    }
+
+    for (i = 1; i < MPP_ARRAY_ELEMS(cfgs); i++) {
+        MppEncCfgImpl *ref = (MppEncCfgImpl *)cfgs[0];
+        MppEncCfgImpl *cmp = (MppEncCfgImpl *)cfgs[i];
+
+        if (memcmp(&ref->cfg, &cmp->cfg, sizeof(ref->cfg))) {
+            mpp_err("config %d mismatch with name access\n", i);
+            goto DONE;
+        }
+    }
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(key_names); i++) {
+        mpp_enc_cfg_get_s32_by_key(cfgs[1], keys[i], &val);
+        if (val != KEY_BENCH_LOOP - 1 + (RK_S32)i) {
+            mpp_err("get %s by key %d mismatch\n", key_names[i], val);
+            goto DONE;
+        }
+    }
+
+    for (j = 0; j < MPP_ARRAY_ELEMS(times); j++)
+        mpp_log("set %d rc items by %-5s %.3f us per frame\n",
+                MPP_ARRAY_ELEMS(key_names), j == 0 ? "name" : j == 1 ? "key" : "batch",
+                (double)times[j] / KEY_BENCH_LOOP);
+
+    ret = MPP_OK;
+
+DONE:
+    for (i = 0; i < MPP_ARRAY_ELEMS(cfgs); i++) {
+        if (cfgs[i])
+            mpp_enc_cfg_deinit(cfgs[i]);
+    }
+
+    return ret;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
@@ -97,6 +206,13 @@ int main()
             aq_thrd_i_ret[8], aq_thrd_i_ret[9], aq_thrd_i_ret[10], aq_thrd_i_ret[11],
             aq_thrd_i_ret[12], aq_thrd_i_ret[13], aq_thrd_i_ret[14], aq_thrd_i_ret[15]);
 
+    ret = test_cfg_key();
+    if (ret) {
+        mpp_err("config key test failed\n");
+        mpp_enc_cfg_deinit(cfg);
+        goto DONE;
+    }
+
     ret = mpp_enc_cfg_deinit(cfg);
     if (ret) {
         mpp_err("mpp_enc_cfg_deinit failed\n");
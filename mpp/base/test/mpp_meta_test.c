@@ -121,6 +121,63 @@ void *meta_test(void *param)
     return NULL;
 }
 
+/* encoder alike per-frame usage: a few keys set and a dozen keys queried */
+static RK_S32 meta_frame_test(void)
+{
+    RK_S32 loop_max = LOOP_MAX * 10;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    MppMeta meta = NULL;
+    MppBuffer buffer;
+    RK_S64 sse;
+    void *ptr;
+    RK_S32 val;
+    RK_S32 ret = MPP_OK;
+    RK_S32 i;
+
+    time_start = mpp_time();
+
+    for (i = 0; i < loop_max; i++) {
+        mpp_meta_get(&meta);
+
+        mpp_meta_set_s32(meta, KEY_ENC_FRAME_QP, i);
+        mpp_meta_set_ptr(meta, KEY_ROI_DATA, &val);
+
+        if (mpp_meta_get_s32(meta, KEY_ENC_FRAME_QP, &val) || val != i)
+            ret = MPP_NOK;
+        if (mpp_meta_get_ptr(meta, KEY_ROI_DATA, &ptr) || ptr != &val)
+            ret = MPP_NOK;
+        /* value is consumed by get */
+        if (!mpp_meta_get_s32(meta, KEY_ENC_FRAME_QP, &val))
+            ret = MPP_NOK;
+
+        mpp_meta_get_ptr(meta, KEY_ROI_DATA2, &ptr);
+        mpp_meta_get_ptr(meta, KEY_OSD_DATA, &ptr);
+        mpp_meta_get_ptr(meta, KEY_OSD_DATA2, &ptr);
+        mpp_meta_get_buffer(meta, KEY_QPMAP0, &buffer);
+        mpp_meta_get_s32(meta, KEY_ENC_MARK_LTR, &val);
+        mpp_meta_get_s32(meta, KEY_ENC_USE_LTR, &val);
+        mpp_meta_get_s64(meta, KEY_ENC_SSE, &sse);
+        mpp_meta_get_s32(meta, KEY_LVL64_INTER_NUM, &val);
+        mpp_meta_get_s32(meta, KEY_LVL32_INTER_NUM, &val);
+        mpp_meta_get_s32(meta, KEY_LVL16_INTRA_NUM, &val);
+        mpp_meta_get_s32(meta, KEY_LVL8_INTRA_NUM, &val);
+        mpp_meta_get_s32(meta, KEY_OUTPUT_PSKIP, &val);
+
+        if (mpp_meta_size(meta))
+            ret = MPP_NOK;
+
+        mpp_meta_put(meta);
+    }
+
+    time_end = mpp_time();
+
+    mpp_log("meta per-frame usage %d loop avg %.1f ns ret %d\n", loop_max,
+            (double)(time_end - time_start) * 1000 / loop_max, ret);
+
+    return ret;
+}
+
 int main()
 {
     pthread_t thds[TEST_MAX];
@@ -135,6 +192,11 @@ int main()
 
     mpp_log("mpp_meta_test start\n");
 
+    if (meta_frame_test()) {
+        mpp_err("mpp_meta_test per-frame usage check failed\n");
+        return -1;
+    }
+
     for (i = 0; i < thd_cnt; i++)
         pthread_create(&thds[i], &attr, meta_test, &times[i]);
 
@@ -17,11 +17,126 @@
 #define MODULE_TAG "mpp_packet_test"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "mpp_log.h"
-#include "mpp_packet.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_time.h"
+#include "mpp_packet_impl.h"
 
 #define MPP_PACKET_TEST_SIZE    1024
+#define MPP_PACKET_COPY_LOOP    10000
+#define MPP_PACKET_COPY_DEPTH   4
+
+static MPP_RET mpp_packet_copy_test(void)
+{
+    static const size_t sizes[] = { 100, 3000, 20000, 150000, 60000, 8000 };
+    MppPacket pkts[MPP_PACKET_COPY_DEPTH];
+    MppPacketPoolStat stat_start;
+    MppPacketPoolStat stat;
+    MppPacket src = NULL;
+    RK_U8 *data = NULL;
+    RK_S64 time_start;
+    RK_S64 time_copy;
+    RK_S64 time_malloc;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    data = mpp_malloc(RK_U8, 150000);
+    if (NULL == data)
+        return MPP_ERR_MALLOC;
+
+    memset(pkts, 0, sizeof(pkts));
+    for (i = 0; i < 150000; i++)
+        data[i] = (RK_U8)i;
+
+    mpp_packet_pool_get_stat(&stat_start);
+
+    /* copy path with a few packets in flight as decoder input queue */
+    for (i = 0; i < MPP_PACKET_COPY_LOOP; i++) {
+        MppPacket *pkt = &pkts[i % MPP_PACKET_COPY_DEPTH];
+        size_t size = sizes[i % MPP_ARRAY_ELEMS(sizes)];
+        RK_U8 *pos;
+
+        if (*pkt)
+            mpp_packet_deinit(pkt);
+
+        mpp_packet_init(&src, data, size);
+        mpp_packet_copy_init(pkt, src);
+        mpp_packet_deinit(&src);
+
+        pos = (RK_U8 *)mpp_packet_get_pos(*pkt);
+        if (NULL == pos || mpp_packet_get_length(*pkt) != size ||
+            memcmp(pos, data, size) || pos[size] || pos[size + 63]) {
+            mpp_err("packet copy %d size %d mismatch\n", i, size);
+            goto DONE;
+        }
+        /* dirty the padding to check zeroing on recycle */
+        memset(pos + size, 0xff, 64);
+    }
+
+    time_start = mpp_time();
+    for (i = 0; i < MPP_PACKET_COPY_LOOP; i++) {
+        MppPacket *pkt = &pkts[i % MPP_PACKET_COPY_DEPTH];
+
+        if (*pkt)
+            mpp_packet_deinit(pkt);
+
+        mpp_packet_init(&src, data, sizes[i % MPP_ARRAY_ELEMS(sizes)]);
+        mpp_packet_copy_init(pkt, src);
+        mpp_packet_deinit(&src);
+    }
+    time_copy = mpp_time() - time_start;
+
+    for (i = 0; i < MPP_PACKET_COPY_DEPTH; i++)
+        if (pkts[i])
+            mpp_packet_deinit(&pkts[i]);
+
+    /* reference of malloc + memset 256 on each copy */
+    time_start = mpp_time();
+    for (i = 0; i < MPP_PACKET_COPY_LOOP; i++) {
+        RK_U8 **buf = (RK_U8 **)&pkts[i % MPP_PACKET_COPY_DEPTH];
+        size_t size = sizes[i % MPP_ARRAY_ELEMS(sizes)];
+
+        MPP_FREE(*buf);
+        *buf = mpp_malloc_size(RK_U8, size + 256);
+        memcpy(*buf, data, size);
+        memset(*buf + size, 0, 256);
+    }
+    time_malloc = mpp_time() - time_start;
+
+    for (i = 0; i < MPP_PACKET_COPY_DEPTH; i++)
+        MPP_FREE(pkts[i]);
+
+    mpp_packet_pool_get_stat(&stat);
+
+    mpp_log("packet copy %d loop pool %lld us malloc %lld us\n",
+            MPP_PACKET_COPY_LOOP, time_copy, time_malloc);
+    mpp_log("pool get %lld hit %lld drop %lld used %d cached %d peak %d limit %d\n",
+            stat.get_count - stat_start.get_count,
+            stat.hit_count - stat_start.hit_count,
+            stat.drop_count - stat_start.drop_count,
+            stat.used_bytes, stat.cached_bytes, stat.peak_bytes,
+            stat.limit_bytes);
+
+    if (stat.used_bytes != stat_start.used_bytes ||
+        stat.cached_bytes > stat.limit_bytes ||
+        stat.get_count - stat_start.get_count != MPP_PACKET_COPY_LOOP * 2 ||
+        stat.hit_count == stat_start.hit_count) {
+        mpp_err("packet pool statistic check failed\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    for (i = 0; i < MPP_PACKET_COPY_DEPTH; i++)
+        if (pkts[i])
+            mpp_packet_deinit(&pkts[i]);
+
+    MPP_FREE(data);
+    return ret;
+}
 
 int main()
 {
@@ -50,6 +165,12 @@ int main()
     }
     mpp_packet_deinit(&packet);
 
+    ret = mpp_packet_copy_test();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_packet_test mpp_packet_copy_test failed\n");
+        goto MPP_PACKET_failed;
+    }
+
     free(data);
     mpp_log("mpp_packet_test success\n");
     return ret;
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_startcode.h"
+
+#define STREAM_SIZE         (32 * 1024 * 1024)
+#define MAX_NALU_SIZE       (256 * 1024)
+#define LOOP_COUNT          4
+/* zero rich stream for checking the candidate path of word scan */
+#define CHECK_STREAM_SIZE   (1024 * 1024)
+#define CHECK_ZERO_RATE     4
+
+/*
+ * generate annexb stream with emulation prevention applied payload
+ * zero_rate - one of zero_rate payload bytes is forced to zero, 0 for none
+ */
+static RK_S32 gen_stream(RK_U8 *buf, RK_S32 size, RK_S32 zero_rate)
+{
+    RK_S32 pos = 0;
+
+    srand(0x264);
+
+    while (pos + 8 < size) {
+        RK_S32 nalu_size = rand() % MAX_NALU_SIZE + 1;
+        RK_S32 zeros = 0;
+        RK_S32 i;
+
+        /* mix of 3 byte and 4 byte start code */
+        if (rand() & 1)
+            buf[pos++] = 0;
+        buf[pos++] = 0;
+        buf[pos++] = 0;
+        buf[pos++] = 1;
+
+        for (i = 0; i < nalu_size && pos < size; i++) {
+            RK_U8 val = (zero_rate && !(rand() % zero_rate)) ? 0 : rand() & 0xff;
+
+            if (zeros >= 2 && val <= 3) {
+                buf[pos++] = 3;
+                zeros = 0;
+                if (pos >= size)
+                    break;
+            }
+            buf[pos++] = val;
+            zeros = val ? 0 : zeros + 1;
+        }
+        /* payload never ends with zero byte */
+        if (pos < size && !buf[pos - 1])
+            buf[pos++] = 0x80;
+    }
+
+    return pos;
+}
+
+/* reference byte-by-byte scanner as h264d parse_prepare does */
+static RK_S32 scan_by_byte(RK_U8 *buf, RK_S32 size, RK_S32 *pos, RK_S32 max)
+{
+    RK_U32 prefix = 0xffffffff;
+    RK_S32 cnt = 0;
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        prefix = (prefix << 8) | buf[i];
+        if ((prefix & 0x00FFFFFF) == 0x00000001) {
+            if (cnt < max)
+                pos[cnt] = i;
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+/* word scanner fed in chunks of random size to cover split start codes */
+static RK_S32 scan_by_word(RK_U8 *buf, RK_S32 size, RK_S32 *pos, RK_S32 max,
+                           RK_S32 chunk)
+{
+    RK_U32 prefix = 0xffffffff;
+    RK_S32 cnt = 0;
+    RK_S32 start = 0;
+
+    while (start < size) {
+        RK_S32 len = chunk ? MPP_MIN(size - start, rand() % chunk + 1) : size - start;
+        RK_S32 found = mpp_find_start_code(buf + start, len, prefix);
+        RK_S32 used = (found >= 0) ? found + 1 : len;
+        RK_S32 i;
+
+        if (found >= 0) {
+            if (cnt < max)
+                pos[cnt] = start + found;
+            cnt++;
+        }
+
+        for (i = (used > 4) ? used - 4 : 0; i < used; i++)
+            prefix = (prefix << 8) | buf[start + i];
+
+        start += used;
+    }
+
+    return cnt;
+}
+
+static RK_S32 check_stream(RK_U8 *buf, RK_S32 size, RK_S32 *pos_ref,
+                           RK_S32 *pos_new, RK_S32 max)
+{
+    RK_S32 cnt_ref = scan_by_byte(buf, size, pos_ref, max);
+    RK_S32 cnt_new;
+    RK_S32 i;
+
+    for (i = 1; i <= 64; i <<= 1) {
+        cnt_new = scan_by_word(buf, size, pos_new, max, i);
+        if (cnt_new != cnt_ref ||
+            memcmp(pos_ref, pos_new, sizeof(RK_S32) * MPP_MIN(cnt_ref, max))) {
+            mpp_err("chunk %d mismatch start code count %d vs %d\n", i, cnt_new, cnt_ref);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static RK_S32 load_file(const char *name, RK_U8 **buf)
+{
+    FILE *fp = fopen(name, "rb");
+    RK_S32 size = 0;
+
+    if (!fp) {
+        mpp_err("failed to open %s\n", name);
+        return 0;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    *buf = mpp_malloc(RK_U8, size);
+    if (*buf)
+        size = fread(*buf, 1, size, fp);
+    else
+        size = 0;
+
+    fclose(fp);
+    return size;
+}
+
+int main(int argc, char **argv)
+{
+    RK_U8 *buf = NULL;
+    RK_S32 *pos_ref = NULL;
+    RK_S32 *pos_new = NULL;
+    RK_S32 max_pos = 0;
+    RK_S32 size = 0;
+    RK_S32 cnt_ref = 0;
+    RK_S32 cnt_new = 0;
+    RK_S64 time_ref = 0;
+    RK_S64 time_new = 0;
+    RK_S64 start;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpp_startcode_test start\n");
+
+    if (argc > 1) {
+        size = load_file(argv[1], &buf);
+    } else {
+        buf = mpp_malloc(RK_U8, STREAM_SIZE);
+        if (buf)
+            size = STREAM_SIZE;
+    }
+
+    if (!size) {
+        mpp_err("no input stream\n");
+        ret = -1;
+        goto DONE;
+    }
+
+    max_pos = size / 3 + 1;
+    pos_ref = mpp_malloc(RK_S32, max_pos);
+    pos_new = mpp_malloc(RK_S32, max_pos);
+    if (!pos_ref || !pos_new) {
+        ret = -1;
+        goto DONE;
+    }
+
+    /* check start code positions with random chunk split */
+    if (argc <= 1) {
+        RK_S32 check_size = gen_stream(buf, CHECK_STREAM_SIZE, CHECK_ZERO_RATE);
+
+        ret = check_stream(buf, check_size, pos_ref, pos_new, max_pos);
+        if (ret)
+            goto DONE;
+
+        size = gen_stream(buf, STREAM_SIZE, 0);
+    }
+
+    ret = check_stream(buf, size, pos_ref, pos_new, max_pos);
+    if (ret)
+        goto DONE;
+
+    for (i = 0; i < LOOP_COUNT; i++) {
+        start = mpp_time();
+        cnt_ref = scan_by_byte(buf, size, pos_ref, max_pos);
+        time_ref += mpp_time() - start;
+
+        start = mpp_time();
+        cnt_new = scan_by_word(buf, size, pos_new, max_pos, 0);
+        time_new += mpp_time() - start;
+    }
+
+    if (cnt_new != cnt_ref) {
+        mpp_err("mismatch start code count %d vs %d\n", cnt_new, cnt_ref);
+        ret = -1;
+        goto DONE;
+    }
+
+    mpp_log("stream size %d start code %d\n", size, cnt_ref);
+    mpp_log("byte scan %8.2f MB/s\n", (double)size * LOOP_COUNT / MPP_MAX(time_ref, 1));
+    mpp_log("word scan %8.2f MB/s\n", (double)size * LOOP_COUNT / MPP_MAX(time_new, 1));
+
+DONE:
+    MPP_FREE(buf);
+    MPP_FREE(pos_ref);
+    MPP_FREE(pos_new);
+
+    mpp_log("mpp_startcode_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
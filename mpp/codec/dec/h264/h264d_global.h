@@ -924,6 +924,8 @@ typedef struct h264d_curstrm_t {
     RK_S32    nalu_type;
     RK_U32    nalu_len;
     RK_U8     *nalu_buf;         //!< store read nalu data
+    RK_U32    nalu_start;        //!< offset of nalu first byte in input stream
+    RK_U8     *nalu_ref;         //!< nalu data referenced in input stream, no copy to nalu_buf
 
     RK_U32    head_offset;
     RK_U32    head_max_size;
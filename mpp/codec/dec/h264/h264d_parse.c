@@ -22,6 +22,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_dec_task.h"
 
 #include "h264d_global.h"
@@ -129,11 +130,17 @@ static void reset_nalu(H264dCurStream_t *p_strm)
     if (p_strm->endcode_found) {
         p_strm->startcode_found = p_strm->endcode_found;
         p_strm->nalu_len = 0;
+        p_strm->nalu_ref = NULL;
         p_strm->nalu_type = H264_NALU_TYPE_NULL;
         p_strm->endcode_found = 0;
     }
 }
 
+static RK_U8 *get_nalu_data(H264dCurStream_t *p_strm)
+{
+    return p_strm->nalu_ref ? p_strm->nalu_ref : p_strm->nalu_buf;
+}
+
 static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
 {
     (void)p_data;
@@ -147,6 +154,63 @@ static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
     }
 }
 
+/*!
+***********************************************************************
+* \brief
+*    consume input up to the next start code in one step
+*
+*    The per-byte loop is kept for the nalu header bytes which have to be
+*    checked by judge_is_new_frame. Afterwards the input is scanned by word
+*    for the next start code and the whole payload is copied at once. The
+*    stream state is the same as byte-by-byte consuming.
+*
+*    When the whole nalu is inside of current input stream it is referenced
+*    by nalu_ref without copy. The data is consumed by store_cur_nalu before
+*    the input packet is released.
+***********************************************************************
+*/
+static MPP_RET scan_nalu_bulk(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    MppPacketImpl *pkt_impl = (MppPacketImpl *)p_Inp->in_pkt;
+    RK_U8 *src = &p_Inp->in_buf[p_strm->nalu_offset];
+    RK_U32 size = (RK_U32)pkt_impl->length;
+    RK_S32 pos = mpp_find_start_code(src, (RK_S32)size, p_strm->prefixdata);
+    RK_U32 i;
+
+    if (pos >= 0)
+        size = pos + 1;
+
+    if (p_strm->startcode_found && pos >= 0 &&
+        p_strm->nalu_start + p_strm->nalu_len == p_strm->nalu_offset) {
+        p_strm->nalu_ref = &p_Inp->in_buf[p_strm->nalu_start];
+        p_strm->nalu_len += size;
+    } else if (p_strm->startcode_found) {
+        if (p_strm->nalu_len + size > p_strm->nalu_max_size) {
+            RK_U32 add_size = p_strm->nalu_len + size - p_strm->nalu_max_size;
+
+            FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size,
+                                           MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+        }
+        memcpy(&p_strm->nalu_buf[p_strm->nalu_len], src, size);
+        p_strm->nalu_len += size;
+    }
+
+    for (i = (size > 4) ? (size - 4) : 0; i < size; i++)
+        p_strm->prefixdata = (p_strm->prefixdata << 8) | src[i];
+
+    p_strm->curdata = &src[size - 1];
+    p_strm->nalu_offset += size;
+    pkt_impl->length -= size;
+
+    if (pos >= 0)
+        find_prefix_code(p_strm->curdata, p_strm);
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -340,6 +404,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     RK_U8 *p_des = NULL;
+    RK_U8 *p_src = get_nalu_data(p_strm);
 
     //!< fill head buffer
     if (   (p_strm->nalu_type == H264_NALU_TYPE_SLICE)
@@ -370,7 +435,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
         ((H264dNaluHead_t *)p_des)->is_frame_end  = 0;
         ((H264dNaluHead_t *)p_des)->nalu_type = p_strm->nalu_type;
         ((H264dNaluHead_t *)p_des)->sodb_len = head_size;
-        memcpy(p_des + sizeof(H264dNaluHead_t), p_strm->nalu_buf, head_size);
+        memcpy(p_des + sizeof(H264dNaluHead_t), p_src, head_size);
         p_strm->head_offset += add_size;
 
         H264D_LOG("store current header, NAL type %d", p_strm->nalu_type);
@@ -402,7 +467,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 
         p_des = &dxva_ctx->bitstream[dxva_ctx->strm_offset];
         memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-        memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+        memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
         dxva_ctx->strm_offset += add_size;
     }
     if (h264d_debug & H264D_DBG_WRITE_ES_EN) {
@@ -412,7 +477,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
             if (p_Inp->spspps_update_flag) {
                 p_des = &p_Inp->spspps_buf[p_Inp->spspps_offset];
                 memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-                memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+                memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
                 p_Inp->spspps_offset += p_strm->nalu_len + sizeof(g_start_precode);
                 p_Inp->spspps_len = p_Inp->spspps_offset;
             }
@@ -629,6 +694,10 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     }
 
     while (pkt_impl->length > 0) {
+        if (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH) {
+            FUN_CHECK(ret = scan_nalu_bulk(p_Inp, p_strm));
+            goto __CHECK_END;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -636,6 +705,8 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
             if (p_strm->nalu_len >= p_strm->nalu_max_size) {
                 FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
             }
+            if (!p_strm->nalu_len)
+                p_strm->nalu_start = p_strm->nalu_offset - 1;
             p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
             if ((p_strm->nalu_len == NALU_TYPE_NORMAL_LENGTH)
                 || (p_strm->nalu_len == NALU_TYPE_EXT_LENGTH)) {
@@ -657,11 +728,14 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
 
         find_prefix_code(p_strm->curdata, p_strm);
 
+    __CHECK_END:
         if (p_strm->endcode_found) {
             p_strm->nalu_len -= START_PREFIX_3BYTE;
             if (p_strm->nalu_len > START_PREFIX_3BYTE) {
+                RK_U8 *nalu = get_nalu_data(p_strm);
+
                 while ((p_strm->nalu_len > 0) &&
-                       (p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00)) {
+                       (nalu[p_strm->nalu_len - 1] == 0x00)) {
                     p_strm->nalu_len--;
                 }
             }
@@ -711,6 +785,10 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->task_valid = 0;
 
     while (pkt_impl->length > 0) {
+        if (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_NORMAL_LENGTH) {
+            FUN_CHECK(ret = scan_nalu_bulk(p_Inp, p_strm));
+            goto __CHECK_END;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -718,6 +796,8 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
             if (p_strm->nalu_len >= p_strm->nalu_max_size) {
                 FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
             }
+            if (!p_strm->nalu_len)
+                p_strm->nalu_start = p_strm->nalu_offset - 1;
             p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
             if (p_strm->nalu_len == 1) {
                 p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
@@ -728,12 +808,9 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
                     if (p_strm->nalu_type == H264_NALU_TYPE_SLC_EXT)
                         p_strm->nalu_type = H264_NALU_TYPE_SLICE;
 
+                    /* slice data is the rest of packet, reference it in place */
                     p_strm->nalu_len += (RK_U32)pkt_impl->length;
-                    if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                        RK_U32 add_size =  pkt_impl->length + 1 - p_strm->nalu_max_size;
-                        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
-                    }
-                    memcpy(&p_strm->nalu_buf[0], p_strm->curdata, pkt_impl->length + 1);
+                    p_strm->nalu_ref = p_strm->curdata;
                     pkt_impl->length = 0;
                     p_Cur->p_Inp->task_valid = 1;
                     break;
@@ -743,9 +820,12 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
 
         find_prefix_code(p_strm->curdata, p_strm);
 
+    __CHECK_END:
         if (p_strm->endcode_found) {
+            RK_U8 *nalu = get_nalu_data(p_strm);
+
             p_strm->nalu_len -= START_PREFIX_3BYTE;
-            while (p_strm->nalu_len > 0 && p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00) {
+            while (p_strm->nalu_len > 0 && nalu[p_strm->nalu_len - 1] == 0x00) {
                 p_strm->nalu_len--;
             }
             p_Dec->nalu_ret = EndOfNalu;
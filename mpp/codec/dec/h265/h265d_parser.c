@@ -1478,60 +1478,53 @@ fail:
 }
 
 
-typedef union {
-    RK_U32  u32;
-    RK_U16  u16[2];
-    RK_U8   u8 [4];
-    float   f32;
-} mpp_alias32;
+#define WORD_ONES       0x0101010101010101ULL
+#define WORD_HIGHS      0x8080808080808080ULL
 
-#define MPP_FAST_UNALIGNED 1
+/* non-zero when any byte in the word is zero */
+#define WORD_HAS_ZERO(x)    (((x) - WORD_ONES) & ~(x) & WORD_HIGHS)
 
-
-#ifndef MPP_RN32A
-#define MPP_RN32A(p) (((const mpp_alias32*)(p))->u32)
-#endif
-RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
-                             HEVCNAL *nal)
+/*
+ * Return the length of the nal unit at src which ends before the first
+ * 00 00 00 or 00 00 01 sequence or at the end of the buffer.
+ *
+ * The sequence always begins with a zero byte so eight byte words without
+ * zero byte are skipped as a whole. The word is loaded by memcpy to avoid
+ * unaligned access fault.
+ */
+static RK_S32 hevc_nal_length(const RK_U8 *src, RK_S32 length)
 {
-    RK_S32 i;
+    RK_S32 i = 0;
 
-    s->skipped_bytes = 0;
+    for (; i + 10 <= length; i += 8) {
+        const RK_U8 *p = src + i;
+        RK_U64 word;
+        RK_S32 k;
+
+        memcpy(&word, p, sizeof(word));
+        if (!WORD_HAS_ZERO(word))
+            continue;
 
-#define STARTCODE_TEST                                              \
-    if (i + 2 < length && src[i + 1] == 0 && src[i + 2] < 2) {      \
-            /* startcode, so we must be past the end */             \
-        length = i;                                                 \
-        break;                                                      \
+        for (k = 0; k < 8; k++) {
+            if (!p[k] && !p[k + 1] && p[k + 2] < 2)
+                return i + k;
+        }
     }
 
-#if MPP_FAST_UNALIGNED
-#define FIND_FIRST_ZERO                                             \
-    if (i > 0 && !src[i])                                           \
-        i--;                                                        \
-    while (src[i])                                                  \
-        i++
+    for (; i + 2 < length; i++) {
+        if (!src[i] && !src[i + 1] && src[i + 2] < 2)
+            return i;
+    }
 
-    for (i = 0; i + 1 < length; i += 5) {
-        if (!((~MPP_RN32A(src + i) &
-               (MPP_RN32A(src + i) - 0x01000101U)) &
-              0x80008080U))
-            continue;
+    return length;
+}
 
-        FIND_FIRST_ZERO;
+RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
+                             HEVCNAL *nal)
+{
+    s->skipped_bytes = 0;
 
-        STARTCODE_TEST;
-        i -= 3;
-    }
-#else
-    for (i = 0; i + 1 < length; i += 2) {
-        if (src[i])
-            continue;
-        if (i > 0 && src[i - 1] == 0)
-            i--;
-        STARTCODE_TEST;
-    }
-#endif
+    length = hevc_nal_length(src, length);
 
     if (length + MPP_INPUT_BUFFER_PADDING_SIZE > nal->rbsp_buffer_size) {
         RK_S32 min_size = length + MPP_INPUT_BUFFER_PADDING_SIZE;
@@ -1643,7 +1636,19 @@ static RK_S32 split_nal_units(HEVCContext *s, RK_U8 *buf, RK_U32 length)
         }
         nal = &s->nals[s->nb_nals];
 
-        consumed = mpp_hevc_extract_rbsp(s, buf, extract_length, nal);
+        /*
+         * The slice nal is only read for its header before it is copied to
+         * the stream buffer by h265d_syntax_fill_slice in the same prepare
+         * call or parsed at once for extradata. So it is referenced in place
+         * instead of being copied to the rbsp buffer and fill_slice points it
+         * to the stream buffer copy which is kept until parse.
+         */
+        if (((buf[0] >> 1) & 0x3f) < 32) {
+            consumed = hevc_nal_length(buf, extract_length);
+            nal->data = buf;
+            nal->size = consumed;
+        } else
+            consumed = mpp_hevc_extract_rbsp(s, buf, extract_length, nal);
 
         if (consumed <= 0) {
             ret = MPP_ERR_STREAM;
@@ -0,0 +1,473 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h265d_parser_test"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_packet.h"
+#include "mpp_buf_slot.h"
+#include "mpp_dec_cfg.h"
+#include "hal_dec_task.h"
+#include "h265d_api.h"
+
+/*
+ * Parser benchmark on a generated 1920x1088 stream with one IDR and then
+ * P frames. Each frame is split into a configurable number of slices with
+ * random payload. The stream buffer produced by prepare is checked against
+ * the generated slices and the prepare + parse time per frame is reported.
+ */
+#define TEST_WIDTH          1920
+#define TEST_HEIGHT         1088
+#define TEST_CTB_COUNT      ((TEST_WIDTH / 64) * (TEST_HEIGHT / 64))
+#define TEST_ADDR_BITS      9
+#define TEST_FRAMES         300
+#define TEST_GOP            30
+#define TEST_FRAME_SIZE     (64 * 1024)
+#define TEST_RBSP_SIZE      (TEST_FRAME_SIZE + 1024)
+
+typedef struct BitWriter_t {
+    RK_U8       *buf;
+    RK_S32      bitpos;
+} BitWriter;
+
+typedef struct TestStream_t {
+    RK_U8       *buf;
+    RK_S32      size;
+    /* frame boundary in buf */
+    RK_S32      *frame_pos;
+    /* start code prefixed slices of each frame as the stream buffer should be */
+    RK_U8       *slices;
+    RK_S32      *slices_pos;
+} TestStream;
+
+static RK_U32 rand_seed = 1;
+
+static RK_U32 test_rand(void)
+{
+    rand_seed = rand_seed * 1103515245 + 12345;
+    return rand_seed >> 16;
+}
+
+static void bw_init(BitWriter *bw, RK_U8 *buf, RK_S32 size)
+{
+    memset(buf, 0, size);
+    bw->buf = buf;
+    bw->bitpos = 0;
+}
+
+static void bw_put(BitWriter *bw, RK_U32 val, RK_S32 bits)
+{
+    while (bits--) {
+        if ((val >> bits) & 1)
+            bw->buf[bw->bitpos >> 3] |= 0x80 >> (bw->bitpos & 7);
+        bw->bitpos++;
+    }
+}
+
+static void bw_put_ue(BitWriter *bw, RK_U32 val)
+{
+    RK_S32 len = 0;
+    RK_U32 tmp = val + 1;
+
+    while (tmp >> len)
+        len++;
+
+    bw_put(bw, 0, len - 1);
+    bw_put(bw, val + 1, len);
+}
+
+static void bw_put_se(BitWriter *bw, RK_S32 val)
+{
+    bw_put_ue(bw, val > 0 ? 2 * val - 1 : -2 * val);
+}
+
+static RK_S32 bw_trailing(BitWriter *bw)
+{
+    bw_put(bw, 1, 1);
+    while (bw->bitpos & 7)
+        bw_put(bw, 0, 1);
+
+    return bw->bitpos >> 3;
+}
+
+static void put_profile_tier_level(BitWriter *bw)
+{
+    bw_put(bw, 0, 2);           /* general_profile_space */
+    bw_put(bw, 0, 1);           /* general_tier_flag */
+    bw_put(bw, 1, 5);           /* general_profile_idc main */
+    bw_put(bw, 0x60000000, 32); /* general_profile_compatibility_flag */
+    bw_put(bw, 1, 1);           /* general_progressive_source_flag */
+    bw_put(bw, 0, 1);           /* general_interlaced_source_flag */
+    bw_put(bw, 0, 1);           /* general_non_packed_constraint_flag */
+    bw_put(bw, 1, 1);           /* general_frame_only_constraint_flag */
+    bw_put(bw, 0, 32);          /* general_reserved_zero_44bits */
+    bw_put(bw, 0, 12);
+    bw_put(bw, 120, 8);         /* general_level_idc 4.0 */
+}
+
+/* write nal with start code and emulation prevention */
+static RK_S32 put_nal(RK_U8 *dst, const RK_U8 *rbsp, RK_S32 size)
+{
+    RK_S32 zeros = 0;
+    RK_S32 pos = 0;
+    RK_S32 i;
+
+    dst[pos++] = 0;
+    dst[pos++] = 0;
+    dst[pos++] = 1;
+
+    for (i = 0; i < size; i++) {
+        if (zeros >= 2 && rbsp[i] <= 3) {
+            dst[pos++] = 3;
+            zeros = 0;
+        }
+        dst[pos++] = rbsp[i];
+        zeros = rbsp[i] ? 0 : zeros + 1;
+    }
+
+    return pos;
+}
+
+static RK_S32 gen_vps(BitWriter *bw)
+{
+    bw_put(bw, 32 << 1, 8);     /* nal header */
+    bw_put(bw, 1, 8);
+    bw_put(bw, 0, 4);           /* vps_video_parameter_set_id */
+    bw_put(bw, 3, 2);           /* vps_base_layer_internal/available_flag */
+    bw_put(bw, 0, 6);           /* vps_max_layers_minus1 */
+    bw_put(bw, 0, 3);           /* vps_max_sub_layers_minus1 */
+    bw_put(bw, 1, 1);           /* vps_temporal_id_nesting_flag */
+    bw_put(bw, 0xffff, 16);     /* vps_reserved_0xffff_16bits */
+    put_profile_tier_level(bw);
+    bw_put(bw, 1, 1);           /* vps_sub_layer_ordering_info_present_flag */
+    bw_put_ue(bw, 4);           /* vps_max_dec_pic_buffering_minus1 */
+    bw_put_ue(bw, 0);           /* vps_max_num_reorder_pics */
+    bw_put_ue(bw, 0);           /* vps_max_latency_increase_plus1 */
+    bw_put(bw, 0, 6);           /* vps_max_layer_id */
+    bw_put_ue(bw, 0);           /* vps_num_layer_sets_minus1 */
+    bw_put(bw, 0, 1);           /* vps_timing_info_present_flag */
+    bw_put(bw, 0, 1);           /* vps_extension_flag */
+
+    return bw_trailing(bw);
+}
+
+static RK_S32 gen_sps(BitWriter *bw)
+{
+    bw_put(bw, 33 << 1, 8);
+    bw_put(bw, 1, 8);
+    bw_put(bw, 0, 4);           /* sps_video_parameter_set_id */
+    bw_put(bw, 0, 3);           /* sps_max_sub_layers_minus1 */
+    bw_put(bw, 1, 1);           /* sps_temporal_id_nesting_flag */
+    put_profile_tier_level(bw);
+    bw_put_ue(bw, 0);           /* sps_seq_parameter_set_id */
+    bw_put_ue(bw, 1);           /* chroma_format_idc */
+    bw_put_ue(bw, TEST_WIDTH);
+    bw_put_ue(bw, TEST_HEIGHT);
+    bw_put(bw, 0, 1);           /* conformance_window_flag */
+    bw_put_ue(bw, 0);           /* bit_depth_luma_minus8 */
+    bw_put_ue(bw, 0);           /* bit_depth_chroma_minus8 */
+    bw_put_ue(bw, 4);           /* log2_max_pic_order_cnt_lsb_minus4 */
+    bw_put(bw, 1, 1);           /* sps_sub_layer_ordering_info_present_flag */
+    bw_put_ue(bw, 4);           /* sps_max_dec_pic_buffering_minus1 */
+    bw_put_ue(bw, 0);           /* sps_max_num_reorder_pics */
+    bw_put_ue(bw, 0);           /* sps_max_latency_increase_plus1 */
+    bw_put_ue(bw, 0);           /* log2_min_luma_coding_block_size_minus3 */
+    bw_put_ue(bw, 3);           /* log2_diff_max_min_luma_coding_block_size */
+    bw_put_ue(bw, 0);           /* log2_min_luma_transform_block_size_minus2 */
+    bw_put_ue(bw, 3);           /* log2_diff_max_min_luma_transform_block_size */
+    bw_put_ue(bw, 1);           /* max_transform_hierarchy_depth_inter */
+    bw_put_ue(bw, 1);           /* max_transform_hierarchy_depth_intra */
+    bw_put(bw, 0, 1);           /* scaling_list_enabled_flag */
+    bw_put(bw, 1, 1);           /* amp_enabled_flag */
+    bw_put(bw, 0, 1);           /* sample_adaptive_offset_enabled_flag */
+    bw_put(bw, 0, 1);           /* pcm_enabled_flag */
+    bw_put_ue(bw, 1);           /* num_short_term_ref_pic_sets */
+    bw_put_ue(bw, 1);           /* num_negative_pics */
+    bw_put_ue(bw, 0);           /* num_positive_pics */
+    bw_put_ue(bw, 0);           /* delta_poc_s0_minus1 */
+    bw_put(bw, 1, 1);           /* used_by_curr_pic_s0_flag */
+    bw_put(bw, 0, 1);           /* long_term_ref_pics_present_flag */
+    bw_put(bw, 0, 1);           /* sps_temporal_mvp_enabled_flag */
+    bw_put(bw, 1, 1);           /* strong_intra_smoothing_enabled_flag */
+    bw_put(bw, 0, 1);           /* vui_parameters_present_flag */
+    bw_put(bw, 0, 1);           /* sps_extension_present_flag */
+
+    return bw_trailing(bw);
+}
+
+static RK_S32 gen_pps(BitWriter *bw)
+{
+    bw_put(bw, 34 << 1, 8);
+    bw_put(bw, 1, 8);
+    bw_put_ue(bw, 0);           /* pps_pic_parameter_set_id */
+    bw_put_ue(bw, 0);           /* pps_seq_parameter_set_id */
+    bw_put(bw, 0, 1);           /* dependent_slice_segments_enabled_flag */
+    bw_put(bw, 0, 1);           /* output_flag_present_flag */
+    bw_put(bw, 0, 3);           /* num_extra_slice_header_bits */
+    bw_put(bw, 0, 1);           /* sign_data_hiding_enabled_flag */
+    bw_put(bw, 0, 1);           /* cabac_init_present_flag */
+    bw_put_ue(bw, 0);           /* num_ref_idx_l0_default_active_minus1 */
+    bw_put_ue(bw, 0);           /* num_ref_idx_l1_default_active_minus1 */
+    bw_put_se(bw, 0);           /* init_qp_minus26 */
+    bw_put(bw, 0, 1);           /* constrained_intra_pred_flag */
+    bw_put(bw, 0, 1);           /* transform_skip_enabled_flag */
+    bw_put(bw, 0, 1);           /* cu_qp_delta_enabled_flag */
+    bw_put_se(bw, 0);           /* pps_cb_qp_offset */
+    bw_put_se(bw, 0);           /* pps_cr_qp_offset */
+    bw_put(bw, 0, 1);           /* pps_slice_chroma_qp_offsets_present_flag */
+    bw_put(bw, 0, 1);           /* weighted_pred_flag */
+    bw_put(bw, 0, 1);           /* weighted_bipred_flag */
+    bw_put(bw, 0, 1);           /* transquant_bypass_enabled_flag */
+    bw_put(bw, 0, 1);           /* tiles_enabled_flag */
+    bw_put(bw, 0, 1);           /* entropy_coding_sync_enabled_flag */
+    bw_put(bw, 0, 1);           /* pps_loop_filter_across_slices_enabled_flag */
+    bw_put(bw, 0, 1);           /* deblocking_filter_control_present_flag */
+    bw_put(bw, 0, 1);           /* pps_scaling_list_data_present_flag */
+    bw_put(bw, 0, 1);           /* lists_modification_present_flag */
+    bw_put_ue(bw, 0);           /* log2_parallel_merge_level_minus2 */
+    bw_put(bw, 0, 1);           /* slice_segment_header_extension_present_flag */
+    bw_put(bw, 0, 1);           /* pps_extension_present_flag */
+
+    return bw_trailing(bw);
+}
+
+static RK_S32 gen_slice(BitWriter *bw, RK_S32 frame, RK_S32 slice,
+                        RK_S32 slice_num, RK_S32 payload)
+{
+    RK_S32 idr = !(frame % TEST_GOP);
+    RK_S32 size;
+    RK_S32 i;
+
+    bw_put(bw, (idr ? 19 : 1) << 1, 8);
+    bw_put(bw, 1, 8);
+    bw_put(bw, !slice, 1);      /* first_slice_segment_in_pic_flag */
+    if (idr)
+        bw_put(bw, 0, 1);       /* no_output_of_prior_pics_flag */
+    bw_put_ue(bw, 0);           /* slice_pic_parameter_set_id */
+    if (slice)
+        bw_put(bw, slice * TEST_CTB_COUNT / slice_num, TEST_ADDR_BITS);
+    bw_put_ue(bw, idr ? 2 : 1); /* slice_type */
+    if (!idr) {
+        bw_put(bw, (frame % TEST_GOP) & 0xff, 8);   /* slice_pic_order_cnt_lsb */
+        bw_put(bw, 1, 1);       /* short_term_ref_pic_set_sps_flag */
+        bw_put(bw, 0, 1);       /* num_ref_idx_active_override_flag */
+        bw_put_ue(bw, 0);       /* five_minus_max_num_merge_cand */
+    }
+    bw_put_se(bw, 0);           /* slice_qp_delta */
+    size = bw_trailing(bw);     /* byte_alignment */
+
+    for (i = 0; i < payload - 1; i++)
+        bw->buf[size++] = test_rand();
+    bw->buf[size++] = 0x80;
+
+    return size;
+}
+
+static RK_S32 gen_stream(TestStream *strm, RK_S32 slice_num)
+{
+    RK_U8 *rbsp = mpp_malloc(RK_U8, TEST_RBSP_SIZE);
+    RK_S32 max_size = TEST_FRAMES * (TEST_FRAME_SIZE * 2 + 1024 * slice_num);
+    RK_S32 pos = 0;
+    RK_S32 slices_pos = 0;
+    RK_S32 frame;
+    BitWriter bw;
+
+    strm->buf = mpp_malloc(RK_U8, max_size);
+    strm->slices = mpp_malloc(RK_U8, max_size);
+    strm->frame_pos = mpp_calloc(RK_S32, TEST_FRAMES + 1);
+    strm->slices_pos = mpp_calloc(RK_S32, TEST_FRAMES + 1);
+    if (!rbsp || !strm->buf || !strm->slices || !strm->frame_pos || !strm->slices_pos) {
+        MPP_FREE(rbsp);
+        return MPP_ERR_NOMEM;
+    }
+
+    for (frame = 0; frame < TEST_FRAMES; frame++) {
+        RK_S32 slice;
+
+        if (!(frame % TEST_GOP)) {
+            bw_init(&bw, rbsp, TEST_RBSP_SIZE);
+            pos += put_nal(strm->buf + pos, rbsp, gen_vps(&bw));
+            bw_init(&bw, rbsp, TEST_RBSP_SIZE);
+            pos += put_nal(strm->buf + pos, rbsp, gen_sps(&bw));
+            bw_init(&bw, rbsp, TEST_RBSP_SIZE);
+            pos += put_nal(strm->buf + pos, rbsp, gen_pps(&bw));
+        }
+
+        for (slice = 0; slice < slice_num; slice++) {
+            RK_S32 size;
+
+            bw_init(&bw, rbsp, TEST_RBSP_SIZE);
+            size = gen_slice(&bw, frame, slice, slice_num, TEST_FRAME_SIZE / slice_num);
+            size = put_nal(strm->buf + pos, rbsp, size);
+            memcpy(strm->slices + slices_pos, strm->buf + pos, size);
+            slices_pos += size;
+            pos += size;
+        }
+        strm->frame_pos[frame + 1] = pos;
+        strm->slices_pos[frame + 1] = slices_pos;
+    }
+    strm->size = pos;
+
+    mpp_free(rbsp);
+    return MPP_OK;
+}
+
+static void free_stream(TestStream *strm)
+{
+    MPP_FREE(strm->buf);
+    MPP_FREE(strm->slices);
+    MPP_FREE(strm->frame_pos);
+    MPP_FREE(strm->slices_pos);
+}
+
+static MPP_RET parser_test(RK_S32 slice_num)
+{
+    const ParserApi *api = &api_h265d_parser;
+    MppBufSlots frame_slots = NULL;
+    MppBufSlots packet_slots = NULL;
+    MppDecCfgSet cfg;
+    ParserCfg parser_cfg;
+    TestStream strm;
+    void *ctx = NULL;
+    RK_S64 time_prepare = 0;
+    RK_S64 time_parse = 0;
+    RK_S32 task_cnt = 0;
+    RK_S32 frame;
+    MPP_RET ret = MPP_OK;
+
+    memset(&strm, 0, sizeof(strm));
+    ret = gen_stream(&strm, slice_num);
+    if (ret)
+        goto DONE;
+
+    ctx = mpp_calloc_size(void, api->ctx_size);
+    mpp_buf_slot_init(&frame_slots);
+    mpp_buf_slot_init(&packet_slots);
+    if (!ctx || !frame_slots || !packet_slots) {
+        ret = MPP_ERR_NOMEM;
+        goto DONE;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    memset(&parser_cfg, 0, sizeof(parser_cfg));
+    parser_cfg.coding = MPP_VIDEO_CodingHEVC;
+    parser_cfg.frame_slots = frame_slots;
+    parser_cfg.packet_slots = packet_slots;
+    parser_cfg.cfg = &cfg;
+    api->init(ctx, &parser_cfg);
+
+    for (frame = 0; frame < TEST_FRAMES; frame++) {
+        RK_S32 start = strm.frame_pos[frame];
+        RK_S32 slices_start = strm.slices_pos[frame];
+        RK_S32 slices_size = strm.slices_pos[frame + 1] - slices_start;
+        HalDecTask task;
+        MppPacket pkt = NULL;
+        RK_S64 t0, t1, t2;
+        RK_S32 index;
+        RK_S32 i;
+
+        mpp_packet_init(&pkt, strm.buf + start, strm.frame_pos[frame + 1] - start);
+        memset(&task, 0, sizeof(task));
+        task.input = -1;
+
+        t0 = mpp_time();
+        api->prepare(ctx, pkt, &task);
+        t1 = mpp_time();
+
+        if (!task.valid || !task.input_packet) {
+            mpp_err("frame %d prepare failed\n", frame);
+            ret = MPP_NOK;
+        } else if (mpp_packet_get_length(task.input_packet) != (size_t)slices_size ||
+                   memcmp(mpp_packet_get_data(task.input_packet),
+                          strm.slices + slices_start, slices_size)) {
+            mpp_err("frame %d stream mismatch\n", frame);
+            ret = MPP_NOK;
+        }
+        mpp_packet_deinit(&pkt);
+        if (ret)
+            break;
+
+        memset(task.refer, -1, sizeof(task.refer));
+        api->parse(ctx, &task);
+        t2 = mpp_time();
+
+        time_prepare += t1 - t0;
+        time_parse += t2 - t1;
+
+        if (mpp_buf_slot_is_changed(frame_slots))
+            mpp_buf_slot_ready(frame_slots);
+
+        /* act as hal which finishes the task at once */
+        if (task.valid) {
+            mpp_buf_slot_clr_flag(frame_slots, task.output, SLOT_HAL_OUTPUT);
+            for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(task.refer); i++) {
+                if (task.refer[i] >= 0)
+                    mpp_buf_slot_clr_flag(frame_slots, task.refer[i], SLOT_HAL_INPUT);
+            }
+            task_cnt++;
+        }
+
+        while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY))
+            mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
+    }
+
+    if (!ret && task_cnt != TEST_FRAMES) {
+        mpp_err("slice %d task count %d mismatch\n", slice_num, task_cnt);
+        ret = MPP_NOK;
+    }
+
+    mpp_log("slices %2d stream %d KB prepare %6.2f us parse %6.2f us total %6.2f us per frame\n",
+            slice_num, strm.size / 1024,
+            (double)time_prepare / TEST_FRAMES, (double)time_parse / TEST_FRAMES,
+            (double)(time_prepare + time_parse) / TEST_FRAMES);
+
+    api->deinit(ctx);
+
+DONE:
+    MPP_FREE(ctx);
+    if (frame_slots)
+        mpp_buf_slot_deinit(frame_slots);
+    if (packet_slots)
+        mpp_buf_slot_deinit(packet_slots);
+    free_stream(&strm);
+
+    return ret;
+}
+
+int main()
+{
+    static const RK_S32 slice_nums[] = { 1, 4, 8, 16 };
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    mpp_log("h265d_parser_test start\n");
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(slice_nums); i++) {
+        ret = parser_test(slice_nums[i]);
+        if (ret)
+            break;
+    }
+
+    mpp_log("h265d_parser_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
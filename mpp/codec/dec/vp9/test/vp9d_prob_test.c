@@ -0,0 +1,192 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vp9d_prob_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "vp9d_prob.h"
+
+/*
+ * Check vp9d_merge_probs against the scalar reference on random tables with
+ * different count ranges including the 32 bit wrap around case, then time
+ * both on one frame worth of coefficient and mode / mv tree nodes.
+ */
+#define TEST_SIZE           (VP9_COEF_PROB_SIZE + VP9_MODE_PROB_SIZE)
+#define TEST_ROUNDS         200
+#define TEST_BENCH_LOOP     20000
+
+typedef struct TestParam_t {
+    RK_S32      max_count;
+    RK_S32      update_factor;
+} TestParam;
+
+static const TestParam params[] = {
+    { 24, 112 },
+    { 24, 128 },
+    { 20, 128 },
+    { 90, 128 },
+};
+
+/* count range of each round: zero, around max_count, hw frame, full range */
+static const RK_U32 count_masks[] = {
+    0,
+    0x1f,
+    0xffff,
+    0xffffff,
+    0xffffffff,
+};
+
+static RK_U32 test_rand(RK_U32 *seed)
+{
+    /* xorshift32 for the reproducible 32 bit count */
+    RK_U32 x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+
+    return x;
+}
+
+static void fill_table(RK_U8 *p, RK_U32 *ct0, RK_U32 *ct1, RK_S32 n,
+                       RK_U32 mask, RK_U32 *seed)
+{
+    RK_S32 i;
+
+    for (i = 0; i < n; i++) {
+        RK_U32 sel = test_rand(seed);
+
+        p[i] = (RK_U8)test_rand(seed);
+        ct0[i] = test_rand(seed) & mask;
+        ct1[i] = test_rand(seed) & mask;
+
+        /* single branch taken and empty node */
+        if ((sel & 0xf) == 0)
+            ct0[i] = 0;
+        else if ((sel & 0xf) == 1)
+            ct1[i] = 0;
+        else if ((sel & 0xf) == 2)
+            ct0[i] = ct1[i] = 0;
+    }
+}
+
+static MPP_RET test_bit_exact(RK_U8 *p0, RK_U8 *p1, RK_U32 *ct0, RK_U32 *ct1)
+{
+    RK_U32 seed = 0x12345678;
+    RK_U32 i, j;
+    RK_S32 k, r;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(params); i++) {
+        const TestParam *param = &params[i];
+
+        for (j = 0; j < MPP_ARRAY_ELEMS(count_masks); j++) {
+            for (r = 0; r < TEST_ROUNDS; r++) {
+                fill_table(p0, ct0, ct1, TEST_SIZE, count_masks[j], &seed);
+                memcpy(p1, p0, TEST_SIZE);
+
+                vp9d_merge_probs_c(p0, ct0, ct1, TEST_SIZE,
+                                   param->max_count, param->update_factor);
+                vp9d_merge_probs(p1, ct0, ct1, TEST_SIZE,
+                                 param->max_count, param->update_factor);
+
+                if (!memcmp(p0, p1, TEST_SIZE))
+                    continue;
+
+                for (k = 0; k < TEST_SIZE; k++) {
+                    if (p0[k] != p1[k])
+                        break;
+                }
+
+                mpp_err("max %d uf %d mask %08x mismatch at %d ct %u:%u ref %d vs %d\n",
+                        param->max_count, param->update_factor, count_masks[j],
+                        k, ct0[k], ct1[k], p0[k], p1[k]);
+                return MPP_NOK;
+            }
+        }
+    }
+
+    mpp_log("bit exact on %d tables\n",
+            MPP_ARRAY_ELEMS(params) * MPP_ARRAY_ELEMS(count_masks) * TEST_ROUNDS);
+
+    return MPP_OK;
+}
+
+static void test_bench(RK_U8 *p0, RK_U8 *p1, RK_U32 *ct0, RK_U32 *ct1)
+{
+    RK_U32 seed = 0x9e3779b9;
+    RK_S64 time_ref;
+    RK_S64 time_new;
+    RK_S32 i;
+
+    fill_table(p0, ct0, ct1, TEST_SIZE, 0xffff, &seed);
+    memcpy(p1, p0, TEST_SIZE);
+
+    /* coefficient nodes with max count 24 then mode / mv nodes with 20 */
+    time_ref = mpp_time();
+    for (i = 0; i < TEST_BENCH_LOOP; i++) {
+        vp9d_merge_probs_c(p0, ct0, ct1, VP9_COEF_PROB_SIZE, 24, 112);
+        vp9d_merge_probs_c(p0 + VP9_COEF_PROB_SIZE, ct0 + VP9_COEF_PROB_SIZE,
+                           ct1 + VP9_COEF_PROB_SIZE, VP9_MODE_PROB_SIZE, 20, 128);
+    }
+    time_ref = mpp_time() - time_ref;
+
+    time_new = mpp_time();
+    for (i = 0; i < TEST_BENCH_LOOP; i++) {
+        vp9d_merge_probs(p1, ct0, ct1, VP9_COEF_PROB_SIZE, 24, 112);
+        vp9d_merge_probs(p1 + VP9_COEF_PROB_SIZE, ct0 + VP9_COEF_PROB_SIZE,
+                         ct1 + VP9_COEF_PROB_SIZE, VP9_MODE_PROB_SIZE, 20, 128);
+    }
+    time_new = mpp_time() - time_new;
+
+    mpp_log("adapt %d nodes per frame ref %.3f us new %.3f us speedup %.2f\n",
+            TEST_SIZE, (double)time_ref / TEST_BENCH_LOOP,
+            (double)time_new / TEST_BENCH_LOOP,
+            time_new ? (double)time_ref / time_new : 0.0);
+}
+
+int main()
+{
+    RK_U8 *p0 = malloc(TEST_SIZE);
+    RK_U8 *p1 = malloc(TEST_SIZE);
+    RK_U32 *ct0 = malloc(TEST_SIZE * sizeof(RK_U32));
+    RK_U32 *ct1 = malloc(TEST_SIZE * sizeof(RK_U32));
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("vp9d_prob_test start\n");
+
+    if (p0 && p1 && ct0 && ct1) {
+        ret = test_bit_exact(p0, p1, ct0, ct1);
+        if (!ret)
+            test_bench(p0, p1, ct0, ct1);
+    }
+
+    free(p0);
+    free(p1);
+    free(ct0);
+    free(ct1);
+
+    mpp_log("vp9d_prob_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
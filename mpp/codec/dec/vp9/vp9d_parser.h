@@ -27,6 +27,7 @@
 #include "vp9.h"
 #include "vp9data.h"
 #include "vp9d_syntax.h"
+#include "vp9d_prob.h"
 
 extern RK_U32 vp9d_debug;
 
@@ -226,6 +227,9 @@ typedef struct VP9Context {
         RK_U32 coef[4][2][2][6][6][3];
         RK_U32 eob[4][2][2][6][6][2];
     } counts;
+    // coefficient tree node counts for backward adaptation
+    RK_U32 adapt_ct0[VP9_COEF_PROB_SIZE];
+    RK_U32 adapt_ct1[VP9_COEF_PROB_SIZE];
     enum TxfmMode txfmmode;
     enum CompPredMode comppredmode;
 
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VP9D_PROB_H__
+#define __VP9D_PROB_H__
+
+#include "rk_type.h"
+
+/* coefficient probability count in one frame context: [4][2][2][6][6][3] */
+#define VP9_COEF_PROB_SIZE      (4 * 2 * 2 * 6 * 6 * 3)
+
+/* max count of mode / mv tree node adapted in one frame */
+#define VP9_MODE_PROB_SIZE      320
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Backward adaptation of n binary tree node probabilities.
+ *
+ * Node i merges the pre-frame probability p[i] with the probability implied
+ * by the branch counts ct0[i] / ct1[i]. Node with zero count is untouched.
+ * update_factor * max_count * max_count must be below 2^20.
+ *
+ * vp9d_merge_probs is written branch free to let the compiler vectorize it.
+ * vp9d_merge_probs_c is the per node scalar reference and both are bit exact.
+ */
+void vp9d_merge_probs(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                      RK_S32 n, RK_S32 max_count, RK_S32 update_factor);
+void vp9d_merge_probs_c(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                        RK_S32 n, RK_S32 max_count, RK_S32 update_factor);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __VP9D_PROB_H__ */
@@ -972,6 +972,30 @@ RK_S32 h264e_slice_write_pskip(H264eSlice *slice, void *p, RK_U32 size)
     return bitCnt;
 }
 
+#define WORD_ONES           0x0101010101010101ULL
+#define WORD_HIGHS          0x8080808080808080ULL
+#define WORD_HAS_ZERO(x)    (((x) - WORD_ONES) & ~(x) & WORD_HIGHS)
+
+static inline RK_U64 slice_load_be64(const RK_U8 *p)
+{
+    return ((RK_U64)p[0] << 56) | ((RK_U64)p[1] << 48) |
+           ((RK_U64)p[2] << 40) | ((RK_U64)p[3] << 32) |
+           ((RK_U64)p[4] << 24) | ((RK_U64)p[5] << 16) |
+           ((RK_U64)p[6] << 8) | (RK_U64)p[7];
+}
+
+static inline void slice_store_be64(RK_U8 *p, RK_U64 val)
+{
+    p[0] = (RK_U8)(val >> 56);
+    p[1] = (RK_U8)(val >> 48);
+    p[2] = (RK_U8)(val >> 40);
+    p[3] = (RK_U8)(val >> 32);
+    p[4] = (RK_U8)(val >> 24);
+    p[5] = (RK_U8)(val >> 16);
+    p[6] = (RK_U8)(val >> 8);
+    p[7] = (RK_U8)val;
+}
+
 RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
 {
     RK_S32 dst_byte = dst_bit / 8;
@@ -998,6 +1022,164 @@ RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
     RK_U8 *psrc = src + src_byte;
     RK_U8 *pdst = dst + dst_byte;
 
+    RK_U16 tmp16a, tmp16b, tmp16c, last_tmp, dst_mask;
+    RK_U8 tmp0, tmp1;
+    RK_U32 loop = src_len + (src_bit_r > 0);
+    RK_U32 i = 0;
+    RK_U32 src_zero_cnt = 0;
+    RK_U32 dst_zero_cnt = 0;
+    RK_U32 dst_len = 0;
+    RK_U32 word_en = !(h264e_debug & H264E_DBG_SLICE);
+
+    last_tmp = (RK_U16)pdst[0];
+    dst_mask = 0xFFFF << (8 - dst_bit_r);
+
+    h264e_dbg_slice("bit [%d %d] [%d %d] [%d %d] loop %d mask %04x last %04x\n",
+                    src_bit, dst_bit, src_byte, dst_byte,
+                    src_bit_r, dst_bit_r, loop, dst_mask, last_tmp);
+
+    for (i = 0; i < loop; i++) {
+        /*
+         * Eight bytes per step while neither the source bytes nor the shifted
+         * output bytes have zero. Then no 03 can be removed or inserted and
+         * the output word is the source bits shifted by src_bit_r - dst_bit_r.
+         * The last iteration is left to the byte loop for its zero tail.
+         */
+        if (word_en && dst_zero_cnt < 2 && i + 8 < loop) {
+            RK_U64 val = slice_load_be64(psrc);
+
+            if (!WORD_HAS_ZERO(val)) {
+                RK_U64 out = val;
+
+                if (src_bit_r)
+                    out = (out << src_bit_r) | (psrc[8] >> (8 - src_bit_r));
+                if (dst_bit_r)
+                    out = (out >> dst_bit_r) | ((RK_U64)(last_tmp & 0xff) << 56);
+
+                if (!WORD_HAS_ZERO(out)) {
+                    tmp16a = ((RK_U16)psrc[7] << 8) | (RK_U16)psrc[8];
+                    tmp16b = tmp16a << src_bit_r;
+                    last_tmp = (RK_U16)((out & 0xff) << 8) | ((tmp16b >> dst_bit_r) & 0xff);
+
+                    slice_store_be64(pdst, out);
+                    pdst[8] = last_tmp & 0xff;
+
+                    src_zero_cnt = 0;
+                    dst_zero_cnt = 0;
+                    psrc += 8;
+                    pdst += 8;
+                    dst_len += 8;
+                    i += 7;
+                    continue;
+                }
+            }
+        }
+
+        if (psrc[0] == 0) {
+            src_zero_cnt++;
+        } else {
+            src_zero_cnt = 0;
+        }
+
+        // tmp0 tmp1 is next two non-aligned bytes from src
+        tmp0 = psrc[0];
+        tmp1 = (i < loop - 1) ? psrc[1] : 0;
+
+        if (src_zero_cnt >= 2 && tmp1 == 3) {
+            if (h264e_debug & H264E_DBG_SLICE)
+                mpp_log("found 03 at src pos %d %02x %02x %02x %02x %02x %02x %02x %02x\n",
+                        i, psrc[-2], psrc[-1], psrc[0], psrc[1], psrc[2],
+                        psrc[3], psrc[4], psrc[5]);
+
+            psrc++;
+            i++;
+            tmp1 = psrc[1];
+            src_zero_cnt = 0;
+            diff_len--;
+        }
+        // get U16 data
+        tmp16a = ((RK_U16)tmp0 << 8) | (RK_U16)tmp1;
+
+        if (src_bit_r) {
+            tmp16b = tmp16a << src_bit_r;
+        } else {
+            tmp16b = tmp16a;
+        }
+
+        if (dst_bit_r)
+            tmp16c = tmp16b >> dst_bit_r | ((last_tmp << 8) & dst_mask);
+        else
+            tmp16c = tmp16b;
+
+        pdst[0] = (tmp16c >> 8) & 0xFF;
+        pdst[1] = tmp16c & 0xFF;
+
+        if (h264e_debug & H264E_DBG_SLICE) {
+            if (i < 10) {
+                mpp_log("%03d src [%04x] -> [%04x] + last [%04x] -> %04x\n", i, tmp16a, tmp16b, last_tmp, tmp16c);
+            }
+            if (i >= loop - 10) {
+                mpp_log("%03d src [%04x] -> [%04x] + last [%04x] -> %04x\n", i, tmp16a, tmp16b, last_tmp, tmp16c);
+            }
+        }
+
+        if (dst_zero_cnt == 2 && pdst[0] <= 0x3) {
+            if (h264e_debug & H264E_DBG_SLICE)
+                mpp_log("found 03 at dst frame %d pos %d\n", frame_no, dst_len);
+
+            pdst[2] = pdst[1];
+            pdst[1] = pdst[0];
+            pdst[0] = 0x3;
+            pdst++;
+            diff_len++;
+            dst_len++;
+            dst_zero_cnt = 0;
+        }
+
+        if (pdst[0] == 0)
+            dst_zero_cnt++;
+        else
+            dst_zero_cnt = 0;
+
+        last_tmp = tmp16c;
+
+        psrc++;
+        pdst++;
+        dst_len++;
+    }
+
+    frame_no++;
+
+    return diff_len;
+}
+
+/* byte by byte reference of h264e_slice_move */
+RK_S32 h264e_slice_move_c(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
+{
+    RK_S32 dst_byte = dst_bit / 8;
+    RK_S32 src_byte = src_bit / 8;
+    RK_S32 dst_bit_r = dst_bit & 7;
+    RK_S32 src_bit_r = src_bit & 7;
+    RK_S32 src_len = src_size - src_byte;
+    RK_S32 diff_len = 0;
+    static RK_S32 frame_no = 0;
+
+    if (src_bit_r == 0 && dst_bit_r == 0) {
+        // direct copy
+        if (h264e_debug & H264E_DBG_SLICE)
+            mpp_log_f("direct copy %p -> %p %d\n", src, dst, src_len);
+
+        h264e_dbg_slice("bit [%d %d] [%d %d] [%d %d] len %d\n",
+                        src_bit, dst_bit, src_byte, dst_byte,
+                        src_bit_r, dst_bit_r, src_len);
+
+        memcpy(dst + dst_byte, src + src_byte, src_len);
+        return diff_len;
+    }
+
+    RK_U8 *psrc = src + src_byte;
+    RK_U8 *pdst = dst + dst_byte;
+
     RK_U16 tmp16a, tmp16b, tmp16c, last_tmp, dst_mask;
     RK_U8 tmp0, tmp1;
     RK_U32 loop = src_len + (src_bit_r > 0);
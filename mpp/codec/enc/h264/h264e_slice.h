@@ -169,8 +169,16 @@ RK_S32 h264e_slice_update(H264eSlice *slice, MppEncCfgSet *cfg,
 RK_S32 h264e_slice_read(H264eSlice *slice, void *p, RK_S32 size);
 RK_S32 h264e_slice_write(H264eSlice *slice, void *p, RK_U32 size);
 RK_S32 h264e_slice_write_pskip(H264eSlice *slice, void *p, RK_U32 size);
+/*
+ * Move slice data from src_bit of src to dst_bit of dst, removing the
+ * emulation prevention bytes of src and inserting the ones needed by dst.
+ * Return the size change in bytes. h264e_slice_move_c is the byte by byte
+ * version kept for verification.
+ */
 RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
                         RK_S32 src_size);
+RK_S32 h264e_slice_move_c(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
+                          RK_S32 src_size);
 
 RK_S32 h264e_slice_write_prefix_nal_unit_svc(H264ePrefixNal *nal, void *p, RK_S32 size);
 
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_slice_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "h264e_slice.h"
+
+/* typical I slice size of 1080p and 4K stream */
+#define SLICE_SIZE_1080P    (256 * 1024)
+#define SLICE_SIZE_4K       (1024 * 1024)
+#define MAX_SLICE_SIZE      (4 * 1024 * 1024)
+#define LOOP_COUNT          16
+/* one of CHECK_ZERO_RATE bytes is zero for the 03 insert / remove path */
+#define CHECK_ZERO_RATE     4
+#define CHECK_SMALL_COUNT   4096
+
+/* padding for the bytes read and written after the slice end */
+#define BUF_PAD             16
+
+/*
+ * generate slice payload with emulation prevention applied
+ * zero_rate - one of zero_rate bytes is forced to zero, 0 for none
+ */
+static void gen_slice(RK_U8 *buf, RK_S32 size, RK_S32 zero_rate)
+{
+    RK_S32 zeros = 0;
+    RK_S32 pos = 0;
+
+    while (pos < size) {
+        RK_U8 val = (zero_rate && !(rand() % zero_rate)) ? 0 : rand() & 0xff;
+
+        if (zeros >= 2 && val <= 3) {
+            buf[pos++] = 3;
+            zeros = 0;
+            if (pos >= size)
+                break;
+        }
+        buf[pos++] = val;
+        zeros = val ? 0 : zeros + 1;
+    }
+
+    /* rbsp trailing byte */
+    buf[size - 1] = 0x80;
+}
+
+static RK_S32 check_move(RK_U8 *src, RK_S32 size, RK_U8 *dst_ref, RK_U8 *dst_new,
+                         RK_S32 dst_size, RK_S32 dst_bit, RK_S32 src_bit)
+{
+    RK_S32 dst_byte = dst_bit / 8;
+    RK_S32 diff_ref;
+    RK_S32 diff_new;
+
+    memset(dst_ref, 0xa5, dst_size);
+    dst_ref[dst_byte] = rand() & 0xff;
+    memcpy(dst_new, dst_ref, dst_size);
+
+    diff_ref = h264e_slice_move_c(dst_ref, src, dst_bit, src_bit, size);
+    diff_new = h264e_slice_move(dst_new, src, dst_bit, src_bit, size);
+
+    if (diff_ref != diff_new || memcmp(dst_ref, dst_new, dst_size)) {
+        RK_S32 i;
+
+        for (i = 0; i < dst_size; i++)
+            if (dst_ref[i] != dst_new[i])
+                break;
+
+        mpp_err("size %d bit [%d %d] mismatch diff %d vs %d at byte %d\n",
+                size, src_bit, dst_bit, diff_new, diff_ref, i);
+        return -1;
+    }
+
+    return 0;
+}
+
+static RK_S32 check_slice(RK_U8 *src, RK_S32 size, RK_U8 *dst_ref, RK_U8 *dst_new)
+{
+    RK_S32 dst_size = size * 3 / 2 + BUF_PAD;
+    RK_S32 src_bit;
+    RK_S32 dst_bit;
+
+    for (src_bit = 0; src_bit < 8; src_bit++) {
+        for (dst_bit = 0; dst_bit < 8; dst_bit++) {
+            RK_S32 src_off = src_bit + (rand() % 4) * 8;
+            RK_S32 dst_off = dst_bit + (rand() % 4) * 8;
+
+            if (src_off / 8 >= size)
+                src_off = src_bit;
+
+            if (check_move(src, size, dst_ref, dst_new, dst_size, dst_off, src_off))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+static RK_S32 load_file(const char *name, RK_U8 *buf, RK_S32 max)
+{
+    FILE *fp = fopen(name, "rb");
+    RK_S32 size = 0;
+
+    if (!fp) {
+        mpp_err("failed to open %s\n", name);
+        return 0;
+    }
+
+    size = fread(buf, 1, max, fp);
+    fclose(fp);
+
+    return size;
+}
+
+static void bench_slice(RK_U8 *src, RK_S32 size, RK_U8 *dst, const char *name)
+{
+    RK_S64 time_ref = 0;
+    RK_S64 time_new = 0;
+    RK_S64 start;
+    RK_S32 i;
+
+    for (i = 0; i < LOOP_COUNT; i++) {
+        /* header rewrite shifts the slice data by a few bits */
+        RK_S32 src_bit = 8 + (i & 7);
+        RK_S32 dst_bit = 8 + ((i * 3 + 1) & 7);
+
+        start = mpp_time();
+        h264e_slice_move_c(dst, src, dst_bit, src_bit, size);
+        time_ref += mpp_time() - start;
+
+        start = mpp_time();
+        h264e_slice_move(dst, src, dst_bit, src_bit, size);
+        time_new += mpp_time() - start;
+    }
+
+    mpp_log("%-6s slice %7d byte move %8.2f MB/s word move %8.2f MB/s\n", name, size,
+            (double)size * LOOP_COUNT / MPP_MAX(time_ref, 1),
+            (double)size * LOOP_COUNT / MPP_MAX(time_new, 1));
+}
+
+int main(int argc, char **argv)
+{
+    RK_U8 *src = mpp_calloc(RK_U8, MAX_SLICE_SIZE + BUF_PAD);
+    RK_U8 *dst_ref = mpp_calloc(RK_U8, MAX_SLICE_SIZE * 3 / 2 + BUF_PAD);
+    RK_U8 *dst_new = mpp_calloc(RK_U8, MAX_SLICE_SIZE * 3 / 2 + BUF_PAD);
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("h264e_slice_test start\n");
+
+    if (!src || !dst_ref || !dst_new) {
+        ret = -1;
+        goto DONE;
+    }
+
+    srand(0x264);
+
+    /* short slices with many zero bytes for the tail and 03 handling */
+    for (i = 0; i < CHECK_SMALL_COUNT; i++) {
+        RK_S32 size = rand() % 64 + 2;
+
+        gen_slice(src, size, (i & 1) ? CHECK_ZERO_RATE : 2);
+        ret = check_slice(src, size, dst_ref, dst_new);
+        if (ret)
+            goto DONE;
+    }
+
+    gen_slice(src, SLICE_SIZE_1080P, CHECK_ZERO_RATE);
+    ret = check_slice(src, SLICE_SIZE_1080P, dst_ref, dst_new);
+    if (ret)
+        goto DONE;
+
+    gen_slice(src, SLICE_SIZE_1080P, 0);
+    ret = check_slice(src, SLICE_SIZE_1080P, dst_ref, dst_new);
+    if (ret)
+        goto DONE;
+    bench_slice(src, SLICE_SIZE_1080P, dst_new, "1080p");
+
+    gen_slice(src, SLICE_SIZE_4K, 0);
+    ret = check_slice(src, SLICE_SIZE_4K, dst_ref, dst_new);
+    if (ret)
+        goto DONE;
+    bench_slice(src, SLICE_SIZE_4K, dst_new, "4K");
+
+    /* slice nal payload dumped from encoder */
+    if (argc > 1) {
+        RK_S32 size = load_file(argv[1], src, MAX_SLICE_SIZE);
+
+        if (size > 1) {
+            memset(src + size, 0, BUF_PAD);
+            ret = check_slice(src, size, dst_ref, dst_new);
+            if (ret)
+                goto DONE;
+            bench_slice(src, size, dst_new, "file");
+        }
+    }
+
+DONE:
+    MPP_FREE(src);
+    MPP_FREE(dst_ref);
+    MPP_FREE(dst_new);
+
+    mpp_log("h264e_slice_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -43,10 +43,20 @@ typedef enum MppDecTimingType_e {
     DEC_HAL_WAIT,
     DEC_HAL_PROC,
     DEC_HW_WAIT,
+    /* parser update from hal feedback, e.g. vp9 probability adaptation */
+    DEC_PRS_UPDATE,
     DEC_TIMING_BUTT,
 } MppDecTimingType;
 
 
+/*
+ * max parser / hal pipeline depth set by base:task_count
+ * fast mode hal has three register sets for the tasks in flight
+ */
+#define MPP_DEC_TASK_COUNT_MAX  3
+/* frame slot count for recording hardware start and done time */
+#define MPP_DEC_LAT_SLOT_MAX    128
+
 typedef enum MppDecMode_e {
     MPP_DEC_MODE_DEFAULT,
     MPP_DEC_MODE_NO_THREAD,
@@ -140,6 +150,12 @@ struct MppDecImpl_t {
     RK_U32              statistics_en;
     MppClock            clocks[DEC_TIMING_BUTT];
 
+    // latency histogram for MPP_DEC_GET_LATENCY
+    MppTimeHist         lat_hist[MPP_DEC_LAT_BUTT];
+    RK_S64              pkt_in_time;
+    RK_S64              slot_hw_start[MPP_DEC_LAT_SLOT_MAX];
+    RK_S64              slot_hw_done[MPP_DEC_LAT_SLOT_MAX];
+
     // query data
     RK_U32              dec_in_pkt_count;
     RK_U32              dec_hw_run_count;
@@ -223,6 +239,10 @@ typedef struct DecTask_t {
     HalTaskInfo     info;
     MppPktTs        ts_cur;
 
+    /* time of input packet and parse done for latency statistic */
+    RK_S64          time_pkt_in;
+    RK_S64          time_parsed;
+
     MppBuffer       hal_pkt_buf_in;
     MppBuffer       hal_frm_buf_out;
 } DecTask;
@@ -236,6 +256,10 @@ void dec_task_init(DecTask *task);
 
 MPP_RET mpp_dec_proc_cfg(MppDecImpl *dec, MpiCmd cmd, void *param);
 
+void mpp_dec_lat_add(MppDecImpl *dec, MppDecLatencyStage stage, RK_S64 start, RK_S64 end);
+void mpp_dec_lat_hw_start(MppDecImpl *dec, DecTask *task);
+void mpp_dec_lat_hw_done(MppDecImpl *dec, RK_S32 index);
+
 MPP_RET update_dec_hal_info(MppDecImpl *dec, MppFrame frame);
 void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags);
 RK_S32 mpp_dec_push_display(Mpp *mpp, HalDecTaskFlag flags);
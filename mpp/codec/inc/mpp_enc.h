@@ -151,6 +151,12 @@
 
 typedef void* MppEnc;
 
+/*
+ * max encoder frames in flight set by MPP_SET_ENC_TASK_COUNT
+ * rk3588 jpeg encoder has four cores to run tasks in parallel
+ */
+#define MPP_ENC_TASK_COUNT_MAX  4
+
 typedef struct MppEncInitCfg_t {
     MppCodingType       coding;
     RK_S32              task_cnt;
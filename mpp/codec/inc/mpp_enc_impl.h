@@ -24,6 +24,7 @@
 #include "mpp_device.h"
 
 #include "rc.h"
+#include "rc_trace.h"
 #include "hal_info.h"
 
 #define HDR_ADDED_MASK  0xe
@@ -66,6 +67,8 @@ typedef struct MppEncImpl_t {
     RK_S32              rc_cfg_updated;
     RcApiBrief          rc_brief;
     RcCtx               rc_ctx;
+    /* per-frame rc statistic trace for host replay */
+    RcTrace             rc_trace;
 
     /*
      * thread input / output context
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RC_TRACE_H__
+#define __RC_TRACE_H__
+
+#include "mpp_rc_api.h"
+
+/*
+ * Rate control trace
+ *
+ * A trace records the rc config and the per-frame statistic returned by
+ * hardware so that a RcImplApi can be replayed on host without hardware.
+ *
+ * The trace is a text file with one record per line:
+ *
+ * cfg <key>=<value> ...
+ *     rc config passed to rc_update_usr_cfg. Keys are the RcCfg member names.
+ *     The coding type and rc api name are stored as key type and rc.
+ *
+ * frm <seq_idx> <frame_type> <is_intra> <is_idr> <ref_mode> <temporal_id>
+ *     <bit_target> <bit_real> <quality_target> <quality_real>
+ *     <madi> <madp> <iblk4_prop> <sse>
+ *     final statistic of one encoded frame after rc_frm_end.
+ *
+ * Lines starting with '#' are comments.
+ */
+typedef void* RcTrace;
+
+typedef enum RcTraceRec_e {
+    RC_TRACE_REC_NONE,
+    RC_TRACE_REC_CFG,
+    RC_TRACE_REC_FRM,
+    RC_TRACE_REC_BUTT,
+} RcTraceRec;
+
+typedef struct RcTraceFrm_t {
+    RK_S32          seq_idx;
+    EncFrmType      frame_type;
+    RK_S32          is_intra;
+    RK_S32          is_idr;
+    RK_S32          ref_mode;
+    RK_S32          temporal_id;
+
+    RK_S32          bit_target;
+    RK_S32          bit_real;
+    RK_S32          quality_target;
+    RK_S32          quality_real;
+    RK_S32          madi;
+    RK_S32          madp;
+    RK_U32          iblk4_prop;
+    RK_S64          sse;
+} RcTraceFrm;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* open trace file for writing when write is non-zero otherwise for reading */
+MPP_RET rc_trace_init(RcTrace *trace, const char *path, RK_S32 write);
+MPP_RET rc_trace_deinit(RcTrace trace);
+
+MPP_RET rc_trace_put_cfg(RcTrace trace, MppCodingType type, const char *name, RcCfg *cfg);
+MPP_RET rc_trace_put_frm(RcTrace trace, EncRcTask *task);
+
+/*
+ * read next record from trace
+ * RC_TRACE_REC_CFG - type and cfg are updated
+ * RC_TRACE_REC_FRM - frm is updated
+ * RC_TRACE_REC_NONE - end of trace
+ */
+RcTraceRec rc_trace_get(RcTrace trace, MppCodingType *type, RcCfg *cfg, RcTraceFrm *frm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RC_TRACE_H__ */
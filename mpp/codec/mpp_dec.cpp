@@ -29,8 +29,13 @@
 #include "mpp_dec_cb_param.h"
 #include "mpp_dec_normal.h"
 #include "mpp_dec_no_thread.h"
+#include "mpp_impl.h"
 
 RK_U32 mpp_dec_debug = 0;
+/* sum the stage timing of all instances on deinit for benchmark */
+static RK_U32 mpp_dec_stat = 0;
+static RK_S64 dec_timing_sum[DEC_TIMING_BUTT];
+static RK_S64 dec_timing_cnt[DEC_TIMING_BUTT];
 
 MPP_RET dec_task_info_init(HalTaskInfo *task)
 {
@@ -101,6 +106,7 @@ static MPP_RET mpp_dec_check_fbc_cap(MppDecImpl *p)
 MPP_RET mpp_dec_proc_cfg(MppDecImpl *dec, MpiCmd cmd, void *param)
 {
     MPP_RET ret = MPP_OK;
+    RK_S32 i;
 
     mpp_parser_control(dec->parser, cmd, param);
 
@@ -174,6 +180,32 @@ MPP_RET mpp_dec_proc_cfg(MppDecImpl *dec, MpiCmd cmd, void *param)
         if (flag & MPP_DEC_QUERY_DEC_OUT_FRM)
             query->dec_out_frm_cnt = dec->dec_out_frame_count;
     } break;
+    case MPP_DEC_GET_LATENCY: {
+        MppDecLatencyStat *stat = (MppDecLatencyStat *)param;
+
+        if (!stat) {
+            mpp_err_f("found NULL latency stat\n");
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        for (i = 0; i < MPP_DEC_LAT_BUTT; i++) {
+            MppTimeHist hist = dec->lat_hist[i];
+            MppDecLatency *lat = &stat->stage[i];
+            RK_S64 count = mpp_time_hist_get_count(hist);
+
+            lat->count = (RK_U32)count;
+            lat->avg = count ? (RK_U32)(mpp_time_hist_get_sum(hist) / count) : 0;
+            lat->p50 = (RK_U32)mpp_time_hist_percentile(hist, 500);
+            lat->p99 = (RK_U32)mpp_time_hist_percentile(hist, 990);
+            lat->max = (RK_U32)mpp_time_hist_get_max(hist);
+
+            if (stat->reset)
+                mpp_time_hist_reset(hist);
+        }
+
+        dec_dbg_func("get latency\n");
+    } break;
     case MPP_DEC_SET_CFG: {
         MppDecCfgImpl *dec_cfg = (MppDecCfgImpl *)param;
 
@@ -201,6 +233,39 @@ RET:
     return ret;
 }
 
+void mpp_dec_lat_add(MppDecImpl *dec, MppDecLatencyStage stage, RK_S64 start, RK_S64 end)
+{
+    if (start && end >= start)
+        mpp_time_hist_add(dec->lat_hist[stage], end - start);
+}
+
+/* called after hardware start with the task to be waited */
+void mpp_dec_lat_hw_start(MppDecImpl *dec, DecTask *task)
+{
+    RK_S32 index = task->info.dec.output;
+    RK_S64 time = mpp_time();
+
+    mpp_dec_lat_add(dec, MPP_DEC_LAT_PKT_TO_PARSE, task->time_pkt_in, task->time_parsed);
+    mpp_dec_lat_add(dec, MPP_DEC_LAT_PARSE_TO_HW, task->time_parsed, time);
+
+    if (index >= 0 && index < MPP_DEC_LAT_SLOT_MAX)
+        dec->slot_hw_start[index] = time;
+}
+
+/* called after hardware wait, the frame output time is recorded on put frame */
+void mpp_dec_lat_hw_done(MppDecImpl *dec, RK_S32 index)
+{
+    RK_S64 time;
+
+    if (index < 0 || index >= MPP_DEC_LAT_SLOT_MAX)
+        return;
+
+    time = mpp_time();
+    mpp_dec_lat_add(dec, MPP_DEC_LAT_HW_WAIT, dec->slot_hw_start[index], time);
+    dec->slot_hw_start[index] = 0;
+    dec->slot_hw_done[index] = time;
+}
+
 /* Overall mpp_dec output frame function */
 void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
 {
@@ -216,6 +281,11 @@ void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
     if (index >= 0) {
         RK_U32 mode = 0;
 
+        if (index < MPP_DEC_LAT_SLOT_MAX && dec->slot_hw_done[index]) {
+            mpp_dec_lat_add(dec, MPP_DEC_LAT_FRM_OUT, dec->slot_hw_done[index], mpp_time());
+            dec->slot_hw_done[index] = 0;
+        }
+
         mpp_buf_slot_get_prop(slots, index, SLOT_FRAME_PTR, &frame);
 
         mode = mpp_frame_get_mode(frame);
@@ -475,6 +545,14 @@ static const char *timing_str[DEC_TIMING_BUTT] = {
     "hal wait  ",
     "hal proc  ",
     "hw wait   ",
+    "prs update",
+};
+
+static const char *latency_str[MPP_DEC_LAT_BUTT] = {
+    "pkt to parse",
+    "parse to hw ",
+    "hw wait     ",
+    "frame out   ",
 };
 
 MPP_RET mpp_dec_set_cfg(MppDecCfgSet *dst, MppDecCfgSet *src)
@@ -534,6 +612,9 @@ MPP_RET mpp_dec_set_cfg(MppDecCfgSet *dst, MppDecCfgSet *src)
         if (change & MPP_DEC_CFG_CHANGE_ENABLE_MVC)
             dst_base->enable_mvc = src_base->enable_mvc;
 
+        if (change & MPP_DEC_CFG_CHANGE_TASK_COUNT)
+            dst_base->task_count = src_base->task_count;
+
         if (change & MPP_DEC_CFG_CHANGE_DISABLE_THREAD)
             dst_base->disable_thread = src_base->disable_thread;
 
@@ -573,8 +654,11 @@ MPP_RET mpp_dec_callback_hal_to_parser(const char *caller, void *ctx,
 
     mpp_assert(cmd == DEC_PARSER_CALLBACK);
 
-    if (p->parser)
+    if (p->parser) {
+        mpp_clock_start(p->clocks[DEC_PRS_UPDATE]);
         ret = mpp_parser_callback(p->parser, param);
+        mpp_clock_pause(p->clocks[DEC_PRS_UPDATE]);
+    }
 
     return ret;
 }
@@ -605,6 +689,7 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
     SlotHalFbcAdjCfg hal_fbc_adj_cfg;
 
     mpp_env_get_u32("mpp_dec_debug", &mpp_dec_debug, 0);
+    mpp_env_get_u32("mpp_dec_stat", &mpp_dec_stat, 0);
 
     dec_dbg_func("in\n");
 
@@ -682,9 +767,16 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
         support_fast_mode = hal_cfg.support_fast_mode;
 
         if (dec_cfg->base.fast_parse && support_fast_mode) {
-            hal_task_count = dec_cfg->status.hal_task_count ?
-                             dec_cfg->status.hal_task_count : 3;
+            if (dec_cfg->base.task_count)
+                hal_task_count = MPP_CLIP3(1, MPP_DEC_TASK_COUNT_MAX, dec_cfg->base.task_count);
+            else
+                hal_task_count = dec_cfg->status.hal_task_count ?
+                                 dec_cfg->status.hal_task_count : 3;
         } else {
+            if (dec_cfg->base.task_count)
+                mpp_log_f("task count %d requires fast parse mode\n",
+                          dec_cfg->base.task_count);
+
             dec_cfg->base.fast_parse = 0;
             p->parser_fast_mode = 0;
         }
@@ -731,7 +823,7 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
         p->frame_slots  = frame_slots;
         p->packet_slots = packet_slots;
 
-        p->statistics_en = (mpp_dec_debug & MPP_DEC_DBG_TIMING) ? 1 : 0;
+        p->statistics_en = ((mpp_dec_debug & MPP_DEC_DBG_TIMING) || mpp_dec_stat) ? 1 : 0;
 
         for (i = 0; i < DEC_TIMING_BUTT; i++) {
             p->clocks[i] = mpp_clock_get(timing_str[i]);
@@ -739,6 +831,11 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
             mpp_clock_enable(p->clocks[i], p->statistics_en);
         }
 
+        for (i = 0; i < MPP_DEC_LAT_BUTT; i++) {
+            p->lat_hist[i] = mpp_time_hist_get(latency_str[i]);
+            mpp_assert(p->lat_hist[i]);
+        }
+
         p->cmd_lock = new MppMutexCond();
         sem_init(&p->parser_reset, 0, 0);
         sem_init(&p->hal_reset, 0, 0);
@@ -788,6 +885,13 @@ MPP_RET mpp_dec_deinit(MppDec ctx)
     }
 
     if (dec->statistics_en) {
+        for (i = 0; i < DEC_TIMING_BUTT; i++) {
+            MPP_FETCH_ADD(&dec_timing_sum[i], mpp_clock_get_sum(dec->clocks[i]));
+            MPP_FETCH_ADD(&dec_timing_cnt[i], mpp_clock_get_count(dec->clocks[i]));
+        }
+    }
+
+    if (dec->statistics_en && (mpp_dec_debug & MPP_DEC_DBG_TIMING)) {
         mpp_log("%p work %lu wait %lu\n", dec,
                 dec->parser_work_count, dec->parser_wait_count);
 
@@ -804,6 +908,19 @@ MPP_RET mpp_dec_deinit(MppDec ctx)
                     mpp_clock_get_name(timer), time * 100.0 / total, time,
                     time / mpp_clock_get_count(timer));
         }
+
+        for (i = 0; i < MPP_DEC_LAT_BUTT; i++) {
+            MppTimeHist hist = dec->lat_hist[i];
+
+            if (!mpp_time_hist_get_count(hist))
+                continue;
+
+            mpp_log("%p %s - p50 %-8lld p99 %-8lld max %-8lld\n", dec,
+                    mpp_time_hist_get_name(hist),
+                    mpp_time_hist_percentile(hist, 500),
+                    mpp_time_hist_percentile(hist, 990),
+                    mpp_time_hist_get_max(hist));
+        }
     }
 
     for (i = 0; i < DEC_TIMING_BUTT; i++) {
@@ -811,6 +928,13 @@ MPP_RET mpp_dec_deinit(MppDec ctx)
         dec->clocks[i] = NULL;
     }
 
+    for (i = 0; i < MPP_DEC_LAT_BUTT; i++) {
+        if (dec->lat_hist[i]) {
+            mpp_time_hist_put(dec->lat_hist[i]);
+            dec->lat_hist[i] = NULL;
+        }
+    }
+
     if (dec->hal_info) {
         hal_info_deinit(dec->hal_info);
         dec->hal_info = NULL;
@@ -1066,3 +1190,24 @@ MPP_RET mpp_dec_set_cfg_by_cmd(MppDecCfgSet *set, MpiCmd cmd, void *param)
 
     return ret;
 }
+
+RK_S32 mpp_dec_timing_stat_get(MppDecTimingStat *stat, RK_S32 max)
+{
+    RK_S32 i;
+
+    if (!stat || max <= 0) {
+        mpp_err_f("invalid input stat %p max %d\n", stat, max);
+        return 0;
+    }
+
+    if (max > DEC_TIMING_BUTT)
+        max = DEC_TIMING_BUTT;
+
+    for (i = 0; i < max; i++) {
+        stat[i].name = timing_str[i];
+        stat[i].sum = MPP_FETCH_ADD(&dec_timing_sum[i], 0);
+        stat[i].count = MPP_FETCH_ADD(&dec_timing_cnt[i], 0);
+    }
+
+    return max;
+}
@@ -49,6 +49,8 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
 
         if (input == NULL)
             return MPP_OK;
+
+        dec->pkt_in_time = mpp_time();
     }
 
     if (input)
@@ -71,6 +73,7 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
         if (task_dec->valid) {
             status->curr_task_rdy = 1;
             dec->mpp_pkt_in = input;
+            task->time_pkt_in = dec->pkt_in_time;
         }
 
         if (input && !mpp_packet_get_length(input))
@@ -161,6 +164,7 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
         status->task_parsed_rdy = 1;
+        task->time_parsed = mpp_time();
     }
 
     dec_dbg_detail("detail: %p parse output slot %d valid %d\n", dec,
@@ -290,7 +294,9 @@ MPP_RET mpp_dec_decode(MppDec ctx, MppPacket packet)
 
     mpp_hal_reg_gen(dec->hal, &task->info);
     mpp_hal_hw_start(dec->hal, &task->info);
+    mpp_dec_lat_hw_start(dec, task);
     mpp_hal_hw_wait(dec->hal, &task->info);
+    mpp_dec_lat_hw_done(dec, task_dec->output);
     dec->dec_hw_run_count++;
     /*
      * when hardware decoding is done:
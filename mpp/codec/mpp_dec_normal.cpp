@@ -83,7 +83,12 @@ static MPP_RET check_task_wait(MppDecImpl *dec, DecTask *task)
     return ret;
 }
 
-static MPP_RET dec_release_task_in_port(MppPort port)
+/*
+ * packets in mMppInPort are always decoder-owned copies made by put_packet.
+ * Packets in advanced mode ports may carry a buffer owned by the caller and
+ * those are left for the caller to release.
+ */
+static MPP_RET dec_release_task_in_port(MppPort port, RK_S32 owned)
 {
     MPP_RET ret = MPP_OK;
     MppPacket packet = NULL;
@@ -107,7 +112,7 @@ static MPP_RET dec_release_task_in_port(MppPort port)
             frame = NULL;
         }
         ret = mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
-        if (packet && NULL == mpp_packet_get_buffer(packet)) {
+        if (packet && (owned || NULL == mpp_packet_get_buffer(packet))) {
             mpp_packet_deinit(&packet);
             packet = NULL;
         }
@@ -123,9 +128,11 @@ static void dec_release_input_packet(MppDecImpl *dec, RK_S32 force)
 {
     if (dec->mpp_pkt_in) {
         if (force || 0 == mpp_packet_get_length(dec->mpp_pkt_in)) {
-            mpp_packet_deinit(&dec->mpp_pkt_in);
+            /* notify zero copy input buffer before dropping its reference */
+            MppBuffer buffer = mpp_packet_get_buffer(dec->mpp_pkt_in);
 
-            mpp_dec_callback(dec, MPP_DEC_EVENT_ON_PKT_RELEASE, dec->mpp_pkt_in);
+            mpp_dec_callback(dec, MPP_DEC_EVENT_ON_PKT_RELEASE, buffer);
+            mpp_packet_deinit(&dec->mpp_pkt_in);
             dec->mpp_pkt_in = NULL;
         }
     }
@@ -143,7 +150,7 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
     dec_dbg_reset("reset: parser reset start\n");
     dec_dbg_reset("reset: parser wait hal proc reset start\n");
 
-    dec_release_task_in_port(mpp->mMppInPort);
+    dec_release_task_in_port(mpp->mMppInPort, 1);
 
     mpp_assert(hal);
 
@@ -299,11 +306,14 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
     mpp_assert(packet);
 
-    /* when it is copy buffer return packet right here */
-    if (NULL == mpp_packet_get_buffer(packet))
-        mpp_port_enqueue(input, mpp_task);
+    /*
+     * packet in task is always owned by decoder on both copy and zero copy
+     * path so return the task right here to keep put_packet non-blocking
+     */
+    mpp_port_enqueue(input, mpp_task);
 
     dec->mpp_pkt_in = packet;
+    dec->pkt_in_time = mpp_time();
     mpp->mPacketGetCount++;
     dec->dec_in_pkt_count++;
 
@@ -383,6 +393,8 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
+        if (task_dec->valid)
+            task->time_pkt_in = dec->pkt_in_time;
         if (dec->cfg.base.sort_pts && task_dec->valid) {
             task->ts_cur.pts = mpp_packet_get_pts(dec->mpp_pkt_in);
             task->ts_cur.dts = mpp_packet_get_dts(dec->mpp_pkt_in);
@@ -512,6 +524,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
         task->status.task_parsed_rdy = 1;
+        task->time_parsed = mpp_time();
     }
 
     if (task_dec->output < 0 || !task_dec->valid) {
@@ -661,6 +674,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     mpp_clock_start(dec->clocks[DEC_HW_START]);
     mpp_hal_hw_start(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HW_START]);
+    mpp_dec_lat_hw_start(dec, task);
 
     /*
      * 12. send dxva output information and buffer information to hal thread
@@ -757,7 +771,7 @@ void *mpp_dec_parser_thread(void *data)
         mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
     }
     mpp_buffer_group_clear(mpp->mPacketGroup);
-    dec_release_task_in_port(mpp->mMppInPort);
+    dec_release_task_in_port(mpp->mMppInPort, 1);
     mpp_dbg_info("mpp_dec_parser_thread exited\n");
     return NULL;
 }
@@ -854,6 +868,7 @@ void *mpp_dec_hal_thread(void *data)
             mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
             mpp_hal_hw_wait(dec->hal, &task_info);
             mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
+            mpp_dec_lat_hw_done(dec, task_dec->output);
             dec->dec_hw_run_count++;
 
             /*
@@ -1091,9 +1106,9 @@ void *mpp_dec_advanced_thread(void *data)
     }
 
     // clear remain task in output port
-    dec_release_task_in_port(input);
-    dec_release_task_in_port(mpp->mUsrInPort);
-    dec_release_task_in_port(mpp->mUsrOutPort);
+    dec_release_task_in_port(input, 0);
+    dec_release_task_in_port(mpp->mUsrInPort, 0);
+    dec_release_task_in_port(mpp->mUsrOutPort, 0);
 
     return NULL;
 }
@@ -1365,6 +1365,8 @@ MPP_RET mpp_enc_proc_rc_update(MppEncImpl *enc)
         memset(&usr_cfg, 0 , sizeof(usr_cfg));
         set_rc_cfg(&usr_cfg, cfg);
         ret = rc_update_usr_cfg(enc->rc_ctx, &usr_cfg);
+        if (enc->rc_trace)
+            rc_trace_put_cfg(enc->rc_trace, enc->coding, enc->rc_brief.name, &usr_cfg);
         rc_cfg->change = 0;
         prep_cfg->change = 0;
 
@@ -2183,6 +2185,9 @@ TASK_DONE:
     enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
 
+    if (enc->rc_trace)
+        rc_trace_put_frm(enc->rc_trace, rc_task);
+
     enc_dbg_detail("task %d enqueue frame pts %lld\n", frm->seq_idx, enc->task_pts);
 
     mpp_task_meta_set_frame(enc->task_in, KEY_INPUT_FRAME, enc->frame);
@@ -2287,6 +2292,9 @@ static MPP_RET try_proc_normal_task(MppEncImpl *enc, EncAsyncTaskInfo *task)
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
 
+    if (enc->rc_trace)
+        rc_trace_put_frm(enc->rc_trace, rc_task);
+
     enc->time_end = mpp_time();
     enc->frame_count++;
 
@@ -2968,6 +2976,9 @@ static MPP_RET enc_async_wait_task(MppEncImpl *enc, EncAsyncTaskInfo *info)
     enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
 
+    if (enc->rc_trace)
+        rc_trace_put_frm(enc->rc_trace, rc_task);
+
 TASK_DONE:
     if (!mpp_packet_is_partition(pkt)) {
         /* setup output packet and meta data */
@@ -3090,6 +3101,9 @@ void *mpp_enc_async_thread(void *data)
                 while (frm_in->list_size())
                     async_task_skip(enc);
 
+                /* wake up the block input waiting for free slot */
+                frm_in->signal();
+
                 {
                     AutoMutex autolock(thd_enc->mutex());
                     enc->status_flag = 0;
@@ -3125,6 +3139,13 @@ void *mpp_enc_async_thread(void *data)
                 enc_async_wait_task(enc, info);
                 hal_task_hnd_set_status(hnd, TASK_IDLE);
                 wait.task_hnd = 0;
+
+                /*
+                 * NOTE: Do not sleep on empty input while there are still
+                 * tasks on hardware. Check input again then finish the next
+                 * task so the packets are not held until next frame comes.
+                 */
+                wait.enc_frm_in = 0;
             }
 
             continue;
@@ -16,10 +16,12 @@
 
 #define  MODULE_TAG "mpp_enc"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_lock.h"
 #include "mpp_info.h"
 #include "mpp_common.h"
 #include "mpp_2str.h"
@@ -31,6 +33,25 @@
 #include "mpp_enc_cb_param.h"
 
 RK_U32 mpp_enc_debug = 0;
+static RK_U32 mpp_enc_rc_trace_idx = 0;
+
+static void mpp_enc_rc_trace_init(MppEncImpl *p)
+{
+    const char *prefix = NULL;
+    char path[256];
+
+    mpp_env_get_str("mpp_enc_rc_trace", &prefix, NULL);
+    if (NULL == prefix || !prefix[0])
+        return;
+
+    snprintf(path, sizeof(path) - 1, "%s_%d.txt", prefix,
+             MPP_FETCH_ADD(&mpp_enc_rc_trace_idx, 1));
+
+    if (rc_trace_init(&p->rc_trace, path, 1))
+        mpp_err_f("failed to open rc trace %s\n", path);
+    else
+        mpp_log("enc %p record rc trace to %s\n", p, path);
+}
 
 MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
 {
@@ -117,6 +138,8 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     if (enc_hal_cfg.cap_recn_out)
         p->support_hw_deflicker = 1;
 
+    mpp_enc_rc_trace_init(p);
+
     {
         // create header packet storage
         size_t size = SZ_4K;
@@ -195,6 +218,11 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
         enc->rc_ctx = NULL;
     }
 
+    if (enc->rc_trace) {
+        rc_trace_deinit(enc->rc_trace);
+        enc->rc_trace = NULL;
+    }
+
     MPP_FREE(enc->rc_cfg_info);
     enc->rc_cfg_size = 0;
     enc->rc_cfg_length = 0;
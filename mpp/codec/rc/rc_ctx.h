@@ -19,6 +19,18 @@
 #include "mpp_rc_api.h"
 #include "rc_base.h"
 
+/*
+ * qp decided on hal start for the frames not ended yet
+ * multiple task encoder starts next frame before previous frame ends
+ */
+#define RC_FRM_QP_SLOT      8
+
+typedef struct RcFrmQp_t {
+    RK_S32          seq_idx;
+    RK_S32          scale_qp;
+    RK_S32          start_qp;
+} RcFrmQp;
+
 typedef struct RcModelV2Ctx_t {
     RcCfg           usr_cfg;
 
@@ -90,6 +102,7 @@ typedef struct RcModelV2Ctx_t {
     RK_S32          gop_qp_sum;
     RK_S32          gop_frm_cnt;
     RK_S32          pre_iblk4_prop;
+    RcFrmQp         frm_qp[RC_FRM_QP_SLOT];
 
     RK_S32          reenc_cnt;
     RK_U32          drop_cnt;
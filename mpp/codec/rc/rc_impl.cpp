@@ -30,6 +30,7 @@
 #include "jpege_rc.h"
 #include "vp8e_rc.h"
 #include "rc_model_v2_smt.h"
+#include "rc_model_v2_la.h"
 
 const RcImplApi *rc_apis[] = {
     &default_h264e,
@@ -38,6 +39,8 @@ const RcImplApi *rc_apis[] = {
     &default_vp8e,
     &smt_h264e,
     &smt_h265e,
+    &la_h264e,
+    &la_h265e,
 };
 
 // use class to register RcImplApi
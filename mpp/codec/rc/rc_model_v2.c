@@ -1317,15 +1317,46 @@ MPP_RET check_re_enc(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
 }
 
 
+static void frm_qp_save(RcModelV2Ctx *p, EncFrmStatus *frm)
+{
+    RcFrmQp *qp = &p->frm_qp[frm->seq_idx % RC_FRM_QP_SLOT];
+
+    qp->seq_idx = frm->seq_idx;
+    qp->scale_qp = p->cur_scale_qp;
+    qp->start_qp = p->start_qp;
+}
+
+/*
+ * Get the qp saved on hal start of the frame. When the frame is not started
+ * by rc_model_v2_hal_start the current qp is used as before.
+ */
+static void frm_qp_load(RcModelV2Ctx *p, EncFrmStatus *frm, RcFrmQp *qp)
+{
+    RcFrmQp *slot = &p->frm_qp[frm->seq_idx % RC_FRM_QP_SLOT];
+
+    if (slot->seq_idx == (RK_S32)frm->seq_idx) {
+        *qp = *slot;
+        return;
+    }
+
+    qp->seq_idx = frm->seq_idx;
+    qp->scale_qp = p->cur_scale_qp;
+    qp->start_qp = p->start_qp;
+}
+
 MPP_RET rc_model_v2_init(void *ctx, RcCfg *cfg)
 {
     RcModelV2Ctx *p = (RcModelV2Ctx*)ctx;
+    RK_S32 i;
 
     rc_dbg_func("enter %p\n", ctx);
 
     memcpy(&p->usr_cfg, cfg, sizeof(RcCfg));
     bits_model_init(p);
 
+    for (i = 0; i < RC_FRM_QP_SLOT; i++)
+        p->frm_qp[i].seq_idx = -1;
+
     rc_dbg_func("leave %p\n", ctx);
     return MPP_OK;
 }
@@ -1497,7 +1528,7 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
         info->quality_target = qp;
         info->quality_max = qp;
         info->quality_min = qp;
-        return MPP_OK;
+        goto DONE;
     }
 
     if (usr_cfg->mode == RC_FIXQP) {
@@ -1510,7 +1541,7 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
 
         info->quality_target = p->start_qp;
 
-        return MPP_OK;
+        goto DONE;
     }
 
     /* setup quality parameters */
@@ -1613,6 +1644,10 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
     rc_dbg_rc("quality [%d : %d : %d] -> [%d : %d : %d]\n",
               quality_min, quality_target, quality_max,
               info->quality_min, info->quality_target, info->quality_max);
+
+DONE:
+    frm_qp_save(p, frm);
+
     rc_dbg_func("leave %p\n", p);
     return MPP_OK;
 }
@@ -1621,13 +1656,16 @@ MPP_RET rc_model_v2_hal_end(void *ctx, EncRcTask *task)
 {
     RcModelV2Ctx *p = (RcModelV2Ctx *)ctx;
     EncFrmStatus *frm = &task->frm;
+    RcFrmQp qp;
 
     rc_dbg_func("enter ctx %p task %p\n", ctx, task);
 
+    frm_qp_load(p, frm, &qp);
+
     if (frm->is_intra)
-        p->pre_i_qp = p->cur_scale_qp >> 6;
+        p->pre_i_qp = qp.scale_qp >> 6;
     else
-        p->pre_p_qp = p->cur_scale_qp >> 6;
+        p->pre_p_qp = qp.scale_qp >> 6;
 
     rc_dbg_func("leave %p\n", ctx);
     return MPP_OK;
@@ -1697,6 +1735,7 @@ MPP_RET rc_model_v2_end(void *ctx, EncRcTask *task)
     RcModelV2Ctx *p = (RcModelV2Ctx *)ctx;
     EncRcTaskInfo *cfg = (EncRcTaskInfo *)&task->info;
     RcCfg *usr_cfg = &p->usr_cfg;
+    RcFrmQp qp;
 
     rc_dbg_func("enter ctx %p cfg %p\n", ctx, cfg);
 
@@ -1705,6 +1744,9 @@ MPP_RET rc_model_v2_end(void *ctx, EncRcTask *task)
     if (usr_cfg->mode == RC_FIXQP)
         goto DONE;
 
+    /* bits are replaced in the preset order and qp of this frame is used */
+    frm_qp_load(p, &task->frm, &qp);
+
     p->last_inst_bps = p->ins_bps;
     p->first_frm_flg = 0;
 
@@ -1715,11 +1757,11 @@ MPP_RET rc_model_v2_end(void *ctx, EncRcTask *task)
     }
 
     p->gop_frm_cnt++;
-    p->gop_qp_sum += p->start_qp;
+    p->gop_qp_sum += qp.start_qp;
 
     p->pre_mean_qp = cfg->quality_real;
     p->pre_iblk4_prop = cfg->iblk4_prop;
-    p->scale_qp = p->cur_scale_qp;
+    p->scale_qp = qp.scale_qp;
     p->prev_md_prop = 0;
     p->pre_target_bits = cfg->bit_target;
     p->pre_real_bits = cfg->bit_real;
@@ -0,0 +1,481 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_model_v2_la"
+
+#include <math.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_frame.h"
+#include "mpp_buffer.h"
+
+#include "rc_debug.h"
+#include "rc_ctx.h"
+#include "rc_model_v2.h"
+#include "rc_model_v2_la.h"
+
+/*
+ * Lookahead rate control
+ *
+ * The model is rc_model_v2 plus a cheap software pre-analysis of the input
+ * luma before the frame is sent to hardware:
+ *
+ * 1. luma is downscaled by 4 in each direction with 4x4 box average.
+ * 2. intra cost is the sum of absolute deviation to the mean of each 8x8
+ *    downscaled block and inter cost is the best SAD of a +-1 pixel search
+ *    in the previous downscaled frame limited by the intra cost.
+ * 3. the cost is compared with the last intra frame (intra) or the mean of
+ *    the last K inter frames (inter). The complexity ratio is split half to
+ *    bit allocation and half to qp so that complex frames get more bits on
+ *    the planned budget and the start qp already fits the content.
+ *
+ * rc_model_v2 still runs the bitrate feedback. Scene changes and complexity
+ * steps are absorbed by the planned qp instead of by re-encoding.
+ */
+#define RC_LA_DS_SHIFT          2
+#define RC_LA_BLK_SIZE          8
+#define RC_LA_SEARCH            1
+#define RC_LA_DEPTH_DEF         8
+#define RC_LA_DEPTH_MAX         16
+#define RC_LA_SLOT              8
+
+/* ratio in 1/256 */
+#define RC_LA_RATIO_ONE         256
+#define RC_LA_RATIO_MIN         (RC_LA_RATIO_ONE / 8)
+#define RC_LA_RATIO_MAX         (RC_LA_RATIO_ONE * 8)
+/* complexity step treated as scene change */
+#define RC_LA_SCENE_CUT_HI      (RC_LA_RATIO_ONE * 2)
+#define RC_LA_SCENE_CUT_LO      (RC_LA_RATIO_ONE / 2)
+/* max planned bit scale and qp offset */
+#define RC_LA_BIT_SCALE_MAX     2.0
+#define RC_LA_BIT_SCALE_MIN     0.5
+#define RC_LA_DQP_MAX           4
+
+typedef struct RcLaFrm_t {
+    RK_S32          seq_idx;
+    RK_S32          ratio;
+} RcLaFrm;
+
+typedef struct RcModelV2LaCtx_t {
+    /* rc_model_v2 context must be the first for model function reuse */
+    RcModelV2Ctx    base;
+
+    RK_S32          depth;
+
+    /* downscaled luma of current and previous frame */
+    RK_S32          ds_w;
+    RK_S32          ds_h;
+    RK_U8           *ds_buf;
+    RK_U8           *ds_curr;
+    RK_U8           *ds_prev;
+    RK_S32          prev_valid;
+
+    /* complexity history */
+    RK_S64          p_cost[RC_LA_DEPTH_MAX];
+    RK_S32          p_pos;
+    RK_S32          p_cnt;
+    RK_S64          i_cost;
+
+    RcLaFrm         frms[RC_LA_SLOT];
+} RcModelV2LaCtx;
+
+static void la_buf_deinit(RcModelV2LaCtx *p)
+{
+    MPP_FREE(p->ds_buf);
+    p->ds_curr = NULL;
+    p->ds_prev = NULL;
+    p->ds_w = 0;
+    p->ds_h = 0;
+}
+
+static MPP_RET la_buf_init(RcModelV2LaCtx *p, RK_S32 width, RK_S32 height)
+{
+    RK_S32 ds_w = width >> RC_LA_DS_SHIFT;
+    RK_S32 ds_h = height >> RC_LA_DS_SHIFT;
+
+    if (p->ds_buf && p->ds_w == ds_w && p->ds_h == ds_h)
+        return MPP_OK;
+
+    la_buf_deinit(p);
+
+    if (ds_w < RC_LA_BLK_SIZE || ds_h < RC_LA_BLK_SIZE)
+        return MPP_NOK;
+
+    p->ds_buf = mpp_malloc(RK_U8, ds_w * ds_h * 2);
+    if (NULL == p->ds_buf) {
+        mpp_err_f("failed to malloc %dx%d downscale buffer\n", ds_w, ds_h);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->ds_w = ds_w;
+    p->ds_h = ds_h;
+    p->ds_curr = p->ds_buf;
+    p->ds_prev = p->ds_buf + ds_w * ds_h;
+
+    return MPP_OK;
+}
+
+static RK_S32 la_fmt_supported(MppFrameFormat fmt)
+{
+    MppFrameFormat base = (MppFrameFormat)(fmt & MPP_FRAME_FMT_MASK);
+
+    if (!MPP_FRAME_FMT_IS_YUV(fmt) || MPP_FRAME_FMT_IS_FBC(fmt) ||
+        MPP_FRAME_FMT_IS_YUV_10BIT(fmt))
+        return 0;
+
+    /* packed yuv422 has no separated luma plane */
+    if (base >= MPP_FMT_YUV422_YUYV && base <= MPP_FMT_YUV422_VYUY)
+        return 0;
+
+    if (base == MPP_FMT_YUV444SP_10BIT)
+        return 0;
+
+    return 1;
+}
+
+static MPP_RET la_downscale(RcModelV2LaCtx *p, MppFrame frame)
+{
+    MppBuffer buf;
+    RK_U8 *src;
+    RK_S32 stride;
+    RK_S32 x, y;
+
+    if (NULL == frame || !la_fmt_supported(mpp_frame_get_fmt(frame)))
+        return MPP_NOK;
+
+    buf = mpp_frame_get_buffer(frame);
+    if (NULL == buf)
+        return MPP_NOK;
+
+    src = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    if (NULL == src)
+        return MPP_NOK;
+
+    if (la_buf_init(p, mpp_frame_get_width(frame), mpp_frame_get_height(frame)))
+        return MPP_NOK;
+
+    stride = mpp_frame_get_hor_stride(frame);
+    src += mpp_frame_get_offset_y(frame) * stride + mpp_frame_get_offset_x(frame);
+
+    /* input is usually dma-buf written by camera or gpu */
+    mpp_buffer_sync_ro_begin(buf);
+
+    for (y = 0; y < p->ds_h; y++) {
+        RK_U8 *row = src + (y << RC_LA_DS_SHIFT) * stride;
+        RK_U8 *dst = p->ds_curr + y * p->ds_w;
+
+        for (x = 0; x < p->ds_w; x++) {
+            RK_U8 *blk = row + (x << RC_LA_DS_SHIFT);
+            RK_S32 sum = 0;
+            RK_S32 i, j;
+
+            for (j = 0; j < (1 << RC_LA_DS_SHIFT); j++)
+                for (i = 0; i < (1 << RC_LA_DS_SHIFT); i++)
+                    sum += blk[j * stride + i];
+
+            dst[x] = (sum + (1 << (RC_LA_DS_SHIFT * 2 - 1))) >> (RC_LA_DS_SHIFT * 2);
+        }
+    }
+
+    mpp_buffer_sync_ro_end(buf);
+
+    return MPP_OK;
+}
+
+static RK_S32 la_blk_sad(RK_U8 *curr, RK_U8 *prev, RK_S32 stride)
+{
+    RK_S32 sad = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < RC_LA_BLK_SIZE; y++)
+        for (x = 0; x < RC_LA_BLK_SIZE; x++)
+            sad += abs(curr[y * stride + x] - prev[y * stride + x]);
+
+    return sad;
+}
+
+static void la_calc_cost(RcModelV2LaCtx *p, RK_S64 *intra, RK_S64 *inter)
+{
+    RK_S32 stride = p->ds_w;
+    RK_S32 blk_w = p->ds_w / RC_LA_BLK_SIZE;
+    RK_S32 blk_h = p->ds_h / RC_LA_BLK_SIZE;
+    RK_S64 intra_sum = 0;
+    RK_S64 inter_sum = 0;
+    RK_S32 bx, by, x, y;
+
+    for (by = 0; by < blk_h; by++) {
+        for (bx = 0; bx < blk_w; bx++) {
+            RK_S32 pos_x = bx * RC_LA_BLK_SIZE;
+            RK_S32 pos_y = by * RC_LA_BLK_SIZE;
+            RK_U8 *curr = p->ds_curr + pos_y * stride + pos_x;
+            RK_S32 sum = 0;
+            RK_S32 mean;
+            RK_S32 dev = 0;
+            RK_S32 best;
+            RK_S32 dx, dy;
+
+            for (y = 0; y < RC_LA_BLK_SIZE; y++)
+                for (x = 0; x < RC_LA_BLK_SIZE; x++)
+                    sum += curr[y * stride + x];
+
+            mean = (sum + RC_LA_BLK_SIZE * RC_LA_BLK_SIZE / 2) /
+                   (RC_LA_BLK_SIZE * RC_LA_BLK_SIZE);
+
+            for (y = 0; y < RC_LA_BLK_SIZE; y++)
+                for (x = 0; x < RC_LA_BLK_SIZE; x++)
+                    dev += abs(curr[y * stride + x] - mean);
+
+            /* +-1 downscaled pixel search covers +-4 pixel motion */
+            best = dev;
+            for (dy = -RC_LA_SEARCH; dy <= RC_LA_SEARCH; dy++) {
+                if (pos_y + dy < 0 || pos_y + dy + RC_LA_BLK_SIZE > p->ds_h)
+                    continue;
+
+                for (dx = -RC_LA_SEARCH; dx <= RC_LA_SEARCH; dx++) {
+                    RK_U8 *prev = p->ds_prev + (pos_y + dy) * stride + pos_x + dx;
+
+                    if (pos_x + dx < 0 || pos_x + dx + RC_LA_BLK_SIZE > p->ds_w)
+                        continue;
+
+                    best = MPP_MIN(best, la_blk_sad(curr, prev, stride));
+                }
+            }
+
+            intra_sum += dev;
+            inter_sum += best;
+        }
+    }
+
+    /* avoid zero cost on flat content */
+    *intra = intra_sum + blk_w * blk_h;
+    *inter = inter_sum + blk_w * blk_h;
+}
+
+static RK_S32 la_analyze(RcModelV2LaCtx *p, EncRcTask *task)
+{
+    EncFrmStatus *frm = &task->frm;
+    RK_S64 intra = 0;
+    RK_S64 inter = 0;
+    RK_S64 ref = 0;
+    RK_S32 ratio = RC_LA_RATIO_ONE;
+    RK_U8 *tmp;
+
+    if (la_downscale(p, task->frame)) {
+        p->prev_valid = 0;
+        return ratio;
+    }
+
+    la_calc_cost(p, &intra, &inter);
+
+    if (frm->is_intra) {
+        ref = p->i_cost;
+        p->i_cost = intra;
+    } else if (p->prev_valid) {
+        RK_S32 i;
+
+        for (i = 0; i < p->p_cnt; i++)
+            ref += p->p_cost[i];
+
+        if (p->p_cnt)
+            ref /= p->p_cnt;
+    }
+
+    if (ref > 0) {
+        RK_S64 cost = frm->is_intra ? intra : inter;
+
+        ratio = (RK_S32)(cost * RC_LA_RATIO_ONE / ref);
+        ratio = mpp_clip(ratio, RC_LA_RATIO_MIN, RC_LA_RATIO_MAX);
+    }
+
+    if (!frm->is_intra && p->prev_valid) {
+        /* restart history on scene change so the next frames are not offset again */
+        if (ratio >= RC_LA_SCENE_CUT_HI || ratio <= RC_LA_SCENE_CUT_LO) {
+            p->p_pos = 0;
+            p->p_cnt = 0;
+        }
+
+        p->p_cost[p->p_pos] = inter;
+        p->p_pos = (p->p_pos + 1) % p->depth;
+        if (p->p_cnt < p->depth)
+            p->p_cnt++;
+    }
+
+    rc_dbg_rc("la seq_idx %d intra %d cost %lld:%lld ref %lld ratio %d\n",
+              frm->seq_idx, frm->is_intra, intra, inter, ref, ratio);
+
+    tmp = p->ds_prev;
+    p->ds_prev = p->ds_curr;
+    p->ds_curr = tmp;
+    p->prev_valid = 1;
+
+    return ratio;
+}
+
+static RcLaFrm *la_frm_get(RcModelV2LaCtx *p, EncFrmStatus *frm)
+{
+    RcLaFrm *slot = &p->frms[frm->seq_idx % RC_LA_SLOT];
+
+    return (slot->seq_idx == (RK_S32)frm->seq_idx) ? slot : NULL;
+}
+
+MPP_RET rc_model_v2_la_init(void *ctx, RcCfg *cfg)
+{
+    RcModelV2LaCtx *p = (RcModelV2LaCtx *)ctx;
+    RK_U32 depth = 0;
+    RK_S32 i;
+
+    rc_dbg_func("enter %p\n", ctx);
+
+    rc_model_v2_init(ctx, cfg);
+
+    mpp_env_get_u32("rc_la_depth", &depth, RC_LA_DEPTH_DEF);
+    p->depth = mpp_clip((RK_S32)depth, 1, RC_LA_DEPTH_MAX);
+
+    /* complexity history is restarted on config change */
+    p->prev_valid = 0;
+    p->p_pos = 0;
+    p->p_cnt = 0;
+    p->i_cost = 0;
+
+    for (i = 0; i < RC_LA_SLOT; i++)
+        p->frms[i].seq_idx = -1;
+
+    rc_dbg_func("leave %p\n", ctx);
+    return MPP_OK;
+}
+
+MPP_RET rc_model_v2_la_deinit(void *ctx)
+{
+    RcModelV2LaCtx *p = (RcModelV2LaCtx *)ctx;
+
+    rc_dbg_func("enter %p\n", ctx);
+
+    la_buf_deinit(p);
+    rc_model_v2_deinit(ctx);
+
+    rc_dbg_func("leave %p\n", ctx);
+    return MPP_OK;
+}
+
+MPP_RET rc_model_v2_la_start(void *ctx, EncRcTask *task)
+{
+    RcModelV2LaCtx *p = (RcModelV2LaCtx *)ctx;
+    EncFrmStatus *frm = &task->frm;
+    EncRcTaskInfo *info = &task->info;
+    RcLaFrm *slot = &p->frms[frm->seq_idx % RC_LA_SLOT];
+    RK_S32 ratio = la_analyze(p, task);
+    MPP_RET ret;
+
+    rc_dbg_func("enter %p\n", ctx);
+
+    ret = rc_model_v2_start(ctx, task);
+
+    slot->seq_idx = frm->seq_idx;
+    slot->ratio = ratio;
+
+    if (p->base.usr_cfg.mode != RC_FIXQP && ratio != RC_LA_RATIO_ONE &&
+        info->bit_target > 0) {
+        /* half of the complexity change goes to the bit allocation */
+        double scale = sqrt((double)ratio / RC_LA_RATIO_ONE);
+        RK_S32 bit_target;
+
+        scale = MPP_CLIP3(RC_LA_BIT_SCALE_MIN, RC_LA_BIT_SCALE_MAX, scale);
+        bit_target = (RK_S32)(info->bit_target * scale);
+        if (info->bit_max > 0)
+            bit_target = MPP_MIN(bit_target, info->bit_max);
+        if (info->bit_min > 0)
+            bit_target = MPP_MAX(bit_target, info->bit_min);
+
+        rc_dbg_rc("la bit target %d -> %d\n", info->bit_target, bit_target);
+        info->bit_target = bit_target;
+    }
+
+    rc_dbg_func("leave %p\n", ctx);
+    return ret;
+}
+
+MPP_RET rc_model_v2_la_hal_start(void *ctx, EncRcTask *task)
+{
+    RcModelV2LaCtx *p = (RcModelV2LaCtx *)ctx;
+    EncFrmStatus *frm = &task->frm;
+    EncRcTaskInfo *info = &task->info;
+    RcCfg *usr_cfg = &p->base.usr_cfg;
+    RcLaFrm *slot;
+    RK_S32 dqp;
+    RK_S32 qp;
+    MPP_RET ret;
+
+    rc_dbg_func("enter %p\n", ctx);
+
+    ret = rc_model_v2_hal_start(ctx, task);
+
+    if (usr_cfg->mode == RC_FIXQP || (task->force.force_flag & ENC_RC_FORCE_QP))
+        goto DONE;
+
+    slot = la_frm_get(p, frm);
+    if (NULL == slot || slot->ratio == RC_LA_RATIO_ONE || info->quality_target <= 0)
+        goto DONE;
+
+    /* the other half of the complexity change goes to the qp */
+    dqp = (RK_S32)floor(3.0 * log2((double)slot->ratio / RC_LA_RATIO_ONE) + 0.5);
+    dqp = mpp_clip(dqp, -RC_LA_DQP_MAX, RC_LA_DQP_MAX);
+    if (!dqp)
+        goto DONE;
+
+    qp = mpp_clip(info->quality_target + dqp, info->quality_min, info->quality_max);
+    if (frm->is_intra)
+        qp = mpp_clip(qp, usr_cfg->fqp_min_i, usr_cfg->fqp_max_i);
+    else
+        qp = mpp_clip(qp, usr_cfg->fqp_min_p, usr_cfg->fqp_max_p);
+
+    rc_dbg_rc("la qp %d -> %d ratio %d\n", info->quality_target, qp, slot->ratio);
+    info->quality_target = qp;
+
+DONE:
+    rc_dbg_func("leave %p\n", ctx);
+    return ret;
+}
+
+const RcImplApi la_h264e = {
+    "lookahead",
+    MPP_VIDEO_CodingAVC,
+    sizeof(RcModelV2LaCtx),
+    rc_model_v2_la_init,
+    rc_model_v2_la_deinit,
+    NULL,
+    rc_model_v2_check_reenc,
+    rc_model_v2_la_start,
+    rc_model_v2_end,
+    rc_model_v2_la_hal_start,
+    rc_model_v2_hal_end,
+};
+
+const RcImplApi la_h265e = {
+    "lookahead",
+    MPP_VIDEO_CodingHEVC,
+    sizeof(RcModelV2LaCtx),
+    rc_model_v2_la_init,
+    rc_model_v2_la_deinit,
+    NULL,
+    rc_model_v2_check_reenc,
+    rc_model_v2_la_start,
+    rc_model_v2_end,
+    rc_model_v2_la_hal_start,
+    rc_model_v2_hal_end,
+};
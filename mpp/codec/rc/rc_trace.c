@@ -0,0 +1,303 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_trace"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "rc_debug.h"
+#include "rc_trace.h"
+
+#define RC_TRACE_LINE_SIZE      4096
+
+typedef struct RcTraceImpl_t {
+    FILE            *fp;
+    RK_S32          write;
+    RK_S32          line;
+    char            *buf;
+} RcTraceImpl;
+
+typedef struct RcTraceKey_t {
+    const char      *name;
+    size_t          offset;
+} RcTraceKey;
+
+/* all recorded RcCfg members are 32bit integer or enum */
+#define RC_TRACE_KEY(field)     { #field, offsetof(RcCfg, field) }
+
+static const RcTraceKey rc_trace_keys[] = {
+    RC_TRACE_KEY(width),
+    RC_TRACE_KEY(height),
+    RC_TRACE_KEY(mode),
+    RC_TRACE_KEY(fps.fps_in_flex),
+    RC_TRACE_KEY(fps.fps_in_num),
+    RC_TRACE_KEY(fps.fps_in_denom),
+    RC_TRACE_KEY(fps.fps_out_flex),
+    RC_TRACE_KEY(fps.fps_out_num),
+    RC_TRACE_KEY(fps.fps_out_denom),
+    RC_TRACE_KEY(gop_mode),
+    RC_TRACE_KEY(igop),
+    RC_TRACE_KEY(vgop),
+    RC_TRACE_KEY(bps_min),
+    RC_TRACE_KEY(bps_target),
+    RC_TRACE_KEY(bps_max),
+    RC_TRACE_KEY(stats_time),
+    RC_TRACE_KEY(max_i_bit_prop),
+    RC_TRACE_KEY(min_i_bit_prop),
+    RC_TRACE_KEY(init_ip_ratio),
+    RC_TRACE_KEY(layer_bit_prop[0]),
+    RC_TRACE_KEY(layer_bit_prop[1]),
+    RC_TRACE_KEY(layer_bit_prop[2]),
+    RC_TRACE_KEY(layer_bit_prop[3]),
+    RC_TRACE_KEY(init_quality),
+    RC_TRACE_KEY(max_quality),
+    RC_TRACE_KEY(min_quality),
+    RC_TRACE_KEY(max_i_quality),
+    RC_TRACE_KEY(min_i_quality),
+    RC_TRACE_KEY(i_quality_delta),
+    RC_TRACE_KEY(vi_quality_delta),
+    RC_TRACE_KEY(fqp_min_i),
+    RC_TRACE_KEY(fqp_min_p),
+    RC_TRACE_KEY(fqp_max_i),
+    RC_TRACE_KEY(fqp_max_p),
+    RC_TRACE_KEY(max_reencode_times),
+    RC_TRACE_KEY(drop_mode),
+    RC_TRACE_KEY(drop_thd),
+    RC_TRACE_KEY(drop_gap),
+    RC_TRACE_KEY(super_cfg.super_mode),
+    RC_TRACE_KEY(super_cfg.super_i_thd),
+    RC_TRACE_KEY(super_cfg.super_p_thd),
+    RC_TRACE_KEY(super_cfg.rc_priority),
+    RC_TRACE_KEY(debreath_cfg.enable),
+    RC_TRACE_KEY(debreath_cfg.strength),
+    RC_TRACE_KEY(hier_qp_cfg.hier_qp_en),
+    RC_TRACE_KEY(hier_qp_cfg.hier_qp_delta[0]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_qp_delta[1]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_qp_delta[2]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_qp_delta[3]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_frame_num[0]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_frame_num[1]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_frame_num[2]),
+    RC_TRACE_KEY(hier_qp_cfg.hier_frame_num[3]),
+    RC_TRACE_KEY(refresh_len),
+    RC_TRACE_KEY(scene_mode),
+    RC_TRACE_KEY(fps_chg_prop),
+};
+
+MPP_RET rc_trace_init(RcTrace *trace, const char *path, RK_S32 write)
+{
+    RcTraceImpl *p = NULL;
+    FILE *fp = NULL;
+
+    if (NULL == trace || NULL == path) {
+        mpp_err_f("invalid input trace %p path %p\n", trace, path);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *trace = NULL;
+
+    fp = fopen(path, write ? "w" : "r");
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", path);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    p = mpp_calloc(RcTraceImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        fclose(fp);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->fp = fp;
+    p->write = write;
+
+    if (write) {
+        fprintf(fp, "# mpp rc trace\n");
+        fprintf(fp, "# frm seq_idx frame_type is_intra is_idr ref_mode temporal_id "
+                "bit_target bit_real quality_target quality_real madi madp iblk4_prop sse\n");
+    } else {
+        p->buf = mpp_malloc(char, RC_TRACE_LINE_SIZE);
+        if (NULL == p->buf) {
+            mpp_err_f("failed to malloc line buffer\n");
+            fclose(fp);
+            MPP_FREE(p);
+            return MPP_ERR_MALLOC;
+        }
+    }
+
+    *trace = p;
+    return MPP_OK;
+}
+
+MPP_RET rc_trace_deinit(RcTrace trace)
+{
+    RcTraceImpl *p = (RcTraceImpl *)trace;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    if (p->fp) {
+        fclose(p->fp);
+        p->fp = NULL;
+    }
+
+    MPP_FREE(p->buf);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_trace_put_cfg(RcTrace trace, MppCodingType type, const char *name, RcCfg *cfg)
+{
+    RcTraceImpl *p = (RcTraceImpl *)trace;
+    RK_U32 i;
+
+    if (NULL == p || !p->write || NULL == cfg)
+        return MPP_ERR_NULL_PTR;
+
+    fprintf(p->fp, "cfg type=%d rc=%s", type, name ? name : "default");
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(rc_trace_keys); i++) {
+        const RcTraceKey *key = &rc_trace_keys[i];
+        RK_S32 val = *(RK_S32 *)((RK_U8 *)cfg + key->offset);
+
+        fprintf(p->fp, " %s=%d", key->name, val);
+    }
+
+    fprintf(p->fp, "\n");
+    fflush(p->fp);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_trace_put_frm(RcTrace trace, EncRcTask *task)
+{
+    RcTraceImpl *p = (RcTraceImpl *)trace;
+    EncFrmStatus *frm;
+    EncRcTaskInfo *info;
+
+    if (NULL == p || !p->write || NULL == task)
+        return MPP_ERR_NULL_PTR;
+
+    frm = &task->frm;
+    info = &task->info;
+
+    fprintf(p->fp, "frm %d %d %d %d %d %d %d %d %d %d %d %d %u %lld\n",
+            frm->seq_idx, info->frame_type, frm->is_intra, frm->is_idr,
+            frm->ref_mode, frm->temporal_id,
+            info->bit_target, info->bit_real,
+            info->quality_target, info->quality_real,
+            info->madi, info->madp, info->iblk4_prop, (long long)info->sse);
+
+    return MPP_OK;
+}
+
+static void rc_trace_get_cfg(RcTraceImpl *p, char *str, MppCodingType *type, RcCfg *cfg)
+{
+    char token[64];
+    RK_S32 len = 0;
+
+    memset(cfg, 0, sizeof(*cfg));
+
+    while (sscanf(str, "%63s%n", token, &len) == 1) {
+        char *val = strchr(token, '=');
+        RK_U32 i;
+
+        str += len;
+
+        if (NULL == val)
+            continue;
+
+        *val++ = '\0';
+
+        if (!strcmp(token, "type")) {
+            if (type)
+                *type = (MppCodingType)strtol(val, NULL, 0);
+            continue;
+        }
+
+        for (i = 0; i < MPP_ARRAY_ELEMS(rc_trace_keys); i++) {
+            const RcTraceKey *key = &rc_trace_keys[i];
+
+            if (!strcmp(token, key->name)) {
+                *(RK_S32 *)((RK_U8 *)cfg + key->offset) = (RK_S32)strtol(val, NULL, 0);
+                break;
+            }
+        }
+
+        /* unknown keys like rc api name are informative only */
+        if (i >= MPP_ARRAY_ELEMS(rc_trace_keys))
+            rc_dbg_impl("line %d skip key %s\n", p->line, token);
+    }
+}
+
+static MPP_RET rc_trace_get_frm(RcTraceImpl *p, char *str, RcTraceFrm *frm)
+{
+    RK_S32 frame_type = 0;
+    long long sse = 0;
+    RK_S32 cnt;
+
+    memset(frm, 0, sizeof(*frm));
+
+    cnt = sscanf(str, "%d %d %d %d %d %d %d %d %d %d %d %d %u %lld",
+                 &frm->seq_idx, &frame_type, &frm->is_intra, &frm->is_idr,
+                 &frm->ref_mode, &frm->temporal_id,
+                 &frm->bit_target, &frm->bit_real,
+                 &frm->quality_target, &frm->quality_real,
+                 &frm->madi, &frm->madp, &frm->iblk4_prop, &sse);
+    if (cnt != 14) {
+        mpp_err_f("line %d invalid frame record with %d fields\n", p->line, cnt);
+        return MPP_NOK;
+    }
+
+    frm->frame_type = (EncFrmType)frame_type;
+    frm->sse = sse;
+
+    return MPP_OK;
+}
+
+RcTraceRec rc_trace_get(RcTrace trace, MppCodingType *type, RcCfg *cfg, RcTraceFrm *frm)
+{
+    RcTraceImpl *p = (RcTraceImpl *)trace;
+
+    if (NULL == p || p->write)
+        return RC_TRACE_REC_NONE;
+
+    while (fgets(p->buf, RC_TRACE_LINE_SIZE, p->fp)) {
+        char *str = p->buf;
+
+        p->line++;
+
+        if (!strncmp(str, "cfg ", 4)) {
+            if (cfg) {
+                rc_trace_get_cfg(p, str + 4, type, cfg);
+                return RC_TRACE_REC_CFG;
+            }
+        } else if (!strncmp(str, "frm ", 4)) {
+            if (frm && !rc_trace_get_frm(p, str + 4, frm))
+                return RC_TRACE_REC_FRM;
+        }
+    }
+
+    return RC_TRACE_REC_NONE;
+}
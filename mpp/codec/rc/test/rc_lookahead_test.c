@@ -0,0 +1,625 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_lookahead_test"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_frame.h"
+#include "mpp_buffer.h"
+
+#include "rc.h"
+
+/*
+ * Compare rc api on the same yuv input with a software hardware model.
+ *
+ * The hardware model measures the real content cost on full resolution luma
+ * (16x16 block deviation for intra and small range motion searched SAD for
+ * inter) and converts it to bits on the qp selected by rc. So the rc under
+ * test only sees the frame and the returned bits like on real hardware.
+ *
+ * Without yuv input a synthetic clip with scene changes, texture and motion
+ * steps is generated.
+ */
+#define LA_TEST_RC_MAX          4
+#define LA_TEST_BLK             16
+#define LA_TEST_SEARCH          4
+#define LA_TEST_FPS             30
+/* bits per unit cost at qp 30 */
+#define LA_TEST_BIT_SCALE       0.08
+
+typedef struct LaTestCfg_t {
+    const char      *file;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          frm_cnt;
+    RK_S32          bps;
+    RK_S32          gop;
+    RcMode          mode;
+    const char      *rc_names[LA_TEST_RC_MAX];
+    RK_S32          rc_cnt;
+} LaTestCfg;
+
+typedef struct LaTestSrc_t {
+    FILE            *fp;
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          frm_size;
+
+    /* synthetic scene */
+    RK_U32          seed;
+    RK_S32          scene_end;
+    RK_S32          amp;
+    RK_S32          shift;
+    RK_S32          vx;
+    RK_S32          vy;
+    RK_U32          scene_seed;
+} LaTestSrc;
+
+typedef struct LaTestStat_t {
+    RK_S32          frames;
+    RK_S32          reenc;
+    RK_S64          bits;
+    double          bps_err;
+    double          qp_avg;
+    double          qp_std;
+    double          qp_delta;
+    /* max bitrate over one second window */
+    double          peak_err;
+    RK_S64          rc_time;
+} LaTestStat;
+
+static RK_U32 la_hash(RK_U32 x, RK_U32 y, RK_U32 seed)
+{
+    RK_U32 h = x * 0x8da6b343 ^ y * 0xd8163841 ^ seed * 0xcb1ab31f;
+
+    h ^= h >> 13;
+    h *= 0x5bd1e995;
+    h ^= h >> 15;
+    return h;
+}
+
+static void la_src_synth_scene(LaTestSrc *src, RK_S32 idx)
+{
+    RK_U32 *seed = &src->seed;
+
+    *seed = la_hash(idx, 7, *seed);
+    src->scene_end = idx + 40 + (*seed % 80);
+    *seed = la_hash(idx, 11, *seed);
+    src->amp = 4 + (*seed % 56);
+    *seed = la_hash(idx, 13, *seed);
+    src->shift = 1 + (*seed % 3);
+    *seed = la_hash(idx, 17, *seed);
+    src->vx = (RK_S32)(*seed % 9) - 4;
+    *seed = la_hash(idx, 19, *seed);
+    src->vy = (RK_S32)(*seed % 5) - 2;
+    src->scene_seed = *seed;
+}
+
+static void la_src_synth(LaTestSrc *src, RK_S32 idx, RK_U8 *dst)
+{
+    RK_S32 x, y;
+
+    if (idx == 0 || idx >= src->scene_end)
+        la_src_synth_scene(src, idx);
+
+    for (y = 0; y < src->height; y++) {
+        RK_S32 sy = (y + src->vy * idx) >> src->shift;
+        RK_U8 *row = dst + y * src->width;
+
+        for (x = 0; x < src->width; x++) {
+            RK_S32 sx = (x + src->vx * idx) >> src->shift;
+            RK_S32 tex = (RK_S32)(la_hash(sx, sy, src->scene_seed) & 0xff) - 128;
+            RK_S32 noise = (RK_S32)(la_hash(x, y, idx) & 0x3) - 2;
+
+            row[x] = mpp_clip(128 + tex * src->amp / 128 + noise, 0, 255);
+        }
+    }
+
+    /* chroma is flat */
+    memset(dst + src->width * src->height, 128, src->width * src->height / 2);
+}
+
+static MPP_RET la_src_open(LaTestSrc *src, LaTestCfg *cfg)
+{
+    memset(src, 0, sizeof(*src));
+    src->width = cfg->width;
+    src->height = cfg->height;
+    src->frm_size = cfg->width * cfg->height * 3 / 2;
+    src->seed = 1;
+
+    if (cfg->file) {
+        src->fp = fopen(cfg->file, "rb");
+        if (NULL == src->fp) {
+            mpp_err("failed to open %s\n", cfg->file);
+            return MPP_ERR_OPEN_FILE;
+        }
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET la_src_read(LaTestSrc *src, RK_S32 idx, RK_U8 *dst)
+{
+    if (NULL == src->fp) {
+        la_src_synth(src, idx, dst);
+        return MPP_OK;
+    }
+
+    if (fread(dst, 1, src->frm_size, src->fp) != (size_t)src->frm_size)
+        return MPP_NOK;
+
+    return MPP_OK;
+}
+
+static void la_src_close(LaTestSrc *src)
+{
+    if (src->fp) {
+        fclose(src->fp);
+        src->fp = NULL;
+    }
+}
+
+static RK_S32 la_blk_dev(RK_U8 *src, RK_S32 stride)
+{
+    RK_S32 sum = 0;
+    RK_S32 dev = 0;
+    RK_S32 mean;
+    RK_S32 x, y;
+
+    for (y = 0; y < LA_TEST_BLK; y++)
+        for (x = 0; x < LA_TEST_BLK; x++)
+            sum += src[y * stride + x];
+
+    mean = (sum + LA_TEST_BLK * LA_TEST_BLK / 2) / (LA_TEST_BLK * LA_TEST_BLK);
+
+    for (y = 0; y < LA_TEST_BLK; y++)
+        for (x = 0; x < LA_TEST_BLK; x++)
+            dev += abs(src[y * stride + x] - mean);
+
+    return dev;
+}
+
+static const RK_S32 la_dia[4][2] = {
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+};
+
+/* SAD on even rows for motion search */
+static RK_S32 la_blk_sad(RK_U8 *src, RK_U8 *ref, RK_S32 stride)
+{
+    RK_S32 sad = 0;
+    RK_S32 x, y;
+
+    for (y = 0; y < LA_TEST_BLK; y += 2)
+        for (x = 0; x < LA_TEST_BLK; x++)
+            sad += abs(src[y * stride + x] - ref[y * stride + x]);
+
+    return sad * 2;
+}
+
+/* content cost measured on full resolution with motion search for inter */
+static RK_S64 la_hw_cost(RK_U8 *curr, RK_U8 *prev, RK_S32 width, RK_S32 height,
+                         RK_S32 intra)
+{
+    RK_S32 margin = intra ? 0 : LA_TEST_SEARCH;
+    RK_S64 cost = 0;
+    RK_S32 bx, by;
+
+    for (by = margin; by + LA_TEST_BLK + margin <= height; by += LA_TEST_BLK) {
+        for (bx = margin; bx + LA_TEST_BLK + margin <= width; bx += LA_TEST_BLK) {
+            RK_U8 *src = curr + by * width + bx;
+            RK_S32 best = la_blk_dev(src, width);
+
+            if (!intra) {
+                /* small diamond search around the best position */
+                RK_S32 mvx = 0;
+                RK_S32 mvy = 0;
+                RK_S32 step;
+
+                best = MPP_MIN(best, la_blk_sad(src, prev + by * width + bx, width));
+
+                for (step = 0; step < LA_TEST_SEARCH * 2; step++) {
+                    RK_S32 best_x = mvx;
+                    RK_S32 best_y = mvy;
+                    RK_S32 k;
+
+                    for (k = 0; k < 4; k++) {
+                        RK_S32 dx = mvx + la_dia[k][0];
+                        RK_S32 dy = mvy + la_dia[k][1];
+                        RK_S32 sad;
+
+                        if (abs(dx) > LA_TEST_SEARCH || abs(dy) > LA_TEST_SEARCH)
+                            continue;
+
+                        sad = la_blk_sad(src, prev + (by + dy) * width + bx + dx, width);
+                        if (sad < best) {
+                            best = sad;
+                            best_x = dx;
+                            best_y = dy;
+                        }
+                    }
+
+                    if (best_x == mvx && best_y == mvy)
+                        break;
+
+                    mvx = best_x;
+                    mvy = best_y;
+                }
+            }
+
+            cost += best;
+        }
+    }
+
+    return cost;
+}
+
+/* the content is the same for all rc so the hardware cost is measured once */
+static MPP_RET la_hw_cost_prepare(LaTestCfg *cfg, RK_S64 *costs)
+{
+    RK_S32 frm_size = cfg->width * cfg->height * 3 / 2;
+    RK_U8 *buf = mpp_malloc(RK_U8, frm_size * 2);
+    LaTestSrc src;
+    RK_S32 i;
+    MPP_RET ret;
+
+    if (NULL == buf)
+        return MPP_ERR_MALLOC;
+
+    ret = la_src_open(&src, cfg);
+    if (ret) {
+        MPP_FREE(buf);
+        return ret;
+    }
+
+    for (i = 0; i < cfg->frm_cnt; i++) {
+        RK_U8 *curr = buf + (i & 1) * frm_size;
+        RK_U8 *prev = buf + !(i & 1) * frm_size;
+
+        if (la_src_read(&src, i, curr))
+            break;
+
+        costs[i] = la_hw_cost(curr, prev, cfg->width, cfg->height,
+                              (i % cfg->gop) == 0);
+    }
+
+    /* input may be shorter than the requested frame count */
+    cfg->frm_cnt = i;
+
+    la_src_close(&src);
+    MPP_FREE(buf);
+
+    return MPP_OK;
+}
+
+static void la_hw_model(RcCfg *cfg, RK_S64 cost, EncRcTaskInfo *info)
+{
+    RK_S32 qp = info->quality_target > 0 ? info->quality_target : 30;
+    RK_S32 mbs = MPP_ALIGN(cfg->width, 16) * MPP_ALIGN(cfg->height, 16) / 256;
+
+    if (info->quality_max > 0)
+        qp = mpp_clip(qp, info->quality_min, info->quality_max);
+
+    info->bit_real = (RK_S32)(cost * LA_TEST_BIT_SCALE * pow(2.0, (30 - qp) / 6.0)) + mbs;
+    info->quality_real = qp;
+    info->madi = (RK_S32)(cost / mbs / 256);
+    info->madp = info->madi;
+}
+
+static void la_clr_hw_info(EncRcTaskInfo *info)
+{
+    EncRcTaskInfo bak = *info;
+
+    memset(info, 0, sizeof(*info));
+
+    info->frame_type = bak.frame_type;
+    info->bit_target = bak.bit_target;
+    info->bit_max = bak.bit_max;
+    info->bit_min = bak.bit_min;
+    info->quality_target = bak.quality_target;
+    info->quality_max = bak.quality_max;
+    info->quality_min = bak.quality_min;
+}
+
+static void la_setup_rc_cfg(LaTestCfg *cfg, RcCfg *rc)
+{
+    memset(rc, 0, sizeof(*rc));
+
+    rc->width = cfg->width;
+    rc->height = cfg->height;
+    rc->mode = cfg->mode;
+    rc->fps.fps_in_num = LA_TEST_FPS;
+    rc->fps.fps_in_denom = 1;
+    rc->fps.fps_out_num = LA_TEST_FPS;
+    rc->fps.fps_out_denom = 1;
+    rc->igop = cfg->gop;
+    rc->bps_target = cfg->bps;
+    rc->bps_max = cfg->bps * 17 / 16;
+    rc->bps_min = (cfg->mode == RC_CBR) ? cfg->bps * 15 / 16 : cfg->bps / 16;
+    rc->stats_time = 3;
+    rc->max_i_bit_prop = 30;
+    rc->min_i_bit_prop = 10;
+    rc->init_ip_ratio = 160;
+    rc->layer_bit_prop[0] = 256;
+    rc->init_quality = -1;
+    rc->max_quality = 51;
+    rc->min_quality = 10;
+    rc->max_i_quality = 51;
+    rc->min_i_quality = 10;
+    rc->i_quality_delta = 2;
+    rc->fqp_min_i = rc->min_i_quality;
+    rc->fqp_min_p = rc->min_quality;
+    rc->fqp_max_i = rc->max_i_quality;
+    rc->fqp_max_p = rc->max_quality;
+    rc->max_reencode_times = 1;
+}
+
+static MPP_RET la_test_run(LaTestCfg *cfg, const char *rc_name, RK_S64 *costs,
+                           LaTestStat *stat)
+{
+    const char *name = rc_name;
+    MppBufferGroup group = NULL;
+    MppBuffer buf[2] = { NULL, NULL };
+    MppFrame frame = NULL;
+    RcCtx ctx = NULL;
+    LaTestSrc src;
+    RcCfg rc_cfg;
+    RK_S32 luma_size = cfg->width * cfg->height;
+    RK_S32 frm_size = luma_size * 3 / 2;
+    RK_S32 mb_cnt;
+    double qp_sum = 0;
+    double qp_sum2 = 0;
+    double qp_delta_sum = 0;
+    RK_S32 qp_delta_cnt = 0;
+    RK_S32 qp_prev = -1;
+    RK_S32 win_bits[LA_TEST_FPS];
+    RK_S64 win_sum = 0;
+    RK_S64 win_max = 0;
+    RK_S32 i;
+    MPP_RET ret;
+
+    memset(stat, 0, sizeof(*stat));
+    memset(win_bits, 0, sizeof(win_bits));
+
+    ret = la_src_open(&src, cfg);
+    if (ret)
+        return ret;
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (ret)
+        goto DONE;
+
+    /* double buffer keeps the previous frame valid like encoder input */
+    ret = mpp_buffer_get(group, &buf[0], frm_size);
+    if (!ret)
+        ret = mpp_buffer_get(group, &buf[1], frm_size);
+    if (ret)
+        goto DONE;
+
+    ret = rc_init(&ctx, MPP_VIDEO_CodingAVC, &name);
+    if (ret || NULL == ctx) {
+        mpp_err("failed to init rc %s\n", rc_name);
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    la_setup_rc_cfg(cfg, &rc_cfg);
+    rc_update_usr_cfg(ctx, &rc_cfg);
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, cfg->width);
+    mpp_frame_set_height(frame, cfg->height);
+    mpp_frame_set_hor_stride(frame, cfg->width);
+    mpp_frame_set_ver_stride(frame, cfg->height);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420P);
+
+    mb_cnt = MPP_ALIGN(cfg->width, 16) * MPP_ALIGN(cfg->height, 16) / 256;
+
+    for (i = 0; i < cfg->frm_cnt; i++) {
+        RK_U8 *curr = (RK_U8 *)mpp_buffer_get_ptr(buf[i & 1]);
+        EncRcTask task;
+        EncFrmStatus *frm = &task.frm;
+        EncRcTaskInfo *info = &task.info;
+        RK_S32 reenc = 0;
+        RK_S64 start;
+
+        if (la_src_read(&src, i, curr))
+            break;
+
+        memset(&task, 0, sizeof(task));
+        frm->valid = 1;
+        frm->seq_idx = i;
+        frm->is_intra = (i % cfg->gop) == 0;
+        frm->is_idr = frm->is_intra;
+
+        mpp_frame_set_buffer(frame, buf[i & 1]);
+        task.frame = frame;
+
+        start = mpp_time();
+        rc_frm_start(ctx, &task);
+
+        /* the same order as mpp_enc_normal and the reencode loop */
+        while (1) {
+            rc_hal_start(ctx, &task);
+            stat->rc_time += mpp_time() - start;
+
+            la_hw_model(&rc_cfg, costs[i], info);
+
+            start = mpp_time();
+            rc_hal_end(ctx, &task);
+            rc_frm_check_reenc(ctx, &task);
+
+            if (!frm->reencode || reenc >= rc_cfg.max_reencode_times)
+                break;
+
+            if (frm->drop || frm->force_pskip) {
+                info->bit_real = mb_cnt;
+                info->quality_real = info->quality_target;
+                break;
+            }
+
+            la_clr_hw_info(info);
+            stat->reenc++;
+            reenc++;
+        }
+
+        rc_frm_end(ctx, &task);
+        stat->rc_time += mpp_time() - start;
+
+        stat->bits += info->bit_real;
+        stat->frames++;
+
+        win_sum += info->bit_real - win_bits[i % LA_TEST_FPS];
+        win_bits[i % LA_TEST_FPS] = info->bit_real;
+        if (i >= LA_TEST_FPS - 1)
+            win_max = MPP_MAX(win_max, win_sum);
+
+        qp_sum += info->quality_target;
+        qp_sum2 += (double)info->quality_target * info->quality_target;
+        if (!frm->is_intra && qp_prev >= 0) {
+            qp_delta_sum += abs(info->quality_target - qp_prev);
+            qp_delta_cnt++;
+        }
+        qp_prev = info->quality_target;
+    }
+
+    if (stat->frames) {
+        double bps = stat->bits * (double)LA_TEST_FPS / stat->frames;
+
+        stat->bps_err = (bps - cfg->bps) * 100.0 / cfg->bps;
+        stat->peak_err = (win_max - cfg->bps) * 100.0 / cfg->bps;
+        stat->qp_avg = qp_sum / stat->frames;
+        stat->qp_std = sqrt(MPP_MAX(qp_sum2 / stat->frames - stat->qp_avg * stat->qp_avg, 0));
+    }
+    if (qp_delta_cnt)
+        stat->qp_delta = qp_delta_sum / qp_delta_cnt;
+
+DONE:
+    if (ctx)
+        rc_deinit(ctx);
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (buf[0])
+        mpp_buffer_put(buf[0]);
+    if (buf[1])
+        mpp_buffer_put(buf[1]);
+    if (group)
+        mpp_buffer_group_put(group);
+    la_src_close(&src);
+
+    return ret;
+}
+
+static void la_test_usage(void)
+{
+    mpp_log("usage: rc_lookahead_test [-i yuv] [-w width] [-h height] [-n frames] "
+            "[-b bps] [-g gop] [-m cbr|vbr] [-r rc_name]\n");
+    mpp_log("  -i   8bit yuv420 input, synthetic clip when not set\n");
+    mpp_log("  -r   rc api name to compare, can be repeated, "
+            "default \"default\" and \"lookahead\"\n");
+}
+
+int main(int argc, char **argv)
+{
+    LaTestCfg cfg;
+    RK_S64 *costs = NULL;
+    RK_S32 fail = 0;
+    RK_S32 i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.width = 640;
+    cfg.height = 360;
+    cfg.frm_cnt = 300;
+    cfg.bps = 1000000;
+    cfg.gop = 60;
+    cfg.mode = RC_CBR;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        const char *val = argv[i + 1];
+
+        if (!strcmp(argv[i], "-i"))
+            cfg.file = val;
+        else if (!strcmp(argv[i], "-w"))
+            cfg.width = atoi(val);
+        else if (!strcmp(argv[i], "-h"))
+            cfg.height = atoi(val);
+        else if (!strcmp(argv[i], "-n"))
+            cfg.frm_cnt = atoi(val);
+        else if (!strcmp(argv[i], "-b"))
+            cfg.bps = atoi(val);
+        else if (!strcmp(argv[i], "-g"))
+            cfg.gop = atoi(val);
+        else if (!strcmp(argv[i], "-m"))
+            cfg.mode = strcmp(val, "vbr") ? RC_CBR : RC_VBR;
+        else if (!strcmp(argv[i], "-r")) {
+            if (cfg.rc_cnt < LA_TEST_RC_MAX)
+                cfg.rc_names[cfg.rc_cnt++] = val;
+        } else {
+            la_test_usage();
+            return -1;
+        }
+    }
+
+    if (cfg.width < LA_TEST_BLK || cfg.height < LA_TEST_BLK || cfg.gop <= 0 ||
+        cfg.bps <= 0) {
+        la_test_usage();
+        return -1;
+    }
+
+    if (!cfg.rc_cnt) {
+        cfg.rc_names[cfg.rc_cnt++] = "default";
+        cfg.rc_names[cfg.rc_cnt++] = "lookahead";
+    }
+
+    mpp_log("rc lookahead test %dx%d %d frames %s %d bps gop %d from %s\n",
+            cfg.width, cfg.height, cfg.frm_cnt, cfg.mode == RC_CBR ? "cbr" : "vbr",
+            cfg.bps, cfg.gop, cfg.file ? cfg.file : "synthetic");
+
+    costs = mpp_calloc(RK_S64, cfg.frm_cnt);
+    if (NULL == costs || la_hw_cost_prepare(&cfg, costs)) {
+        mpp_err("failed to prepare hardware cost\n");
+        MPP_FREE(costs);
+        return -1;
+    }
+
+    for (i = 0; i < cfg.rc_cnt; i++) {
+        LaTestStat stat;
+
+        if (la_test_run(&cfg, cfg.rc_names[i], costs, &stat)) {
+            fail++;
+            continue;
+        }
+
+        mpp_log("%-10s frames %d bitrate err %6.2f%% peak %6.2f%% qp avg %5.2f std %5.2f "
+                "delta %4.2f reenc %3d rc %4lld us/frame\n",
+                cfg.rc_names[i], stat.frames, stat.bps_err, stat.peak_err, stat.qp_avg,
+                stat.qp_std, stat.qp_delta, stat.reenc,
+                stat.frames ? stat.rc_time / stat.frames : 0);
+    }
+
+    MPP_FREE(costs);
+
+    mpp_log("rc lookahead test %s\n", fail ? "failed" : "done");
+
+    return fail ? -1 : 0;
+}
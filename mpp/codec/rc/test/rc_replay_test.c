@@ -0,0 +1,596 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_replay_test"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_frame.h"
+
+#include "rc.h"
+#include "rc_trace.h"
+
+/*
+ * Replay recorded rc trace through a registered RcImplApi on host.
+ *
+ * The trace is recorded by encoder with env mpp_enc_rc_trace=<prefix>. Each
+ * cfg record starts a new sequence. Without trace input the test generates
+ * synthetic sequences.
+ *
+ * Hardware is modeled from the recorded frame: the bit cost doubles on every
+ * 6 qp decrease relative to the recorded qp and sse follows the square of
+ * quantization step. The other statistic is passed through as recorded.
+ */
+#define REPLAY_MAX_FILES        16
+
+typedef struct RcReplayCfg_t {
+    const char      *rc_name;
+    const char      *files[REPLAY_MAX_FILES];
+    RK_S32          file_cnt;
+    const char      *dump;
+    RK_S32          seq_cnt;
+    RK_S32          frm_cnt;
+    RK_S32          verbose;
+} RcReplayCfg;
+
+typedef struct RcReplaySeq_t {
+    MppCodingType   type;
+    RcCfg           cfg;
+    RcTraceFrm      *frms;
+    RK_S32          frm_cnt;
+    RK_S32          frm_size;
+} RcReplaySeq;
+
+typedef struct RcReplayStat_t {
+    RK_S32          frames;
+    RK_S32          reenc;
+    RK_S32          drop;
+    RK_S64          bits;
+
+    /* bitrate accuracy in percent of target */
+    double          bps;
+    double          bps_err;
+    /* qp of encoded frames */
+    double          qp_avg;
+    double          qp_std;
+    /* one second virtual buffer fullness in percent */
+    double          buf_max;
+    double          buf_avg;
+    RK_S32          buf_over;
+} RcReplayStat;
+
+static MPP_RET replay_seq_add_frm(RcReplaySeq *seq, RcTraceFrm *frm)
+{
+    if (seq->frm_cnt >= seq->frm_size) {
+        RK_S32 size = seq->frm_size ? seq->frm_size * 2 : 256;
+        RcTraceFrm *frms = mpp_realloc(seq->frms, RcTraceFrm, size);
+
+        if (NULL == frms) {
+            mpp_err_f("failed to realloc %d frames\n", size);
+            return MPP_ERR_MALLOC;
+        }
+
+        seq->frms = frms;
+        seq->frm_size = size;
+    }
+
+    seq->frms[seq->frm_cnt++] = *frm;
+    return MPP_OK;
+}
+
+static MPP_RET replay_load(const char *path, RcReplaySeq **seqs, RK_S32 *seq_cnt)
+{
+    RcTrace trace = NULL;
+    RcReplaySeq *seq = NULL;
+    MppCodingType type = MPP_VIDEO_CodingAVC;
+    RcTraceFrm frm;
+    RcCfg cfg;
+    RcTraceRec rec;
+    MPP_RET ret;
+
+    ret = rc_trace_init(&trace, path, 0);
+    if (ret)
+        return ret;
+
+    while ((rec = rc_trace_get(trace, &type, &cfg, &frm)) != RC_TRACE_REC_NONE) {
+        if (rec == RC_TRACE_REC_CFG) {
+            RcReplaySeq *p = mpp_realloc(*seqs, RcReplaySeq, *seq_cnt + 1);
+
+            if (NULL == p) {
+                ret = MPP_ERR_MALLOC;
+                break;
+            }
+
+            seq = &p[*seq_cnt];
+            memset(seq, 0, sizeof(*seq));
+            seq->type = type;
+            seq->cfg = cfg;
+
+            *seqs = p;
+            *seq_cnt += 1;
+            continue;
+        }
+
+        if (NULL == seq) {
+            mpp_err("%s frame %d found before rc cfg\n", path, frm.seq_idx);
+            continue;
+        }
+
+        ret = replay_seq_add_frm(seq, &frm);
+        if (ret)
+            break;
+    }
+
+    rc_trace_deinit(trace);
+    return ret;
+}
+
+static RK_U32 replay_rand(RK_U32 *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7fff;
+}
+
+/* uniform random value in [lo, hi) */
+static double replay_rand_range(RK_U32 *seed, double lo, double hi)
+{
+    return lo + (hi - lo) * replay_rand(seed) / 32768.0;
+}
+
+static MPP_RET replay_synth(RcReplaySeq *seq, RK_S32 idx, RK_S32 frm_cnt)
+{
+    static const RK_S32 bps_list[] = {
+        1000000, 2000000, 4000000, 8000000,
+    };
+    RcCfg *cfg = &seq->cfg;
+    RK_U32 seed = idx + 1;
+    double cplx = replay_rand_range(&seed, 0.3, 2.5);
+    RK_S32 i;
+
+    memset(seq, 0, sizeof(*seq));
+    seq->type = MPP_VIDEO_CodingAVC;
+
+    /* the same default as h264e with mpi_enc_test cbr / vbr setup */
+    cfg->width = 1920;
+    cfg->height = 1080;
+    cfg->mode = (idx & 1) ? RC_VBR : RC_CBR;
+    cfg->fps.fps_in_num = 30;
+    cfg->fps.fps_in_denom = 1;
+    cfg->fps.fps_out_num = 30;
+    cfg->fps.fps_out_denom = 1;
+    cfg->igop = 60;
+    cfg->bps_target = bps_list[(idx >> 1) % MPP_ARRAY_ELEMS(bps_list)];
+    if (cfg->mode == RC_CBR) {
+        cfg->bps_max = cfg->bps_target * 17 / 16;
+        cfg->bps_min = cfg->bps_target * 15 / 16;
+    } else {
+        cfg->bps_max = cfg->bps_target * 17 / 16;
+        cfg->bps_min = cfg->bps_target / 16;
+    }
+    cfg->stats_time = 3;
+    cfg->max_i_bit_prop = 30;
+    cfg->min_i_bit_prop = 10;
+    cfg->init_ip_ratio = 160;
+    cfg->layer_bit_prop[0] = 256;
+    cfg->init_quality = -1;
+    cfg->max_quality = 51;
+    cfg->min_quality = 10;
+    cfg->max_i_quality = 51;
+    cfg->min_i_quality = 10;
+    cfg->i_quality_delta = 2;
+    cfg->fqp_min_i = cfg->min_i_quality;
+    cfg->fqp_min_p = cfg->min_quality;
+    cfg->fqp_max_i = cfg->max_i_quality;
+    cfg->fqp_max_p = cfg->max_quality;
+    cfg->max_reencode_times = 1;
+
+    for (i = 0; i < frm_cnt; i++) {
+        RcTraceFrm frm;
+        double bits;
+
+        /* scene change with new complexity */
+        if (replay_rand(&seed) % 150 == 0)
+            cplx = replay_rand_range(&seed, 0.3, 2.5);
+
+        memset(&frm, 0, sizeof(frm));
+        frm.seq_idx = i;
+        frm.is_intra = (i % cfg->igop) == 0;
+        frm.is_idr = frm.is_intra;
+        frm.frame_type = frm.is_intra ? INTRA_FRAME : INTER_P_FRAME;
+
+        /* 2Mbps at qp 30 for average content */
+        bits = 2000000 / 30 * cplx * replay_rand_range(&seed, 0.8, 1.2);
+        if (frm.is_intra)
+            bits *= replay_rand_range(&seed, 4.0, 8.0);
+
+        frm.bit_real = (RK_S32)bits;
+        frm.bit_target = frm.bit_real;
+        frm.quality_target = 30;
+        frm.quality_real = 30;
+        frm.madi = (RK_S32)(cplx * 8);
+        frm.madp = frm.is_intra ? 0 : (RK_S32)(cplx * 4);
+        frm.sse = (RK_S64)(bits * 64);
+
+        if (replay_seq_add_frm(seq, &frm))
+            return MPP_ERR_MALLOC;
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET replay_dump(const char *path, RcReplaySeq *seqs, RK_S32 seq_cnt)
+{
+    RcTrace trace = NULL;
+    RK_S32 i, j;
+    MPP_RET ret;
+
+    ret = rc_trace_init(&trace, path, 1);
+    if (ret)
+        return ret;
+
+    for (i = 0; i < seq_cnt; i++) {
+        RcReplaySeq *seq = &seqs[i];
+
+        rc_trace_put_cfg(trace, seq->type, NULL, &seq->cfg);
+
+        for (j = 0; j < seq->frm_cnt; j++) {
+            RcTraceFrm *rec = &seq->frms[j];
+            EncRcTask task;
+
+            memset(&task, 0, sizeof(task));
+            task.frm.seq_idx = rec->seq_idx;
+            task.frm.is_intra = rec->is_intra;
+            task.frm.is_idr = rec->is_idr;
+            task.frm.ref_mode = (MppEncRefMode)rec->ref_mode;
+            task.frm.temporal_id = rec->temporal_id;
+            task.info.frame_type = rec->frame_type;
+            task.info.bit_target = rec->bit_target;
+            task.info.bit_real = rec->bit_real;
+            task.info.quality_target = rec->quality_target;
+            task.info.quality_real = rec->quality_real;
+            task.info.madi = rec->madi;
+            task.info.madp = rec->madp;
+            task.info.iblk4_prop = rec->iblk4_prop;
+            task.info.sse = rec->sse;
+
+            rc_trace_put_frm(trace, &task);
+        }
+    }
+
+    rc_trace_deinit(trace);
+    return MPP_OK;
+}
+
+static void replay_hw_model(RcReplaySeq *seq, RcTraceFrm *rec, EncRcTaskInfo *info)
+{
+    /*
+     * quality_real unit depends on hardware (average qp or qp sum) so the
+     * recorded quality_target is the reference and quality_real is scaled.
+     */
+    RK_S32 rec_qp = rec->quality_target > 0 ? rec->quality_target : rec->quality_real;
+    RK_S32 qp = info->quality_target;
+    double scale = 1.0;
+
+    if (qp <= 0)
+        qp = rec_qp;
+
+    if (info->quality_max > 0)
+        qp = mpp_clip(qp, info->quality_min, info->quality_max);
+
+    /* only qp domain codec can be scaled, jpeg quality factor passes through */
+    if ((seq->type == MPP_VIDEO_CodingAVC || seq->type == MPP_VIDEO_CodingHEVC) &&
+        rec_qp > 0)
+        scale = pow(2.0, (rec_qp - qp) / 6.0);
+
+    info->bit_real = (RK_S32)(rec->bit_real * scale);
+    info->quality_real = rec_qp > 0 ? (RK_S32)((RK_S64)rec->quality_real * qp / rec_qp) : qp;
+    info->madi = rec->madi;
+    info->madp = rec->madp;
+    info->iblk4_prop = rec->iblk4_prop;
+    info->sse = (RK_S64)(rec->sse / (scale * scale));
+}
+
+static void replay_clr_hw_info(EncRcTaskInfo *info)
+{
+    EncRcTaskInfo bak = *info;
+
+    memset(info, 0, sizeof(*info));
+
+    info->frame_type = bak.frame_type;
+    info->bit_target = bak.bit_target;
+    info->bit_max = bak.bit_max;
+    info->bit_min = bak.bit_min;
+    info->quality_target = bak.quality_target;
+    info->quality_max = bak.quality_max;
+    info->quality_min = bak.quality_min;
+}
+
+static MPP_RET replay_seq(RcReplayCfg *cfg, RcReplaySeq *seq, RcReplayStat *stat)
+{
+    const char *name = cfg->rc_name;
+    RcCfg usr_cfg = seq->cfg;
+    RcCtx ctx = NULL;
+    MppFrame frame = NULL;
+    RK_S32 fps_num = usr_cfg.fps.fps_out_num ? usr_cfg.fps.fps_out_num : 30;
+    RK_S32 fps_denom = usr_cfg.fps.fps_out_denom ? usr_cfg.fps.fps_out_denom : 1;
+    double fps = (double)fps_num / fps_denom;
+    double buf_size = usr_cfg.bps_target;
+    double buf_drain = usr_cfg.bps_target / fps;
+    double buf = 0;
+    double buf_sum = 0;
+    double qp_sum = 0;
+    double qp_sum2 = 0;
+    RK_S32 qp_cnt = 0;
+    RK_S32 i;
+    MPP_RET ret;
+
+    memset(stat, 0, sizeof(*stat));
+
+    ret = rc_init(&ctx, seq->type, &name);
+    if (ret || NULL == ctx) {
+        mpp_err("failed to init rc %s for coding %x\n", name, seq->type);
+        return MPP_NOK;
+    }
+
+    /* trace only holds the encoded frames so no frame rate conversion */
+    usr_cfg.fps.fps_in_flex = usr_cfg.fps.fps_out_flex;
+    usr_cfg.fps.fps_in_num = fps_num;
+    usr_cfg.fps.fps_in_denom = fps_denom;
+    rc_update_usr_cfg(ctx, &usr_cfg);
+
+    /* some rc model reads the frame size from input frame */
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, usr_cfg.width);
+    mpp_frame_set_height(frame, usr_cfg.height);
+    mpp_frame_set_hor_stride(frame, MPP_ALIGN(usr_cfg.width, 16));
+    mpp_frame_set_ver_stride(frame, MPP_ALIGN(usr_cfg.height, 16));
+
+    for (i = 0; i < seq->frm_cnt; i++) {
+        RcTraceFrm *rec = &seq->frms[i];
+        EncRcTask task;
+        EncFrmStatus *frm = &task.frm;
+        EncRcTaskInfo *info = &task.info;
+        RK_S32 reenc = 0;
+
+        memset(&task, 0, sizeof(task));
+        task.frame = frame;
+        frm->valid = 1;
+        frm->seq_idx = rec->seq_idx;
+        frm->is_intra = rec->is_intra;
+        frm->is_idr = rec->is_idr;
+        frm->ref_mode = (MppEncRefMode)rec->ref_mode;
+        frm->temporal_id = rec->temporal_id;
+
+        rc_frm_start(ctx, &task);
+
+        /* the same order as mpp_enc_normal and the reencode loop */
+        while (1) {
+            rc_hal_start(ctx, &task);
+            replay_hw_model(seq, rec, info);
+            rc_hal_end(ctx, &task);
+            rc_frm_check_reenc(ctx, &task);
+
+            if (!frm->reencode || reenc >= usr_cfg.max_reencode_times)
+                break;
+
+            if (frm->drop) {
+                info->bit_real = 0;
+                info->quality_real = info->quality_target;
+                stat->drop++;
+                break;
+            }
+
+            if (frm->force_pskip && !frm->is_idr && !frm->is_lt_ref) {
+                /* software pskip costs about one bit per macroblock */
+                info->bit_real = MPP_ALIGN(usr_cfg.width, 16) *
+                                 MPP_ALIGN(usr_cfg.height, 16) / 256;
+                info->quality_real = info->quality_target;
+                stat->drop++;
+                break;
+            }
+
+            frm->force_pskip = 0;
+            replay_clr_hw_info(info);
+            stat->reenc++;
+            reenc++;
+        }
+
+        rc_frm_end(ctx, &task);
+
+        stat->bits += info->bit_real;
+        stat->frames++;
+
+        /* qp decided by rc, quality_real may be in hardware unit */
+        if (!frm->drop && !frm->force_pskip) {
+            qp_sum += info->quality_target;
+            qp_sum2 += (double)info->quality_target * info->quality_target;
+            qp_cnt++;
+        }
+
+        buf += info->bit_real - buf_drain;
+        if (buf < 0)
+            buf = 0;
+        if (buf > buf_size)
+            stat->buf_over++;
+        if (buf > stat->buf_max)
+            stat->buf_max = buf;
+        buf_sum += buf;
+    }
+
+    rc_deinit(ctx);
+    mpp_frame_deinit(&frame);
+
+    if (stat->frames) {
+        stat->bps = stat->bits * fps / stat->frames;
+        buf_sum /= stat->frames;
+    }
+
+    if (usr_cfg.bps_target > 0) {
+        stat->bps_err = (stat->bps - usr_cfg.bps_target) * 100.0 / usr_cfg.bps_target;
+        stat->buf_max = stat->buf_max * 100.0 / buf_size;
+        stat->buf_avg = buf_sum * 100.0 / buf_size;
+    }
+
+    if (qp_cnt) {
+        stat->qp_avg = qp_sum / qp_cnt;
+        stat->qp_std = sqrt(MPP_MAX(qp_sum2 / qp_cnt - stat->qp_avg * stat->qp_avg, 0));
+    }
+
+    return MPP_OK;
+}
+
+static void replay_usage(void)
+{
+    mpp_log("usage: rc_replay_test [-i trace] [-r rc_name] [-n seq_cnt] [-f frm_cnt] [-o dump] [-v 1]\n");
+    mpp_log("  -i   recorded rc trace file, can be repeated\n");
+    mpp_log("  -r   rc api name, default \"default\"\n");
+    mpp_log("  -n   synthetic sequence count without trace, default 200\n");
+    mpp_log("  -f   synthetic frame count per sequence, default 300\n");
+    mpp_log("  -o   dump synthetic sequences to trace file\n");
+    mpp_log("  -v   print per sequence result\n");
+}
+
+int main(int argc, char **argv)
+{
+    RcReplayCfg cfg;
+    RcReplaySeq *seqs = NULL;
+    RK_S32 seq_cnt = 0;
+    RK_S32 fail = 0;
+    RK_S64 frames = 0;
+    RK_S64 reenc = 0;
+    RK_S64 drop = 0;
+    double err_sum = 0;
+    double err_max = 0;
+    double qp_std_sum = 0;
+    double buf_max = 0;
+    RK_S32 buf_over = 0;
+    RK_S64 time_start;
+    RK_S64 time_used;
+    RK_S32 i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    /* NULL name selects the default rc api quietly */
+    cfg.rc_name = NULL;
+    cfg.seq_cnt = 200;
+    cfg.frm_cnt = 300;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        const char *val = argv[i + 1];
+
+        if (!strcmp(argv[i], "-i")) {
+            if (cfg.file_cnt < REPLAY_MAX_FILES)
+                cfg.files[cfg.file_cnt++] = val;
+        } else if (!strcmp(argv[i], "-r"))
+            cfg.rc_name = val;
+        else if (!strcmp(argv[i], "-n"))
+            cfg.seq_cnt = atoi(val);
+        else if (!strcmp(argv[i], "-f"))
+            cfg.frm_cnt = atoi(val);
+        else if (!strcmp(argv[i], "-o"))
+            cfg.dump = val;
+        else if (!strcmp(argv[i], "-v"))
+            cfg.verbose = atoi(val);
+        else {
+            replay_usage();
+            return -1;
+        }
+    }
+
+    mpp_log("rc replay test start\n");
+
+    if (cfg.file_cnt) {
+        for (i = 0; i < cfg.file_cnt; i++) {
+            if (replay_load(cfg.files[i], &seqs, &seq_cnt)) {
+                mpp_err("failed to load trace %s\n", cfg.files[i]);
+                fail++;
+            }
+        }
+    } else {
+        seqs = mpp_calloc(RcReplaySeq, cfg.seq_cnt);
+        if (NULL == seqs) {
+            mpp_err("failed to malloc %d sequences\n", cfg.seq_cnt);
+            return -1;
+        }
+
+        for (i = 0; i < cfg.seq_cnt; i++) {
+            if (replay_synth(&seqs[i], i, cfg.frm_cnt))
+                break;
+        }
+        seq_cnt = i;
+
+        if (cfg.dump)
+            replay_dump(cfg.dump, seqs, seq_cnt);
+    }
+
+    time_start = mpp_time();
+
+    for (i = 0; i < seq_cnt; i++) {
+        RcReplaySeq *seq = &seqs[i];
+        RcReplayStat stat;
+        double err;
+
+        if (replay_seq(&cfg, seq, &stat)) {
+            fail++;
+            continue;
+        }
+
+        err = fabs(stat.bps_err);
+        err_sum += err;
+        if (err > err_max)
+            err_max = err;
+        qp_std_sum += stat.qp_std;
+        if (stat.buf_max > buf_max)
+            buf_max = stat.buf_max;
+        buf_over += stat.buf_over;
+        frames += stat.frames;
+        reenc += stat.reenc;
+        drop += stat.drop;
+
+        if (cfg.verbose)
+            mpp_log("seq %4d %s target %8d real %8.0f err %6.2f%% qp %5.2f std %5.2f "
+                    "buf max %6.2f%% avg %6.2f%% over %d reenc %d drop %d\n",
+                    i, seq->cfg.mode == RC_CBR ? "cbr" : "vbr", seq->cfg.bps_target,
+                    stat.bps, stat.bps_err, stat.qp_avg, stat.qp_std,
+                    stat.buf_max, stat.buf_avg, stat.buf_over, stat.reenc, stat.drop);
+    }
+
+    time_used = mpp_time() - time_start;
+
+    if (seq_cnt) {
+        mpp_log("rc %s replay %d sequences %lld frames in %lld ms\n",
+                cfg.rc_name ? cfg.rc_name : "default", seq_cnt, frames, time_used / 1000);
+        mpp_log("bitrate error avg %.2f%% max %.2f%%\n", err_sum / seq_cnt, err_max);
+        mpp_log("qp std avg %.2f\n", qp_std_sum / seq_cnt);
+        mpp_log("buffer fullness max %.2f%% overflow frames %d\n", buf_max, buf_over);
+        mpp_log("reenc %lld drop %lld\n", reenc, drop);
+        mpp_log("speed %.0f sequences per minute\n",
+                time_used ? seq_cnt * 60.0 * 1000000 / time_used : 0);
+    }
+
+    for (i = 0; i < seq_cnt; i++)
+        MPP_FREE(seqs[i].frms);
+    MPP_FREE(seqs);
+
+    mpp_log("rc replay test %s\n", fail ? "failed" : "done");
+
+    return fail ? -1 : 0;
+}
@@ -23,6 +23,7 @@
 #include "mpp_mem.h"
 #include "mpp_common.h"
 #include "mpp_dmabuf.h"
+#include "mpp_startcode.h"
 #include "mpp_packet_impl.h"
 
 #include "mpp_enc_cfg.h"
@@ -35,8 +36,6 @@
 #include "h264e_pps.h"
 #include "h264e_slice.h"
 
-#define START_CODE 0x000001 ///< start_code_prefix_one_3bytes
-
 static RK_S32 get_next_nal(RK_U8 *buf, RK_S32 *length)
 {
     RK_S32 i, consumed = 0;
@@ -52,19 +51,11 @@ static RK_S32 get_next_nal(RK_U8 *buf, RK_S32 *length)
         }
 
         if (tmp_buf[0] != 0 || tmp_buf[1] != 0 || tmp_buf[2] != 1) {
-            RK_U32 state = (RK_U32) - 1;
-            RK_S32 has_nal = 0;
-
-            for (i = 0; i < (RK_S32)len; i++) {
-                state = (state << 8) | tmp_buf[i];
-                if (((state >> 8) & 0xFFFFFF) == START_CODE) {
-                    has_nal = 1;
-                    i = i - 3;
-                    break;
-                }
-            }
+            /* start code followed by at least one byte */
+            RK_S32 pos = mpp_find_start_code(tmp_buf, len - 1, 0xffffffff);
 
-            if (has_nal) {
+            if (pos >= 0) {
+                i = pos - 2;
                 len -= i;
                 tmp_buf += i;
                 consumed = *length - len - 1;
@@ -82,6 +73,42 @@ static RK_S32 get_next_nal(RK_U8 *buf, RK_S32 *length)
     return consumed;
 }
 
+static void amend_sync_begin(MppPacket pkt, RK_S32 base, RK_S32 len, const char *caller)
+{
+    MppBuffer buf = mpp_packet_get_buffer(pkt);
+
+    /* packet on plain memory has no buffer to sync */
+    if (buf)
+        mpp_dmabuf_sync_partial_begin(mpp_buffer_get_fd(buf), 1, base, len, caller);
+}
+
+/*
+ * The slice data move shifts in the bytes after the source nal end. Clear the
+ * bits after rbsp_stop_one_bit in the last byte so they do not leak out.
+ */
+static void amend_clear_tail(RK_U8 *buf, RK_S32 bit_len)
+{
+    if (bit_len & 7)
+        buf[bit_len / 8] &= 0xff << (8 - (bit_len & 7));
+}
+
+static void amend_buf_check(HalH264eVepuStreamAmend *ctx, RK_S32 len)
+{
+    RK_S32 more_buf = 0;
+
+    while (len > ctx->buf_size - 16) {
+        ctx->buf_size *= 2;
+        more_buf = 1;
+    }
+
+    if (more_buf) {
+        MPP_FREE(ctx->src_buf);
+        MPP_FREE(ctx->dst_buf);
+        ctx->src_buf = mpp_malloc(RK_U8, ctx->buf_size);
+        ctx->dst_buf = mpp_malloc(RK_U8, ctx->buf_size);
+    }
+}
+
 MPP_RET h264e_vepu_stream_amend_init(HalH264eVepuStreamAmend *ctx)
 {
     memset(ctx, 0, sizeof(*ctx));
@@ -93,6 +120,7 @@ MPP_RET h264e_vepu_stream_amend_deinit(HalH264eVepuStreamAmend *ctx)
 {
     MPP_FREE(ctx->src_buf);
     MPP_FREE(ctx->dst_buf);
+    MPP_FREE(ctx->segs);
     return MPP_OK;
 }
 
@@ -118,6 +146,7 @@ MPP_RET h264e_vepu_stream_amend_config(HalH264eVepuStreamAmend *ctx,
     } else {
         MPP_FREE(ctx->dst_buf);
         MPP_FREE(ctx->src_buf);
+        MPP_FREE(ctx->segs);
         h264e_vepu_stream_amend_init(ctx);
     }
 
@@ -135,7 +164,8 @@ MPP_RET h264e_vepu_stream_amend_config(HalH264eVepuStreamAmend *ctx,
     return MPP_OK;
 }
 
-MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwCfg *hw_cfg)
+/* copy the whole stream through src_buf and dst_buf, kept for verification */
+MPP_RET h264e_vepu_stream_amend_proc_c(HalH264eVepuStreamAmend *ctx, MppEncH264HwCfg *hw_cfg)
 {
     H264ePrefixNal *prefix = ctx->prefix;
     H264eSlice *slice = ctx->slice;
@@ -163,27 +193,9 @@ MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwC
         }
     }
 
-    {
-        MppBuffer buf = mpp_packet_get_buffer(pkt);
-        RK_S32 fd = mpp_buffer_get_fd(buf);
-
-        mpp_dmabuf_sync_partial_begin(fd, 1, base, len, __FUNCTION__);
-    }
-
-    {
-        RK_S32 more_buf = 0;
-        while (len > ctx->buf_size - 16) {
-            ctx->buf_size *= 2;
-            more_buf = 1;
-        }
+    amend_sync_begin(pkt, base, len, __FUNCTION__);
 
-        if (more_buf) {
-            MPP_FREE(ctx->src_buf);
-            MPP_FREE(ctx->dst_buf);
-            ctx->src_buf = mpp_malloc(RK_U8, ctx->buf_size);
-            ctx->dst_buf = mpp_malloc(RK_U8, ctx->buf_size);
-        }
-    }
+    amend_buf_check(ctx, len);
 
     memset(ctx->dst_buf, 0, ctx->buf_size);
     memset(ctx->src_buf, 0, ctx->buf_size);
@@ -288,6 +300,8 @@ MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwC
             RK_S32 bit_len = nal_len * 8 - tail_0bit + hdr_diff_bit;
             RK_S32 new_len = (bit_len + diff_size * 8 + 7) / 8;
 
+            amend_clear_tail(dst_buf, bit_len + diff_size * 8);
+
             hal_h264e_dbg_amend("frm %4d %c len %d bit hw %d sw %d byte hw %d sw %d diff %d -> %d\n",
                                 slice->frame_num, (slice->idr_flag ? 'I' : 'P'),
                                 nal_len, hw_len_bit, sw_len_bit,
@@ -325,6 +339,265 @@ MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwC
     return MPP_OK;
 }
 
+static HalH264eAmendSeg *amend_seg_get(HalH264eVepuStreamAmend *ctx, RK_S32 idx)
+{
+    if (idx >= ctx->seg_size) {
+        RK_S32 size = ctx->seg_size ? ctx->seg_size * 2 : 16;
+        HalH264eAmendSeg *segs = mpp_realloc(ctx->segs, HalH264eAmendSeg, size);
+
+        if (NULL == segs)
+            return NULL;
+
+        ctx->segs = segs;
+        ctx->seg_size = size;
+    }
+
+    return &ctx->segs[idx];
+}
+
+/*
+ * Join the new headers in dst_buf and the slice bodies left in the stream.
+ * When all bodies move to the same direction they are moved in place, from
+ * the last one when moving backward and from the first one when moving
+ * forward, so no body is overwritten before it is moved. Otherwise the
+ * stream is assembled in src_buf and copied back.
+ */
+static void amend_splice(HalH264eVepuStreamAmend *ctx, RK_U8 *p, RK_S32 seg_cnt)
+{
+    HalH264eAmendSeg *segs = ctx->segs;
+    RK_S32 shift_min = 0;
+    RK_S32 shift_max = 0;
+    RK_S32 pos = 0;
+    RK_S32 i;
+
+    for (i = 0; i < seg_cnt; i++) {
+        HalH264eAmendSeg *seg = &segs[i];
+
+        seg->out_pos = pos;
+        pos += seg->hdr_len;
+
+        if (seg->body_len) {
+            shift_min = MPP_MIN(shift_min, pos - seg->body_pos);
+            shift_max = MPP_MAX(shift_max, pos - seg->body_pos);
+        }
+
+        pos += seg->body_len;
+    }
+
+    if (shift_min < 0 && shift_max > 0) {
+        RK_U8 *out = ctx->src_buf;
+
+        hal_h264e_dbg_amend("splice %d slices shift [%d %d] by copy\n",
+                            seg_cnt, shift_min, shift_max);
+
+        for (i = 0; i < seg_cnt; i++) {
+            HalH264eAmendSeg *seg = &segs[i];
+
+            memcpy(out + seg->out_pos, ctx->dst_buf + seg->hdr_pos, seg->hdr_len);
+            memcpy(out + seg->out_pos + seg->hdr_len, p + seg->body_pos, seg->body_len);
+        }
+
+        memcpy(p, out, pos);
+        return;
+    }
+
+    if (shift_max > 0) {
+        for (i = seg_cnt - 1; i >= 0; i--) {
+            HalH264eAmendSeg *seg = &segs[i];
+
+            if (seg->body_len)
+                memmove(p + seg->out_pos + seg->hdr_len, p + seg->body_pos, seg->body_len);
+        }
+    } else if (shift_min < 0) {
+        for (i = 0; i < seg_cnt; i++) {
+            HalH264eAmendSeg *seg = &segs[i];
+
+            if (seg->body_len)
+                memmove(p + seg->out_pos + seg->hdr_len, p + seg->body_pos, seg->body_len);
+        }
+    }
+
+    for (i = 0; i < seg_cnt; i++) {
+        HalH264eAmendSeg *seg = &segs[i];
+
+        memcpy(p + seg->out_pos, ctx->dst_buf + seg->hdr_pos, seg->hdr_len);
+    }
+}
+
+MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwCfg *hw_cfg)
+{
+    H264ePrefixNal *prefix = ctx->prefix;
+    H264eSlice *slice = ctx->slice;
+    MppPacket pkt = ctx->packet;
+    RK_S32 base = ctx->buf_base;
+    RK_U8 *p = (RK_U8 *)mpp_packet_get_pos(pkt) + base;
+    RK_S32 len = ctx->old_length;
+    RK_U8 *dst_buf = NULL;
+    RK_S32 buf_size;
+    RK_S32 nal_pos = 0;
+    RK_S32 final_len = 0;
+    RK_S32 last_slice = 0;
+    RK_S32 seg_cnt = 0;
+    const MppPktSeg *seg = mpp_packet_get_segment_info(pkt);
+
+    if (seg) {
+        while (seg && seg->type != 1 && seg->type != 5) {
+            seg = seg->next;
+        }
+    }
+
+    amend_sync_begin(pkt, base, len, __FUNCTION__);
+
+    amend_buf_check(ctx, len);
+
+    dst_buf = ctx->dst_buf;
+    buf_size = ctx->buf_size;
+
+    /* read each slice in place and write prefix and new header to dst_buf */
+    do {
+        HalH264eAmendSeg *amend_seg = amend_seg_get(ctx, seg_cnt);
+        RK_U8 *src = p + nal_pos;
+        RK_S32 nal_len = 0;
+        RK_S32 hdr_len = 0;
+        RK_S32 hw_len_bit = 0;
+        RK_S32 sw_len_bit = 0;
+        RK_S32 hw_len_byte = 0;
+        RK_S32 sw_len_byte = 0;
+        H264eSlice slice_rd;
+
+        if (NULL == amend_seg) {
+            mpp_err_f("failed to get slice segment %d\n", seg_cnt);
+            return MPP_NOK;
+        }
+
+        if (slice->is_multi_slice) {
+            if ((!seg) || ctx->diable_split_out) {
+                nal_len = get_next_nal(src, &len);
+                last_slice = (len == 0);
+            } else {
+                nal_len = seg->len;
+                len -= seg->len;
+                seg = seg->next;
+                if (!seg || !len)
+                    last_slice = 1;
+            }
+        } else {
+            nal_len = len;
+            last_slice = 1;
+        }
+
+        hal_h264e_dbg_amend("nal_len %d multi %d last %d prefix %p\n",
+                            nal_len, slice->is_multi_slice, last_slice, prefix);
+
+        amend_seg->hdr_pos = dst_buf - ctx->dst_buf;
+        amend_seg->body_pos = 0;
+        amend_seg->body_len = 0;
+
+        if (prefix) {
+            /* add prefix for each slice */
+            RK_S32 prefix_bit = h264e_slice_write_prefix_nal_unit_svc(prefix, dst_buf, buf_size);
+
+            prefix_bit = (prefix_bit + 7) / 8;
+
+            dst_buf += prefix_bit;
+            buf_size -= prefix_bit;
+            hdr_len += prefix_bit;
+        }
+
+        memcpy(&slice_rd, slice, sizeof(slice_rd));
+
+        /* update slice by hw_cfg */
+        slice_rd.pic_order_cnt_type = hw_cfg->hw_poc_type;
+        slice_rd.log2_max_frame_num = hw_cfg->hw_log2_max_frame_num_minus4 + 4;
+
+        if (ctx->reorder) {
+            slice_rd.reorder = ctx->reorder;
+            h264e_reorder_init(slice_rd.reorder);
+        }
+        if (ctx->marking) {
+            slice_rd.marking = ctx->marking;
+            h264e_marking_init(slice_rd.marking);
+        }
+
+        hw_len_bit = h264e_slice_read(&slice_rd, src, nal_len);
+
+        // write new header to header buffer
+        slice->qp_delta = slice_rd.qp_delta;
+        slice->first_mb_in_slice = slice_rd.first_mb_in_slice;
+
+        if (ctx->reorder)
+            slice->reorder = slice_rd.reorder;
+        if (ctx->marking)
+            slice->marking = slice_rd.marking;
+
+        sw_len_bit = h264e_slice_write(slice, dst_buf, buf_size);
+
+        hw_len_byte = (hw_len_bit + 7) / 8;
+        sw_len_byte = (sw_len_bit + 7) / 8;
+
+        if (slice->entropy_coding_mode) {
+            /* cabac slice data is byte aligned and kept in the stream */
+            hal_h264e_dbg_amend("hw_hdr %d sw_hdr %d len %d hw_byte %d sw_byte %d\n",
+                                hw_len_bit, sw_len_bit, nal_len, hw_len_byte, sw_len_byte);
+
+            amend_seg->body_pos = nal_pos + hw_len_byte;
+            amend_seg->body_len = nal_len - hw_len_byte;
+            hdr_len += sw_len_byte;
+            dst_buf += sw_len_byte;
+            buf_size -= sw_len_byte;
+        } else {
+            /* cavlc slice data is shifted with the header bit length change */
+            RK_S32 hdr_diff_bit = sw_len_bit - hw_len_bit;
+            RK_S32 tail_0bit = 0;
+            RK_U8  tail_byte = src[nal_len - 1];
+            RK_U8  tail_tmp = tail_byte;
+            RK_S32 diff_size;
+            RK_S32 bit_len;
+            RK_S32 new_len;
+
+            while (!(tail_tmp & 1) && tail_0bit < 8) {
+                tail_tmp >>= 1;
+                tail_0bit++;
+            }
+
+            mpp_assert(tail_0bit < 8);
+
+            // move the reset slice data from stream to dst buffer
+            diff_size = h264e_slice_move(dst_buf, src, sw_len_bit, hw_len_bit, nal_len);
+
+            bit_len = nal_len * 8 - tail_0bit + hdr_diff_bit;
+            new_len = (bit_len + diff_size * 8 + 7) / 8;
+            amend_clear_tail(dst_buf, bit_len + diff_size * 8);
+
+            hal_h264e_dbg_amend("frm %4d %c tail 0x%02x %d len %d bit hw %d sw %d byte hw %d sw %d diff %d -> %d\n",
+                                slice->frame_num, (slice->idr_flag ? 'I' : 'P'),
+                                tail_byte, tail_0bit, nal_len, hw_len_bit, sw_len_bit,
+                                hw_len_byte, sw_len_byte, diff_size, new_len);
+
+            hdr_len += new_len;
+            dst_buf += new_len;
+            buf_size -= new_len;
+        }
+
+        amend_seg->hdr_len = hdr_len;
+        final_len += hdr_len + amend_seg->body_len;
+        nal_pos += nal_len;
+        seg_cnt++;
+    } while (!last_slice);
+
+    amend_splice(ctx, p, seg_cnt);
+
+    if (slice->entropy_coding_mode) {
+        if (final_len < ctx->old_length)
+            memset(p + final_len, 0, ctx->old_length - final_len);
+    } else
+        p[final_len] = 0;
+
+    ctx->new_length = final_len;
+
+    return MPP_OK;
+}
+
 MPP_RET h264e_vepu_stream_amend_sync_ref_idc(HalH264eVepuStreamAmend *ctx)
 {
     H264eSlice *slice = ctx->slice;
@@ -336,12 +609,7 @@ MPP_RET h264e_vepu_stream_amend_sync_ref_idc(HalH264eVepuStreamAmend *ctx)
     RK_S32 hw_nal_ref_idc = 0;
     RK_S32 sw_nal_ref_idc = 0;
 
-    {
-        MppBuffer buf = mpp_packet_get_buffer(pkt);
-        RK_S32 fd = mpp_buffer_get_fd(buf);
-
-        mpp_dmabuf_sync_partial_begin(fd, 1, base, len, __FUNCTION__);
-    }
+    amend_sync_begin(pkt, base, len, __FUNCTION__);
 
     val = p[4];
     hw_nal_ref_idc = (val >> 5) & 0x3;
@@ -19,6 +19,19 @@
 
 #include "h264e_slice.h"
 
+/*
+ * One slice of the amended stream. The prefix nal and new slice header, or
+ * the whole cavlc slice, are in dst_buf and the unchanged cabac slice data
+ * is left in the stream.
+ */
+typedef struct HalH264eAmendSeg_t {
+    RK_S32           hdr_pos;
+    RK_S32           hdr_len;
+    RK_S32           body_pos;
+    RK_S32           body_len;
+    RK_S32           out_pos;
+} HalH264eAmendSeg;
+
 typedef struct HalH264eVepuStreamAmend_t {
     RK_S32           enable;
     H264eSlice       *slice;
@@ -35,6 +48,9 @@ typedef struct HalH264eVepuStreamAmend_t {
     RK_U8            *dst_buf;
     RK_S32           buf_size;
 
+    HalH264eAmendSeg *segs;
+    RK_S32           seg_size;
+
     MppPacket        packet;
     RK_S32           buf_base;
     RK_S32           old_length;
@@ -47,6 +63,7 @@ MPP_RET h264e_vepu_stream_amend_config(HalH264eVepuStreamAmend *ctx,
                                        MppPacket packet, MppEncCfgSet *cfg,
                                        H264eSlice *slice, H264ePrefixNal *prefix);
 MPP_RET h264e_vepu_stream_amend_proc(HalH264eVepuStreamAmend *ctx, MppEncH264HwCfg *hw_cfg);
+MPP_RET h264e_vepu_stream_amend_proc_c(HalH264eVepuStreamAmend *ctx, MppEncH264HwCfg *hw_cfg);
 MPP_RET h264e_vepu_stream_amend_sync_ref_idc(HalH264eVepuStreamAmend *ctx);
 
 #endif /* __HAL_H264E_STREAM_AMEND_H__ */
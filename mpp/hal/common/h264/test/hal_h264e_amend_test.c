@@ -0,0 +1,330 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_h264e_amend_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_bitwrite.h"
+#include "mpp_packet_impl.h"
+
+#include "hal_h264e_stream_amend.h"
+
+/* 1080p frame */
+#define MB_W                120
+#define MB_H                68
+#define CHECK_FRAME_SIZE    (16 * 1024)
+#define BENCH_FRAME_SIZE    (128 * 1024)
+#define BUF_PAD             (4 * 1024)
+/* zero rich slice data for checking the 03 handling */
+#define CHECK_ZERO_RATE     4
+#define LOOP_COUNT          64
+
+/* hw / sw header layout pair */
+typedef enum AmendHdr_e {
+    AMEND_HDR_SAME,         /* header size unchanged */
+    AMEND_HDR_GROW,         /* sw header adds poc lsb and longer frame_num */
+    AMEND_HDR_SHRINK,       /* sw header drops poc lsb and shorter frame_num */
+    AMEND_HDR_BUTT,
+} AmendHdr;
+
+static const char *hdr_names[] = {
+    "same",
+    "grow",
+    "shrink",
+};
+
+typedef struct AmendTestCtx_t {
+    H264eReorderInfo    reorder;
+    H264eMarkingInfo    marking;
+    H264eSlice          hw;
+    H264eSlice          sw;
+    H264ePrefixNal      prefix;
+    MppEncH264HwCfg     hw_cfg;
+} AmendTestCtx;
+
+static void slice_setup(AmendTestCtx *t, RK_S32 cabac, AmendHdr hdr)
+{
+    H264eSlice *hw = &t->hw;
+    H264eSlice *sw = &t->sw;
+
+    memset(t, 0, sizeof(*t));
+    h264e_reorder_init(&t->reorder);
+    h264e_marking_init(&t->marking);
+
+    hw->mb_w = MB_W;
+    hw->mb_h = MB_H;
+    hw->entropy_coding_mode = cabac;
+    hw->log2_max_frame_num = 4;
+    hw->log2_max_poc_lsb = 16;
+    hw->pic_order_cnt_type = 2;
+    hw->qp_init = 26;
+    hw->nal_reference_idc = 2;
+    hw->nalu_type = 1;
+    hw->slice_type = 0;
+    hw->frame_num = 5;
+    hw->pic_order_cnt_lsb = 10;
+    hw->cabac_init_idc = 1;
+    hw->reorder = &t->reorder;
+    hw->marking = &t->marking;
+    hw->is_multi_slice = 1;
+
+    if (hdr == AMEND_HDR_SHRINK) {
+        hw->log2_max_frame_num = 16;
+        hw->pic_order_cnt_type = 0;
+    }
+
+    memcpy(sw, hw, sizeof(*sw));
+
+    if (hdr == AMEND_HDR_GROW) {
+        sw->log2_max_frame_num = 16;
+        sw->pic_order_cnt_type = 0;
+    } else if (hdr == AMEND_HDR_SHRINK) {
+        sw->log2_max_frame_num = 4;
+        sw->pic_order_cnt_type = 2;
+    }
+
+    t->hw_cfg.hw_poc_type = hw->pic_order_cnt_type;
+    t->hw_cfg.hw_log2_max_frame_num_minus4 = hw->log2_max_frame_num - 4;
+
+    t->prefix.nal_ref_idc = 2;
+    t->prefix.priority_id = 0;
+    t->prefix.no_inter_layer_pred_flag = 1;
+    t->prefix.temporal_id = 1;
+    t->prefix.output_flag = 1;
+}
+
+/*
+ * generate hw stream with slice_cnt slices of size / slice_cnt bytes data
+ * zero_rate - one of zero_rate data bytes is forced to zero, 0 for none
+ */
+static RK_S32 gen_frame(AmendTestCtx *t, RK_U8 *buf, RK_S32 slice_cnt, RK_S32 size,
+                        RK_S32 zero_rate)
+{
+    H264eSlice *hw = &t->hw;
+    RK_S32 body_size = size / slice_cnt;
+    RK_S32 pos = 0;
+    RK_S32 i;
+    RK_S32 j;
+
+    for (i = 0; i < slice_cnt; i++) {
+        RK_S32 hdr_bit;
+
+        hw->first_mb_in_slice = i * MB_W * MB_H / slice_cnt;
+        hw->qp_delta = i % 3 - 1;
+        hdr_bit = h264e_slice_write(hw, buf + pos, size + BUF_PAD - pos);
+
+        if (hw->entropy_coding_mode) {
+            RK_S32 zeros = 0;
+
+            pos += hdr_bit / 8;
+
+            for (j = 0; j < body_size; j++) {
+                RK_U8 val = (zero_rate && !(rand() % zero_rate)) ? 0 : rand() & 0xff;
+
+                if (zeros >= 2 && val <= 3) {
+                    buf[pos++] = 3;
+                    zeros = 0;
+                }
+                buf[pos++] = val;
+                zeros = val ? 0 : zeros + 1;
+            }
+            buf[pos++] = 0x80;
+        } else {
+            MppWriteCtx s;
+
+            /* continue slice data from the last header byte */
+            pos += hdr_bit / 8;
+            mpp_writer_init(&s, buf + pos, size + BUF_PAD - pos);
+            s.buffered_bits = hdr_bit & 7;
+            s.byte_buffer = s.buffered_bits ? (RK_U32)buf[pos] << 24 : 0;
+
+            for (j = 0; j < body_size; j++)
+                mpp_writer_put_bits(&s, (zero_rate && !(rand() % zero_rate)) ?
+                                    0 : rand() & 0xff, 8);
+
+            mpp_writer_trailing(&s);
+            pos += s.byte_cnt;
+        }
+    }
+
+    return pos;
+}
+
+static void amend_setup(HalH264eVepuStreamAmend *amend, AmendTestCtx *t, H264eSlice *slice,
+                        RK_S32 svc, MppPacket pkt, RK_S32 len)
+{
+    *slice = t->sw;
+
+    amend->enable = 1;
+    amend->diable_split_out = 1;
+    amend->slice = slice;
+    amend->prefix = svc ? &t->prefix : NULL;
+    amend->packet = pkt;
+    amend->buf_base = 0;
+    amend->old_length = len;
+    amend->new_length = 0;
+}
+
+static void amend_ctx_init(HalH264eVepuStreamAmend *amend)
+{
+    h264e_vepu_stream_amend_init(amend);
+    amend->src_buf = mpp_malloc(RK_U8, amend->buf_size);
+    amend->dst_buf = mpp_malloc(RK_U8, amend->buf_size);
+}
+
+static RK_S32 check_amend(RK_S32 cabac, AmendHdr hdr, RK_S32 svc, RK_S32 slice_cnt)
+{
+    RK_S32 cap = CHECK_FRAME_SIZE * 2 + BUF_PAD;
+    RK_U8 *ref = mpp_calloc(RK_U8, cap);
+    RK_U8 *buf = mpp_calloc(RK_U8, cap);
+    HalH264eVepuStreamAmend amend_ref;
+    HalH264eVepuStreamAmend amend_new;
+    MppPacket pkt_ref = NULL;
+    MppPacket pkt_new = NULL;
+    H264eSlice slice_ref;
+    H264eSlice slice_new;
+    AmendTestCtx t;
+    RK_S32 len;
+    RK_S32 ret = 0;
+
+    slice_setup(&t, cabac, hdr);
+    len = gen_frame(&t, ref, slice_cnt, CHECK_FRAME_SIZE, CHECK_ZERO_RATE);
+    memcpy(buf, ref, cap);
+
+    mpp_packet_init(&pkt_ref, ref, cap);
+    mpp_packet_init(&pkt_new, buf, cap);
+    amend_ctx_init(&amend_ref);
+    amend_ctx_init(&amend_new);
+
+    amend_setup(&amend_ref, &t, &slice_ref, svc, pkt_ref, len);
+    amend_setup(&amend_new, &t, &slice_new, svc, pkt_new, len);
+
+    h264e_vepu_stream_amend_proc_c(&amend_ref, &t.hw_cfg);
+    h264e_vepu_stream_amend_proc(&amend_new, &t.hw_cfg);
+
+    if (amend_ref.new_length != amend_new.new_length || memcmp(ref, buf, cap)) {
+        RK_S32 i;
+
+        for (i = 0; i < cap; i++)
+            if (ref[i] != buf[i])
+                break;
+
+        mpp_err("%s %s svc %d slices %d mismatch len %d -> %d vs %d at byte %d %02x vs %02x\n",
+                cabac ? "cabac" : "cavlc", hdr_names[hdr], svc, slice_cnt,
+                len, amend_new.new_length, amend_ref.new_length, i, buf[i], ref[i]);
+        ret = -1;
+    }
+
+    h264e_vepu_stream_amend_deinit(&amend_ref);
+    h264e_vepu_stream_amend_deinit(&amend_new);
+    mpp_packet_deinit(&pkt_ref);
+    mpp_packet_deinit(&pkt_new);
+    MPP_FREE(ref);
+    MPP_FREE(buf);
+
+    return ret;
+}
+
+static void bench_amend(RK_S32 cabac, AmendHdr hdr, RK_S32 svc, RK_S32 slice_cnt)
+{
+    RK_S32 cap = BENCH_FRAME_SIZE * 2 + BUF_PAD;
+    RK_U8 *frm = mpp_calloc(RK_U8, cap);
+    RK_U8 *buf = mpp_calloc(RK_U8, cap);
+    HalH264eVepuStreamAmend amend;
+    MppPacket pkt = NULL;
+    H264eSlice slice;
+    AmendTestCtx t;
+    RK_S64 time_ref = 0;
+    RK_S64 time_new = 0;
+    RK_S64 start;
+    RK_S32 len;
+    RK_S32 i;
+
+    slice_setup(&t, cabac, hdr);
+    len = gen_frame(&t, frm, slice_cnt, BENCH_FRAME_SIZE, 0);
+
+    mpp_packet_init(&pkt, buf, cap);
+    amend_ctx_init(&amend);
+
+    for (i = 0; i < LOOP_COUNT; i++) {
+        memcpy(buf, frm, len);
+        amend_setup(&amend, &t, &slice, svc, pkt, len);
+        start = mpp_time();
+        h264e_vepu_stream_amend_proc_c(&amend, &t.hw_cfg);
+        time_ref += mpp_time() - start;
+
+        memcpy(buf, frm, len);
+        amend_setup(&amend, &t, &slice, svc, pkt, len);
+        start = mpp_time();
+        h264e_vepu_stream_amend_proc(&amend, &t.hw_cfg);
+        time_new += mpp_time() - start;
+    }
+
+    mpp_log("%s %-6s svc %d slices %2d frame %6d copy %6.1f us in place %6.1f us\n",
+            cabac ? "cabac" : "cavlc", hdr_names[hdr], svc, slice_cnt, len,
+            (double)time_ref / LOOP_COUNT, (double)time_new / LOOP_COUNT);
+
+    h264e_vepu_stream_amend_deinit(&amend);
+    mpp_packet_deinit(&pkt);
+    MPP_FREE(frm);
+    MPP_FREE(buf);
+}
+
+int main()
+{
+    static const RK_S32 slice_cnts[] = { 1, 2, 4, 8, 17, 34, 68 };
+    RK_S32 ret = 0;
+    RK_S32 cabac;
+    RK_S32 hdr;
+    RK_S32 svc;
+    RK_U32 i;
+
+    mpp_log("hal_h264e_amend_test start\n");
+
+    srand(0x264);
+
+    for (cabac = 0; cabac < 2; cabac++) {
+        for (hdr = 0; hdr < AMEND_HDR_BUTT; hdr++) {
+            for (svc = 0; svc < 2; svc++) {
+                for (i = 0; i < MPP_ARRAY_ELEMS(slice_cnts); i++) {
+                    ret = check_amend(cabac, (AmendHdr)hdr, svc, slice_cnts[i]);
+                    if (ret)
+                        goto DONE;
+                }
+            }
+        }
+    }
+
+    /* amend cost per frame against slice count */
+    for (cabac = 1; cabac >= 0; cabac--) {
+        for (hdr = 0; hdr < AMEND_HDR_BUTT; hdr++) {
+            for (i = 0; i < MPP_ARRAY_ELEMS(slice_cnts); i++)
+                bench_amend(cabac, (AmendHdr)hdr, 0, slice_cnts[i]);
+        }
+        for (i = 0; i < MPP_ARRAY_ELEMS(slice_cnts); i++)
+            bench_amend(cabac, AMEND_HDR_SAME, 1, slice_cnts[i]);
+    }
+
+DONE:
+    mpp_log("hal_h264e_amend_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -285,18 +285,12 @@ void hal_vdpu383_record_scaling_list(scalingFactor_t *pScalingFactor_out, scalin
         }
     }
     //sizeId == 0, block4x4, horiztion direction */
-    for (listId = 0; listId < SCALING_LIST_NUM; listId++) {
-        RK_U8 *p_data = pScalingList->sl[0][listId];
-
-        for (i = 0; i < 16; i++)
-            mpp_put_bits(&bp, p_data[i], 8);
-    }
+    for (listId = 0; listId < SCALING_LIST_NUM; listId++)
+        mpp_put_bytes(&bp, pScalingList->sl[0][listId], 16);
 
     // dump dc value
-    for (i = 0; i < SCALING_LIST_NUM; i++)//sizeId = 2, 16x16
-        mpp_put_bits(&bp, pScalingList->sl_dc[0][i], 8);
-    for (i = 0; i < SCALING_LIST_NUM; i++) //sizeId = 3, 32x32
-        mpp_put_bits(&bp, pScalingList->sl_dc[1][i], 8);
+    mpp_put_bytes(&bp, pScalingList->sl_dc[0], SCALING_LIST_NUM); //sizeId = 2, 16x16
+    mpp_put_bytes(&bp, pScalingList->sl_dc[1], SCALING_LIST_NUM); //sizeId = 3, 32x32
 
     mpp_put_align(&bp, 128, 0);
 }
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
 #include <string.h>
 
 #include "mpp_mem.h"
@@ -999,7 +1000,7 @@ RK_U32 vp9_hor_align(RK_U32 val)
     return MPP_ALIGN(val, 256) | 256;
 }
 
-MPP_RET hal_vp9d_output_probe(void *buf, void *dxva)
+MPP_RET hal_vp9d_output_probe_c(void *buf, void *dxva)
 {
     RK_S32 i, j, k, m, n;
     RK_S32 fifo_len = 304;
@@ -1445,7 +1446,7 @@ MPP_RET hal_vp9d_prob_default(void *buf, void *dxva)
 }
 
 
-MPP_RET hal_vp9d_prob_flag_delta(void *buf, void *dxva)
+MPP_RET hal_vp9d_prob_flag_delta_c(void *buf, void *dxva)
 {
     RK_S32 i, j, k, m, n;
     RK_S32 fifo_len = PROB_SIZE >> 3;
@@ -1922,6 +1923,280 @@ MPP_RET hal_vp9d_prob_flag_delta(void *buf, void *dxva)
     return 0;
 }
 
+/*
+ * Every probability in the packets is a byte at a fixed position of the
+ * 128 bit rows, only the update flags of the delta packet are single bits.
+ * So the packets are written as byte runs of the layouts below directly into
+ * the probability buffer and bit packing is left to the flags. The LSB first
+ * 64 bit word of mpp_put_bits has the same byte order as memory on the little
+ * endian cpu, which is checked by hal_vp9d_prob_test against the _c version.
+ */
+#define VP9_PROB_ROW            16
+#define VP9_PROB_RUN            27
+#define VP9_PROB_RUN_STRIDE     32
+#define VP9_PROB_COEF_GROUP     (COEF_BANDS * COEFF_CONTEXTS * UNCONSTRAINED_NODES)
+/* update flags are 17 rows on intra frame and 20 rows on inter frame */
+#define VP9_PROB_FLAG_INTRA     (17 * VP9_PROB_ROW)
+#define VP9_PROB_FLAG_INTER     (20 * VP9_PROB_ROW)
+
+typedef struct Vp9dProbRun_t {
+    RK_U16      offset;     /* byte offset in DXVA_prob_vp9 */
+    RK_U16      size;
+} Vp9dProbRun;
+
+#define PROB_RUN(field) \
+    { offsetof(DXVA_prob_vp9, field), sizeof(((DXVA_prob_vp9 *)0)->field) }
+
+/* skip and tx size probs after the partition and segment id probs */
+static const Vp9dProbRun vp9d_prob_tx_runs[] = {
+    PROB_RUN(skip),
+    PROB_RUN(tx32p),
+    PROB_RUN(tx16p),
+    PROB_RUN(tx8p),
+};
+
+/* intra y mode and inter block probs, 85 bytes in 6 rows */
+static const Vp9dProbRun vp9d_prob_inter_runs[] = {
+    PROB_RUN(y_mode),
+    PROB_RUN(comp),
+    PROB_RUN(comp_ref),
+    PROB_RUN(single_ref),
+    PROB_RUN(mv_mode),
+    PROB_RUN(filter),
+};
+
+/* mv probs interleaved by component, 69 bytes in 5 rows */
+static const Vp9dProbRun vp9d_prob_mv_runs[] = {
+    PROB_RUN(mv_joint),
+    PROB_RUN(mv_comp[0].sign),
+    PROB_RUN(mv_comp[1].sign),
+    PROB_RUN(mv_comp[0].classes),
+    PROB_RUN(mv_comp[1].classes),
+    PROB_RUN(mv_comp[0].class0),
+    PROB_RUN(mv_comp[1].class0),
+    PROB_RUN(mv_comp[0].bits),
+    PROB_RUN(mv_comp[1].bits),
+    PROB_RUN(mv_comp[0].class0_fp),
+    PROB_RUN(mv_comp[1].class0_fp),
+    PROB_RUN(mv_comp[0].fp),
+    PROB_RUN(mv_comp[1].fp),
+    PROB_RUN(mv_comp[0].class0_hp),
+    PROB_RUN(mv_comp[1].class0_hp),
+    PROB_RUN(mv_comp[0].hp),
+    PROB_RUN(mv_comp[1].hp),
+};
+
+static RK_U8 *prob_put_runs(RK_U8 *dst, const RK_U8 *prob,
+                            const Vp9dProbRun *runs, RK_U32 count)
+{
+    RK_U32 i;
+
+    for (i = 0; i < count; i++) {
+        memcpy(dst, prob + runs[i].offset, runs[i].size);
+        dst += runs[i].size;
+    }
+
+    return dst;
+}
+
+static void prob_put_flag_runs(BitputCtx_t *bp, const RK_U8 *flag,
+                               const Vp9dProbRun *runs, RK_U32 count)
+{
+    RK_U32 i;
+
+    for (i = 0; i < count; i++)
+        mpp_put_array(bp, flag + runs[i].offset, runs[i].size, 1);
+}
+
+/* partition, segment id, skip, tx size and intra inter probs in 5 rows */
+static RK_U8 *prob_put_header(RK_U8 *dst, const RK_U8 *partition,
+                              DXVA_segmentation_VP9 *seg, const RK_U8 *prob)
+{
+    RK_U8 *p = dst;
+
+    memcpy(p, partition, PARTITION_CONTEXTS * (PARTITION_TYPES - 1));
+    p += PARTITION_CONTEXTS * (PARTITION_TYPES - 1);
+    memcpy(p, seg->pred_probs, PREDICTION_PROBS);
+    p += PREDICTION_PROBS;
+    memcpy(p, seg->tree_probs, SEG_TREE_PROBS);
+    p += SEG_TREE_PROBS;
+    p = prob_put_runs(p, prob, vp9d_prob_tx_runs, MPP_ARRAY_ELEMS(vp9d_prob_tx_runs));
+    memcpy(p, prob + offsetof(DXVA_prob_vp9, intra), INTRA_INTER_CONTEXTS);
+
+    return dst + 5 * VP9_PROB_ROW;
+}
+
+/* 10 x 9 mode probs as three 27 byte runs and one 9 byte run in 7 rows */
+static void prob_put_mode_rows(RK_U8 *dst, const RK_U8 *mode)
+{
+    memcpy(dst, mode, VP9_PROB_RUN);
+    memcpy(dst + VP9_PROB_RUN_STRIDE, mode + VP9_PROB_RUN, VP9_PROB_RUN);
+    memcpy(dst + 2 * VP9_PROB_RUN_STRIDE, mode + 2 * VP9_PROB_RUN, VP9_PROB_RUN);
+    memcpy(dst + 3 * VP9_PROB_RUN_STRIDE, mode + 3 * VP9_PROB_RUN,
+           INTRA_MODES * (INTRA_MODES - 1) - 3 * VP9_PROB_RUN);
+}
+
+/* 8 coefficient groups of one ref type, each as four 27 byte runs in 8 rows */
+static RK_U8 *prob_put_coef(RK_U8 *dst, const RK_U8 *coef, RK_S32 ref)
+{
+    RK_S32 i, k;
+
+    for (i = 0; i < TX_SIZES * PLANE_TYPES; i++) {
+        const RK_U8 *src = coef + (i * 2 + ref) * VP9_PROB_COEF_GROUP;
+
+        for (k = 0; k < 4; k++)
+            memcpy(dst + k * VP9_PROB_RUN_STRIDE, src + k * VP9_PROB_RUN, VP9_PROB_RUN);
+
+        dst += 4 * VP9_PROB_RUN_STRIDE;
+    }
+
+    return dst;
+}
+
+/* the coefficient flags use the same layout with one bit for each byte */
+static void prob_put_coef_flag(BitputCtx_t *bp, const RK_U8 *coef, RK_S32 ref)
+{
+    RK_S32 i, k;
+
+    for (i = 0; i < TX_SIZES * PLANE_TYPES; i++) {
+        const RK_U8 *src = coef + (i * 2 + ref) * VP9_PROB_COEF_GROUP;
+
+        for (k = 0; k < 4; k++) {
+            mpp_put_array(bp, src + k * VP9_PROB_RUN, VP9_PROB_RUN, 1);
+            mpp_put_bits(bp, 0, VP9_PROB_RUN_STRIDE - VP9_PROB_RUN);
+        }
+    }
+}
+
+/* key frame y mode probs of each above mode with 23 bytes of uv mode probs */
+static RK_U8 *prob_put_kf_y_mode(RK_U8 *dst)
+{
+    const RK_U8 *uv_mode = &vp9_kf_uv_mode_prob[0][0];
+    RK_S32 i;
+
+    for (i = 0; i < INTRA_MODES; i++) {
+        RK_U8 *uv = dst + 8 * VP9_PROB_ROW - 23;
+
+        prob_put_mode_rows(dst, &vp9_kf_y_mode_prob[i][0][0]);
+        if (i < 4)
+            memcpy(uv, uv_mode + i * 23, i < 3 ? 23 : 21);
+
+        dst += 8 * VP9_PROB_ROW;
+    }
+
+    return dst;
+}
+
+MPP_RET hal_vp9d_output_probe(void *buf, void *dxva)
+{
+    DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)dxva;
+    /* pic_param->prob is DXVA_prob_vp9 followed by the coefficient probs */
+    const RK_U8 *prob = (const RK_U8 *)&pic_param->prob;
+    const RK_U8 *coef = &pic_param->prob.coef[0][0][0][0][0][0];
+    RK_S32 intraFlag = (!pic_param->frame_type || pic_param->intra_only);
+    RK_U8 *dst = (RK_U8 *)buf;
+
+    memset(buf, 0, 304 * 8);
+
+    if (intraFlag) {
+        dst = prob_put_header(dst, &vp9_kf_partition_probs[0][0],
+                              &pic_param->stVP9Segments, prob);
+        dst = prob_put_coef(dst, coef, 0);
+        /* the two zero rows up to 151 rows are left by memset */
+        prob_put_kf_y_mode(dst);
+    } else {
+        dst = prob_put_header(dst, &pic_param->prob.partition[0][0][0],
+                              &pic_param->stVP9Segments, prob);
+        prob_put_runs(dst, prob, vp9d_prob_inter_runs,
+                      MPP_ARRAY_ELEMS(vp9d_prob_inter_runs));
+        dst += 6 * VP9_PROB_ROW;
+        dst = prob_put_coef(dst, coef, 0);
+        dst = prob_put_coef(dst, coef, 1);
+        /* uv mode probs with one zero row */
+        prob_put_mode_rows(dst, &pic_param->prob.uv_mode[0][0]);
+        dst += 8 * VP9_PROB_ROW;
+        prob_put_runs(dst, prob, vp9d_prob_mv_runs, MPP_ARRAY_ELEMS(vp9d_prob_mv_runs));
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET hal_vp9d_prob_flag_delta(void *buf, void *dxva)
+{
+    DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)dxva;
+    const RK_U8 *flag = (const RK_U8 *)&pic_param->prob_flag_delta.p_flag;
+    const RK_U8 *delta = (const RK_U8 *)&pic_param->prob_flag_delta.p_delta;
+    const RK_U8 *coef_flag = &pic_param->prob_flag_delta.coef_flag[0][0][0][0][0][0];
+    const RK_U8 *coef_delta = &pic_param->prob_flag_delta.coef_delta[0][0][0][0][0][0];
+    RK_S32 intraFlag = (!pic_param->frame_type || pic_param->intra_only);
+    RK_U8 *dst = (RK_U8 *)buf;
+    BitputCtx_t bp;
+
+    memset(buf, 0, PROB_SIZE);
+
+    /* update flags first then the delta probs from the next row */
+    mpp_set_bitput_ctx(&bp, (RK_U64 *)buf, PROB_SIZE >> 3);
+
+    if (intraFlag) {
+        /* no partition, segment id and intra inter flags on intra frame */
+        mpp_put_bits(&bp, 0, PARTITION_CONTEXTS * (PARTITION_TYPES - 1) +
+                     PREDICTION_PROBS + SEG_TREE_PROBS);
+        prob_put_flag_runs(&bp, flag, vp9d_prob_tx_runs,
+                           MPP_ARRAY_ELEMS(vp9d_prob_tx_runs));
+        mpp_put_bits(&bp, 0, INTRA_INTER_CONTEXTS + 3);
+        prob_put_coef_flag(&bp, coef_flag, 0);
+        prob_put_coef_flag(&bp, coef_flag, 1);
+
+        dst += VP9_PROB_FLAG_INTRA;
+        dst = prob_put_header(dst, &vp9_kf_partition_probs[0][0],
+                              &pic_param->stVP9Segments, delta);
+        dst = prob_put_coef(dst, coef_delta, 0);
+        dst = prob_put_kf_y_mode(dst);
+        prob_put_coef(dst, coef_delta, 1);
+    } else {
+        const RK_U8 *uv_flag = flag + offsetof(DXVA_prob_vp9, uv_mode);
+        RK_S32 k;
+
+        mpp_put_array(&bp, flag + offsetof(DXVA_prob_vp9, partition),
+                      PARTITION_CONTEXTS * (PARTITION_TYPES - 1), 1);
+        mpp_put_bits(&bp, 0, PREDICTION_PROBS + SEG_TREE_PROBS);
+        prob_put_flag_runs(&bp, flag, vp9d_prob_tx_runs,
+                           MPP_ARRAY_ELEMS(vp9d_prob_tx_runs));
+        mpp_put_array(&bp, flag + offsetof(DXVA_prob_vp9, intra), INTRA_INTER_CONTEXTS, 1);
+        mpp_put_bits(&bp, 0, 3);
+        prob_put_flag_runs(&bp, flag, vp9d_prob_inter_runs,
+                           MPP_ARRAY_ELEMS(vp9d_prob_inter_runs));
+        mpp_put_bits(&bp, 0, 11);
+        prob_put_coef_flag(&bp, coef_flag, 0);
+        prob_put_coef_flag(&bp, coef_flag, 1);
+        for (k = 0; k < 4; k++) {
+            RK_S32 count = k < 3 ? VP9_PROB_RUN : INTRA_MODES - 1;
+
+            mpp_put_array(&bp, uv_flag + k * VP9_PROB_RUN, count, 1);
+            mpp_put_bits(&bp, 0, VP9_PROB_RUN_STRIDE - count);
+        }
+        /* 11 bits and 8 x 16 bits reserve after mv flags are left by memset */
+        prob_put_flag_runs(&bp, flag, vp9d_prob_mv_runs,
+                           MPP_ARRAY_ELEMS(vp9d_prob_mv_runs));
+
+        dst += VP9_PROB_FLAG_INTER;
+        dst = prob_put_header(dst, delta + offsetof(DXVA_prob_vp9, partition),
+                              &pic_param->stVP9Segments, delta);
+        prob_put_runs(dst, delta, vp9d_prob_inter_runs,
+                      MPP_ARRAY_ELEMS(vp9d_prob_inter_runs));
+        dst += 6 * VP9_PROB_ROW;
+        dst = prob_put_coef(dst, coef_delta, 0);
+        dst = prob_put_coef(dst, coef_delta, 1);
+        /* the last uv mode row ends with 23 bytes of 0xff */
+        prob_put_mode_rows(dst, delta + offsetof(DXVA_prob_vp9, uv_mode));
+        memset(dst + 8 * VP9_PROB_ROW - 23, 0xff, 23);
+        dst += 8 * VP9_PROB_ROW;
+        prob_put_runs(dst, delta, vp9d_prob_mv_runs, MPP_ARRAY_ELEMS(vp9d_prob_mv_runs));
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET hal_vp9d_prob_kf(void *buf)
 {
     RK_S32 i, j, k, m;
@@ -90,6 +90,9 @@ RK_U32 vp9_hor_align(RK_U32 val);
 
 MPP_RET hal_vp9d_output_probe(void *buf, void *dxva);
 MPP_RET hal_vp9d_prob_flag_delta(void *buf, void *dxva);
+/* bit packing version of the probability packets for comparison */
+MPP_RET hal_vp9d_output_probe_c(void *buf, void *dxva);
+MPP_RET hal_vp9d_prob_flag_delta_c(void *buf, void *dxva);
 void hal_vp9d_update_counts(void *buf, void *dxva);
 MPP_RET hal_vp9d_prob_default(void *buf, void *dxva);
 MPP_RET hal_vp9d_prob_kf(void *buf);
@@ -525,12 +525,8 @@ static MPP_RET prepare_uncompress_header(HalVp9dCtx *p_hal, DXVA_PicParams_VP9 *
     mpp_put_bits(&bp, pp->uv_ac_delta_q, 5);
     mpp_put_bits(&bp, (!pp->base_qindex && !pp->y_dc_delta_q && !pp->uv_dc_delta_q && !pp->uv_ac_delta_q), 1);
 
-    for (i = 0; i < 3; i++) {
-        mpp_put_bits(&bp, pp->stVP9Segments.pred_probs[i], 8);
-    }
-    for (i = 0; i < 7; i++) {
-        mpp_put_bits(&bp, pp->stVP9Segments.tree_probs[i], 8);
-    }
+    mpp_put_bytes(&bp, pp->stVP9Segments.pred_probs, 3);
+    mpp_put_bytes(&bp, pp->stVP9Segments.tree_probs, 7);
     mpp_put_bits(&bp, pp->stVP9Segments.enabled, 1);
     mpp_put_bits(&bp, pp->stVP9Segments.update_map, 1);
     mpp_put_bits(&bp, pp->stVP9Segments.temporal_update, 1);
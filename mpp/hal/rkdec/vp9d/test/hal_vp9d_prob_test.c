@@ -0,0 +1,169 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "hal_vp9d_prob_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "vp9d_syntax.h"
+#include "hal_vp9d_com.h"
+
+/*
+ * Check the probability packet and the flag / delta packet against the bit
+ * packing version on random picture parameters of key frame, intra only frame
+ * and inter frame, then time both on one inter frame.
+ */
+#define TEST_ROUNDS         1000
+#define TEST_BENCH_LOOP     20000
+
+typedef MPP_RET (*ProbFunc)(void *buf, void *dxva);
+
+typedef struct TestCase_t {
+    const char  *name;
+    ProbFunc    func_ref;
+    ProbFunc    func_new;
+    RK_S32      size;
+} TestCase;
+
+static const TestCase cases[] = {
+    { "output_probe",    hal_vp9d_output_probe_c,    hal_vp9d_output_probe,    304 * 8 },
+    { "prob_flag_delta", hal_vp9d_prob_flag_delta_c, hal_vp9d_prob_flag_delta, PROB_SIZE },
+};
+
+static RK_U32 test_rand(RK_U32 *seed)
+{
+    /* xorshift32 for the reproducible parameters */
+    RK_U32 x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+
+    return x;
+}
+
+static void fill_pic_param(DXVA_PicParams_VP9 *pic_param, RK_S32 type, RK_U32 *seed)
+{
+    RK_U8 *p = (RK_U8 *)pic_param;
+    RK_U32 i;
+
+    for (i = 0; i < sizeof(*pic_param); i++)
+        p[i] = (RK_U8)test_rand(seed);
+
+    /* 0 - key frame 1 - intra only frame 2 - inter frame */
+    pic_param->frame_type = type ? 1 : 0;
+    pic_param->intra_only = (type == 1);
+}
+
+static MPP_RET test_bit_exact(DXVA_PicParams_VP9 *pic_param, RK_U8 *buf0, RK_U8 *buf1)
+{
+    RK_U32 seed = 0x12345678;
+    RK_U32 i;
+    RK_S32 type, r, k;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(cases); i++) {
+        const TestCase *c = &cases[i];
+
+        for (type = 0; type < 3; type++) {
+            for (r = 0; r < TEST_ROUNDS; r++) {
+                fill_pic_param(pic_param, type, &seed);
+                /* dirty buffer to catch the bytes left from last frame */
+                memset(buf0, 0x5a, PROB_SIZE);
+                memset(buf1, 0xa5, PROB_SIZE);
+
+                c->func_ref(buf0, pic_param);
+                c->func_new(buf1, pic_param);
+
+                if (!memcmp(buf0, buf1, c->size))
+                    continue;
+
+                for (k = 0; k < c->size; k++) {
+                    if (buf0[k] != buf1[k])
+                        break;
+                }
+
+                mpp_err("%s frame type %d round %d mismatch at byte %d ref %02x vs %02x\n",
+                        c->name, type, r, k, buf0[k], buf1[k]);
+                return MPP_NOK;
+            }
+        }
+
+        mpp_log("%s bit exact on %d frames\n", c->name, 3 * TEST_ROUNDS);
+    }
+
+    return MPP_OK;
+}
+
+static void test_bench(DXVA_PicParams_VP9 *pic_param, RK_U8 *buf0, RK_U8 *buf1)
+{
+    RK_U32 seed = 0x9e3779b9;
+    RK_U32 i;
+    RK_S32 j;
+
+    fill_pic_param(pic_param, 2, &seed);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(cases); i++) {
+        const TestCase *c = &cases[i];
+        RK_S64 time_ref;
+        RK_S64 time_new;
+
+        time_ref = mpp_time();
+        for (j = 0; j < TEST_BENCH_LOOP; j++)
+            c->func_ref(buf0, pic_param);
+        time_ref = mpp_time() - time_ref;
+
+        time_new = mpp_time();
+        for (j = 0; j < TEST_BENCH_LOOP; j++)
+            c->func_new(buf1, pic_param);
+        time_new = mpp_time() - time_new;
+
+        mpp_log("%s per inter frame ref %.3f us new %.3f us speedup %.2f\n",
+                c->name, (double)time_ref / TEST_BENCH_LOOP,
+                (double)time_new / TEST_BENCH_LOOP,
+                time_new ? (double)time_ref / time_new : 0.0);
+    }
+}
+
+int main()
+{
+    DXVA_PicParams_VP9 *pic_param = malloc(sizeof(*pic_param));
+    /* 64 bit aligned like the probability buffer from mpp_buffer */
+    RK_U64 *buf0 = malloc(PROB_SIZE);
+    RK_U64 *buf1 = malloc(PROB_SIZE);
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("hal_vp9d_prob_test start\n");
+
+    if (pic_param && buf0 && buf1) {
+        ret = test_bit_exact(pic_param, (RK_U8 *)buf0, (RK_U8 *)buf1);
+        if (!ret)
+            test_bench(pic_param, (RK_U8 *)buf0, (RK_U8 *)buf1);
+    }
+
+    free(pic_param);
+    free(buf0);
+    free(buf1);
+
+    mpp_log("hal_vp9d_prob_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -43,6 +43,7 @@ MPP_RET hal_av1d_init(void *hal, MppHalCfg *cfg)
     RK_U32 vcodec_type  = mpp_get_vcodec_type();
     MppClientType type  = VPU_CLIENT_RKVDEC;
     RK_U32 hw_id = 0;
+    RK_U32 fast_mode = 0;
 
     INP_CHECK(ret, NULL == p_hal);
     memset(p_hal, 0, sizeof(Av1dHalCtx));
@@ -77,7 +78,14 @@ MPP_RET hal_av1d_init(void *hal, MppHalCfg *cfg)
                         (&p_hal->buf_group, MPP_BUFFER_TYPE_ION));
     }
 
-    cfg->support_fast_mode = 0;
+    /*
+     * Both hardware keep per task register and table buffers. The parser only
+     * waits previous task done when the frame end cdf update is required.
+     * Fast mode is not validated on hardware yet so it is enabled by env
+     * hal_av1d_fast_mode only.
+     */
+    mpp_env_get_u32("hal_av1d_fast_mode", &fast_mode, 0);
+    cfg->support_fast_mode = fast_mode ? 1 : 0;
     p_hal->dev          = cfg->dev;
     p_hal->cfg          = cfg->cfg;
     p_hal->slots        = cfg->frame_slots;
@@ -64,10 +64,23 @@ typedef struct filt_info_t {
 typedef struct av1d_rkv_buf_t {
     RK_U32              valid;
     VdpuAv1dRegSet  *regs;
+    /* cpu written tables and probability output owned by one task */
+    MppBuffer           prob_tbl_base;
+    MppBuffer           prob_tbl_out_base;
+    MppBuffer           tile_info;
+    MppBuffer           film_grain_mem;
+    MppBuffer           global_model;
+    /* filter column and tile sync buffers written by hardware */
+    MppBuffer           filter_mem;
+    filtInfo            filt_info[FILT_TYPE_BUT];
+    RK_U32              filt_height;
+    RK_U32              filt_tile_cols;
+    MppBuffer           tile_buf;
 } av1dVdpuBuf;
 
 typedef struct VdpuAv1dRegCtx_t {
     av1dVdpuBuf     reg_buf[VDPU_FAST_REG_SET_CNT];
+    /* buffers of the reg_buf selected by current task */
     MppBuffer       prob_tbl_base;
     MppBuffer       prob_tbl_out_base;
     MppBuffer       tile_info;
@@ -75,7 +88,7 @@ typedef struct VdpuAv1dRegCtx_t {
     MppBuffer       global_model;
     MppBuffer       filter_mem;
     MppBuffer       tile_buf;
-    filtInfo        filt_info[FILT_TYPE_BUT];
+    filtInfo        *filt_info;
 
     AV1CDFs         *cdfs;
     MvCDFs          *cdfs_ndvc;
@@ -128,6 +141,21 @@ static RK_U32 rkv_len_align_422(RK_U32 val)
     return ((5 * MPP_ALIGN(val, 64)) / 2);
 }
 
+static void vdpu_av1d_select_reg_buf(VdpuAv1dRegCtx *ctx, RK_U32 index)
+{
+    av1dVdpuBuf *reg_buf = &ctx->reg_buf[index];
+
+    ctx->regs               = reg_buf->regs;
+    ctx->prob_tbl_base      = reg_buf->prob_tbl_base;
+    ctx->prob_tbl_out_base  = reg_buf->prob_tbl_out_base;
+    ctx->tile_info          = reg_buf->tile_info;
+    ctx->film_grain_mem     = reg_buf->film_grain_mem;
+    ctx->global_model       = reg_buf->global_model;
+    ctx->filter_mem         = reg_buf->filter_mem;
+    ctx->filt_info          = reg_buf->filt_info;
+    ctx->tile_buf           = reg_buf->tile_buf;
+}
+
 static MPP_RET hal_av1d_alloc_res(void *hal)
 {
     MPP_RET ret = MPP_OK;
@@ -141,20 +169,21 @@ static MPP_RET hal_av1d_alloc_res(void *hal)
 
     //!< malloc buffers
     for (i = 0; i < max_cnt; i++) {
-        reg_ctx->reg_buf[i].regs = mpp_calloc(VdpuAv1dRegSet, 1);
-        memset(reg_ctx->reg_buf[i].regs, 0, sizeof(VdpuAv1dRegSet));
-    }
+        av1dVdpuBuf *reg_buf = &reg_ctx->reg_buf[i];
 
-    if (!p_hal->fast_mode) {
-        reg_ctx->regs = reg_ctx->reg_buf[0].regs;
+        reg_buf->regs = mpp_calloc(VdpuAv1dRegSet, 1);
+        memset(reg_buf->regs, 0, sizeof(VdpuAv1dRegSet));
+
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->prob_tbl_base, MPP_ALIGN(sizeof(AV1CDFs), 2048)));
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->prob_tbl_out_base, MPP_ALIGN(sizeof(AV1CDFs), 2048)));
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->tile_info, AV1_TILE_INFO_SIZE));
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->film_grain_mem, MPP_ALIGN(sizeof(AV1FilmGrainMemory), 2048)));
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->global_model, MPP_ALIGN(GLOBAL_MODEL_SIZE, 2048)));
+        BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_buf->tile_buf, MPP_ALIGN(32 * MaxTiles, 4096)));
     }
 
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->prob_tbl_base, MPP_ALIGN(sizeof(AV1CDFs), 2048)));
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->prob_tbl_out_base, MPP_ALIGN(sizeof(AV1CDFs), 2048)));
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->tile_info, AV1_TILE_INFO_SIZE));
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->film_grain_mem, MPP_ALIGN(sizeof(AV1FilmGrainMemory), 2048)));
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->global_model, MPP_ALIGN(GLOBAL_MODEL_SIZE, 2048)));
-    BUF_CHECK(ret, mpp_buffer_get(p_hal->buf_group, &reg_ctx->tile_buf, MPP_ALIGN(32 * MaxTiles, 4096)));
+    if (!p_hal->fast_mode)
+        vdpu_av1d_select_reg_buf(reg_ctx, 0);
 
 __RETURN:
     return ret;
@@ -162,12 +191,12 @@ __FAILED:
     return ret;
 }
 
-static void vdpu_av1d_filtermem_release(VdpuAv1dRegCtx *ctx)
+static void vdpu_av1d_filtermem_release(av1dVdpuBuf *reg_buf)
 {
-    BUF_PUT(ctx->filter_mem);
+    BUF_PUT(reg_buf->filter_mem);
 }
 
-static MPP_RET vdpu_av1d_filtermem_alloc(Av1dHalCtx *p_hal, VdpuAv1dRegCtx *ctx, DXVA_PicParams_AV1 *dxva)
+static MPP_RET vdpu_av1d_filtermem_alloc(Av1dHalCtx *p_hal, av1dVdpuBuf *reg_buf, DXVA_PicParams_AV1 *dxva)
 {
     RK_U32 size = 0;
     RK_U32 pic_height = MPP_ALIGN(dxva->height, 64);
@@ -175,7 +204,7 @@ static MPP_RET vdpu_av1d_filtermem_alloc(Av1dHalCtx *p_hal, VdpuAv1dRegCtx *ctx,
     RK_U32 stripe_num = ((pic_height + 8) + 63) / 64;
     RK_U32 max_bit_depth = 10;
     RK_U32 num_tile_cols = 1 << dxva->tile_cols_log2;//dxva->tiles.cols;
-    filtInfo *filt_info = ctx->filt_info;
+    filtInfo *filt_info = reg_buf->filt_info;
 
     /* db tile col data buffer */
     // asic_buff->db_data_col_offset = 0;
@@ -223,7 +252,7 @@ static MPP_RET vdpu_av1d_filtermem_alloc(Av1dHalCtx *p_hal, VdpuAv1dRegCtx *ctx,
     //     asic_buff->rfc_col_size = NEXT_MULTIPLE(asic_buff->height, 8) / 8 * 16 * 2;
     //     size += asic_buff->rfc_col_size * num_tile_cols;
     // }
-    if (!mpp_buffer_get(p_hal->buf_group, &ctx->filter_mem, MPP_ALIGN(size, SZ_4K)))
+    if (!mpp_buffer_get(p_hal->buf_group, &reg_buf->filter_mem, MPP_ALIGN(size, SZ_4K)))
         return MPP_NOK;
 
     return MPP_OK;
@@ -236,16 +265,19 @@ static void hal_av1d_release_res(void *hal)
     RK_U32 i = 0;
     RK_U32 loop = p_hal->fast_mode ? MPP_ARRAY_ELEMS(reg_ctx->reg_buf) : 1;
 
-    for (i = 0; i < loop; i++)
-        MPP_FREE(reg_ctx->reg_buf[i].regs);
+    for (i = 0; i < loop; i++) {
+        av1dVdpuBuf *reg_buf = &reg_ctx->reg_buf[i];
+
+        MPP_FREE(reg_buf->regs);
+        BUF_PUT(reg_buf->prob_tbl_base);
+        BUF_PUT(reg_buf->prob_tbl_out_base);
+        BUF_PUT(reg_buf->tile_info);
+        BUF_PUT(reg_buf->film_grain_mem);
+        BUF_PUT(reg_buf->global_model);
+        BUF_PUT(reg_buf->tile_buf);
+        vdpu_av1d_filtermem_release(reg_buf);
+    }
 
-    BUF_PUT(reg_ctx->prob_tbl_base);
-    BUF_PUT(reg_ctx->prob_tbl_out_base);
-    BUF_PUT(reg_ctx->tile_info);
-    BUF_PUT(reg_ctx->film_grain_mem);
-    BUF_PUT(reg_ctx->global_model);
-    BUF_PUT(reg_ctx->tile_buf);
-    vdpu_av1d_filtermem_release(reg_ctx);
     hal_bufs_deinit(reg_ctx->tile_out_bufs);
 
     MPP_FREE(p_hal->reg_ctx);
@@ -1855,6 +1887,7 @@ MPP_RET vdpu_av1d_gen_regs(void *hal, HalTaskInfo *task)
     MPP_RET ret = MPP_ERR_UNKNOW;
     Av1dHalCtx *p_hal = (Av1dHalCtx *)hal;
     VdpuAv1dRegCtx *ctx = (VdpuAv1dRegCtx *)p_hal->reg_ctx;
+    av1dVdpuBuf *reg_buf;
     VdpuAv1dRegSet *regs;
     DXVA_PicParams_AV1 *dxva = (DXVA_PicParams_AV1*)task->dec.syntax.data;
     MppFrame mframe;
@@ -1871,6 +1904,14 @@ MPP_RET vdpu_av1d_gen_regs(void *hal, HalTaskInfo *task)
 
     ctx->refresh_frame_flags = dxva->refresh_frame_flags;
 
+    /*
+     * The parser only needs the hardware probability output when this frame
+     * refreshes a reference with end of frame cdf update. Otherwise the next
+     * frame can be parsed while this one is still in hardware.
+     */
+    task->dec.flags.wait_done = (!dxva->coding.disable_frame_end_update_cdf &&
+                                 dxva->refresh_frame_flags) ? 1 : 0;
+
     if (task->dec.flags.parse_err ||
         task->dec.flags.ref_err) {
         mpp_err_f("parse err %d ref err %d\n",
@@ -1884,26 +1925,32 @@ MPP_RET vdpu_av1d_gen_regs(void *hal, HalTaskInfo *task)
         for (i = 0; i <  MPP_ARRAY_ELEMS(ctx->reg_buf); i++) {
             if (!ctx->reg_buf[i].valid) {
                 task->dec.reg_index = i;
-                ctx->regs = ctx->reg_buf[i].regs;
                 ctx->reg_buf[i].valid = 1;
                 break;
             }
         }
     }
+    reg_buf = &ctx->reg_buf[p_hal->fast_mode ? task->dec.reg_index : 0];
+    vdpu_av1d_select_reg_buf(ctx, reg_buf - ctx->reg_buf);
 
     regs = ctx->regs;
     memset(regs, 0, sizeof(*regs));
 
     vdpu_av1d_setup_tile_bufs(p_hal, dxva);
 
-    if (!ctx->filter_mem || height > ctx->height || num_tile_cols > ctx->num_tile_cols) {
-        if (ctx->filter_mem)
-            vdpu_av1d_filtermem_release(ctx);
-        ret = vdpu_av1d_filtermem_alloc(p_hal, ctx, dxva);
+    /* the filter buffer of this register set is not used by other tasks in hardware */
+    if (!reg_buf->filter_mem || height > reg_buf->filt_height ||
+        num_tile_cols > reg_buf->filt_tile_cols) {
+        if (reg_buf->filter_mem)
+            vdpu_av1d_filtermem_release(reg_buf);
+        ret = vdpu_av1d_filtermem_alloc(p_hal, reg_buf, dxva);
         if (!ret) {
             mpp_err("filt buffer get fail\n");
-            vdpu_av1d_filtermem_release(ctx);
+            vdpu_av1d_filtermem_release(reg_buf);
         }
+        reg_buf->filt_height = height;
+        reg_buf->filt_tile_cols = num_tile_cols;
+        ctx->filter_mem = reg_buf->filter_mem;
     }
 
     ctx->width = width;
@@ -2306,9 +2353,8 @@ MPP_RET vdpu_av1d_wait(void *hal, HalTaskInfo *task)
 
     INP_CHECK(ret, NULL == p_hal);
     VdpuAv1dRegCtx *reg_ctx = (VdpuAv1dRegCtx *)p_hal->reg_ctx;
-    VdpuAv1dRegSet *p_regs = p_hal->fast_mode ?
-                             reg_ctx->reg_buf[task->dec.reg_index].regs :
-                             reg_ctx->regs;
+    av1dVdpuBuf *reg_buf = &reg_ctx->reg_buf[p_hal->fast_mode ? task->dec.reg_index : 0];
+    VdpuAv1dRegSet *p_regs = reg_buf->regs;
 
     if (task->dec.flags.parse_err ||
         task->dec.flags.ref_err) {
@@ -2337,12 +2383,12 @@ MPP_RET vdpu_av1d_wait(void *hal, HalTaskInfo *task)
 #endif
 
 __SKIP_HARD:
-    if (p_hal->dec_cb) {
+    if (p_hal->dec_cb && task->dec.flags.wait_done) {
         DecCbHalDone m_ctx;
-        RK_U32 *prob_out = (RK_U32*)mpp_buffer_get_ptr(reg_ctx->prob_tbl_out_base);
+        RK_U32 *prob_out = (RK_U32*)mpp_buffer_get_ptr(reg_buf->prob_tbl_out_base);
 
-        mpp_buffer_sync_ro_begin(reg_ctx->prob_tbl_out_base);
-        m_ctx.task = mpp_buffer_get_ptr(reg_ctx->prob_tbl_out_base);//(void *)&task->dec;
+        mpp_buffer_sync_ro_begin(reg_buf->prob_tbl_out_base);
+        m_ctx.task = mpp_buffer_get_ptr(reg_buf->prob_tbl_out_base);//(void *)&task->dec;
         m_ctx.regs = (RK_U32 *)prob_out;
         if (!p_regs->swreg1.sw_dec_rdy_int/* decode err */)
             m_ctx.hard_err = 1;
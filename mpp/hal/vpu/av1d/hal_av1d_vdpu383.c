@@ -1679,14 +1679,9 @@ static MPP_RET prepare_uncompress_header(Av1dHalCtx *p_hal, DXVA_PicParams_AV1 *
 
         mpp_put_bits(&bp, dxva->film_grain.scaling_shift_minus8, 2);
         mpp_put_bits(&bp, dxva->film_grain.ar_coeff_lag, 2);
-        for (i = 0; i < 24; ++i)
-            mpp_put_bits(&bp, dxva->film_grain.ar_coeffs_y[i], 8);
-
-        for (i = 0; i < 25; ++i)
-            mpp_put_bits(&bp, dxva->film_grain.ar_coeffs_cb[i], 8);
-
-        for (i = 0; i < 25; ++i)
-            mpp_put_bits(&bp, dxva->film_grain.ar_coeffs_cr[i], 8);
+        mpp_put_bytes(&bp, dxva->film_grain.ar_coeffs_y, 24);
+        mpp_put_bytes(&bp, dxva->film_grain.ar_coeffs_cb, 25);
+        mpp_put_bytes(&bp, dxva->film_grain.ar_coeffs_cr, 25);
 
         mpp_put_bits(&bp, dxva->film_grain.ar_coeff_shift_minus6, 2);
         mpp_put_bits(&bp, dxva->film_grain.grain_scale_shift, 2);
@@ -191,6 +191,7 @@ public:
 
     RK_U32          mEncAyncIo;
     RK_U32          mEncAyncProc;
+    RK_S32          mEncTaskCount;
     MppIoMode       mIoMode;
     RK_U32          mDisableThread;
 
@@ -126,6 +126,9 @@ MPP_RET mpp_cfg_node_fixup_func(MppCfgInfoNode *node);
 MPP_RET check_cfg_info(MppCfgInfoNode *node, const char *name, CfgType type,
                        const char *func);
 
+/* set by node data type, val points to the value or to the struct pointer */
+MPP_RET mpp_cfg_set_by_type(MppCfgInfoNode *info, void *cfg, void *val);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -38,6 +38,7 @@ typedef enum MppDecCfgChange_e {
     MPP_DEC_CFG_CHANGE_ENABLE_HDR_META  = (1 << 17),
     MPP_DEC_CFG_CHANGE_ENABLE_THUMBNAIL = (1 << 18),
     MPP_DEC_CFG_CHANGE_ENABLE_MVC       = (1 << 19),
+    MPP_DEC_CFG_CHANGE_TASK_COUNT       = (1 << 20),
     /* reserve high bit for global config */
     MPP_DEC_CFG_CHANGE_DISABLE_THREAD   = (1 << 28),
 
@@ -77,6 +78,8 @@ typedef struct MppDecBaseCfg_t {
     RK_U32              enable_hdr_meta;
     RK_U32              enable_thumbnail;
     RK_U32              enable_mvc;
+    /* parser / hal pipeline depth 1 ~ 3 on fast_parse mode, set before init */
+    RK_U32              task_count;
     RK_U32              disable_thread;
 } MppDecBaseCfg;
 
@@ -90,7 +93,10 @@ typedef enum MppDecCbCfgChange_e {
 typedef struct MppDecCbCfg_t {
     RK_U64              change;
 
-    /* notify packet process done and can accept new packet */
+    /*
+     * notify packet process done and can accept new packet
+     * arg is the input MppBuffer on zero copy input otherwise NULL
+     */
     MppExtCbFunc        pkt_rdy_cb;
     MppExtCbCtx         pkt_rdy_ctx;
     RK_S32              pkt_rdy_cmd;
@@ -23,6 +23,16 @@
 
 typedef void* MppDump;
 
+/*
+ * decoder stage timing summed over all instances which have timing enabled
+ * by mpp_dec_debug timing flag or mpp_dec_stat env, added on decoder deinit
+ */
+typedef struct MppDecTimingStat_t {
+    const char  *name;
+    RK_S64      sum;
+    RK_S64      count;
+} MppDecTimingStat;
+
 #ifdef  __cplusplus
 extern "C" {
 #endif
@@ -40,6 +50,9 @@ MPP_RET mpp_ops_enc_get_pkt(MppDump info, MppPacket pkt);
 MPP_RET mpp_ops_ctrl(MppDump info, MpiCmd cmd);
 MPP_RET mpp_ops_reset(MppDump info);
 
+/* return the number of stage filled to stat */
+RK_S32 mpp_dec_timing_stat_get(MppDecTimingStat *stat, RK_S32 max);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -37,6 +37,7 @@
 #include "mpp_packet_impl.h"
 
 #include "mpp_dec_cfg_impl.h"
+#include "mpp_dev_mock_api.h"
 
 #define MPP_TEST_FRAME_SIZE     SZ_1M
 #define MPP_TEST_PACKET_SIZE    SZ_512K
@@ -60,20 +61,36 @@ static void *list_wraper_frame(void *arg)
     return NULL;
 }
 
-static RK_S32 check_frm_task_cnt_cap(MppCodingType coding)
+static RK_S32 check_frm_task_cnt_cap(MppCodingType coding, RK_S32 task_cnt)
 {
     RockchipSocType soc_type = mpp_get_soc_type();
+    RK_S32 cap = 1;
 
     if (soc_type == ROCKCHIP_SOC_RK3588 || soc_type == ROCKCHIP_SOC_RK3576) {
         if (coding == MPP_VIDEO_CodingAVC || coding == MPP_VIDEO_CodingHEVC)
-            return 2;
+            cap = 2;
         if (coding == MPP_VIDEO_CodingMJPEG && soc_type == ROCKCHIP_SOC_RK3588)
-            return 4;
+            cap = 4;
     }
 
-    mpp_log("Only rk3588's h264/265/jpeg and rk3576's h264/265 encoder can use frame parallel\n");
+    /* mock device has no register set limit for pipeline benchmark */
+    if (mpp_dev_mock_enabled())
+        cap = MPP_ENC_TASK_COUNT_MAX;
 
-    return 1;
+    if (cap == 1) {
+        mpp_log("Only rk3588's h264/265/jpeg and rk3576's h264/265 encoder can use frame parallel\n");
+        return 1;
+    }
+
+    if (task_cnt <= 0)
+        return cap;
+
+    if (task_cnt > cap) {
+        mpp_log("encoder task count %d is limited to %d\n", task_cnt, cap);
+        task_cnt = cap;
+    }
+
+    return task_cnt;
 }
 
 Mpp::Mpp(MppCtx ctx)
@@ -105,6 +122,7 @@ Mpp::Mpp(MppCtx ctx)
       mEnc(NULL),
       mEncAyncIo(0),
       mEncAyncProc(0),
+      mEncTaskCount(0),
       mIoMode(MPP_IO_MODE_DEFAULT),
       mDisableThread(0),
       mDump(NULL),
@@ -210,12 +228,14 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
         mpp_buffer_group_get_internal(&mFrameGroup, MPP_BUFFER_TYPE_ION);
 
-        if (mInputTimeout == MPP_POLL_NON_BLOCK) {
-            mEncAyncIo = 1;
+        if (mInputTimeout == MPP_POLL_NON_BLOCK || mEncTaskCount > 1) {
+            input_task_count = check_frm_task_cnt_cap(coding, mEncTaskCount);
 
-            input_task_count = check_frm_task_cnt_cap(coding);
-            if (input_task_count == 1)
-                mInputTimeout = MPP_POLL_BLOCK;
+            if (mInputTimeout == MPP_POLL_NON_BLOCK) {
+                mEncAyncIo = 1;
+                if (input_task_count == 1)
+                    mInputTimeout = MPP_POLL_BLOCK;
+            }
         }
 
         mpp_task_queue_setup(mInputTaskQueue, input_task_count);
@@ -236,7 +256,14 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         if (ret)
             break;
 
-        if (mInputTimeout == MPP_POLL_NON_BLOCK) {
+        /*
+         * NOTE: more than one task uses async thread to encode next frame
+         * while previous frame is running on hardware. Then input frame is
+         * returned in the meta of output packet on both block and non-block
+         * input mode.
+         */
+        if (input_task_count > 1) {
+            mEncAyncIo = 1;
             mEncAyncProc = 1;
             ret = mpp_enc_start_async(mEnc);
         } else {
@@ -364,7 +391,7 @@ MPP_RET Mpp::put_packet(MppPacket packet)
     MPP_RET ret = MPP_NOK;
     MppPollType timeout = mInputTimeout;
     MppTask task_dequeue = NULL;
-    RK_U32 pkt_copy = 0;
+    MppPacket pkt_in = NULL;
 
     if (mDisableThread) {
         mpp_err_f("no thread decoding case MUST use mpi_decode interface\n");
@@ -420,25 +447,29 @@ MPP_RET Mpp::put_packet(MppPacket packet)
         }
     }
 
-    if (NULL == mpp_packet_get_buffer(packet)) {
-        /* packet copy path */
-        MppPacket pkt_in = NULL;
-
-        mpp_packet_copy_init(&pkt_in, packet);
-        mpp_packet_set_length(packet, 0);
-        pkt_copy = 1;
-        packet = pkt_in;
-        ret = MPP_OK;
-    } else {
-        /* packet zero copy path */
-        mpp_log_f("not support zero copy path\n");
-        timeout = MPP_POLL_BLOCK;
+    /*
+     * packet without buffer goes copy path: the data is copied to internal
+     * memory and the caller can reuse its memory right after return.
+     *
+     * packet with buffer goes zero copy path: decoder only takes a reference
+     * of the buffer and parser reads the buffer memory in place. The reference
+     * is dropped when parser has consumed all the data and then pkt_rdy_cb is
+     * called with the buffer as arg.
+     */
+    ret = mpp_packet_copy_init(&pkt_in, packet);
+    if (ret) {
+        mpp_err_f("failed to init input packet ret %d\n", ret);
+        mInputTask = task_dequeue;
+        goto RET;
     }
+    mpp_packet_set_length(packet, 0);
+    packet = pkt_in;
 
     /* setup task */
     ret = mpp_task_meta_set_packet(task_dequeue, KEY_INPUT_PACKET, packet);
     if (ret) {
         mpp_err_f("set input frame to task ret %d\n", ret);
+        mpp_packet_deinit(&pkt_in);
         /* keep current task for next */
         mInputTask = task_dequeue;
         goto RET;
@@ -455,9 +486,6 @@ MPP_RET Mpp::put_packet(MppPacket packet)
 
     mPacketPutCount++;
 
-    if (timeout && !pkt_copy)
-        ret = poll(MPP_PORT_INPUT, timeout);
-
 RET:
     /* wait enqueued task finished */
     if (NULL == mInputTask) {
@@ -629,7 +657,7 @@ MPP_RET Mpp::put_frame(MppFrame frame)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    if (mInputTimeout == MPP_POLL_NON_BLOCK) {
+    if (mEncAyncProc) {
         set_io_mode(MPP_IO_MODE_NORMAL);
         return put_frame_async(frame);
     }
@@ -747,7 +775,7 @@ MPP_RET Mpp::get_packet(MppPacket *packet)
     if (!mInitDone)
         return MPP_ERR_INIT;
 
-    if (mInputTimeout == MPP_POLL_NON_BLOCK) {
+    if (mEncAyncProc) {
         set_io_mode(MPP_IO_MODE_NORMAL);
         return get_packet_async(packet);
     }
@@ -806,13 +834,27 @@ MPP_RET Mpp::put_frame_async(MppFrame frame)
     if (NULL == mFrmIn)
         return MPP_NOK;
 
-    if (mFrmIn->trylock())
-        return MPP_NOK;
+    if (mInputTimeout == MPP_POLL_NON_BLOCK) {
+        if (mFrmIn->trylock())
+            return MPP_NOK;
 
-    /* NOTE: the max input queue length is 2 */
-    if (mFrmIn->wait_le(10, 1)) {
-        mFrmIn->unlock();
-        return MPP_NOK;
+        /* NOTE: the max input queue length is 2 */
+        if (mFrmIn->wait_le(10, 1)) {
+            mFrmIn->unlock();
+            return MPP_NOK;
+        }
+    } else {
+        /* block input on multiple task mode waits for encoder taking frame */
+        mFrmIn->lock();
+
+        while (mFrmIn->list_size() > 1) {
+            if (mInputTimeout < 0) {
+                mFrmIn->wait();
+            } else if (mFrmIn->wait(mInputTimeout)) {
+                mFrmIn->unlock();
+                return MPP_ERR_TIMEOUT;
+            }
+        }
     }
 
     mFrmIn->add_at_tail(&frame, sizeof(frame));
@@ -1119,6 +1161,24 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
     case MPP_SET_DISABLE_THREAD: {
         mDisableThread = 1;
     } break;
+    case MPP_SET_ENC_TASK_COUNT: {
+        RK_S32 task_cnt = (param) ? *((RK_S32 *)param) : 0;
+
+        if (mInitDone) {
+            mpp_err("encoder task count should be set before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        if (task_cnt < 0 || task_cnt > MPP_ENC_TASK_COUNT_MAX) {
+            mpp_err("invalid encoder task count %d should be in range [0, %d]\n",
+                    task_cnt, MPP_ENC_TASK_COUNT_MAX);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        mEncTaskCount = task_cnt;
+    } break;
 
     case MPP_SET_INPUT_TIMEOUT:
     case MPP_SET_OUTPUT_TIMEOUT: {
@@ -1277,6 +1337,7 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
     case MPP_DEC_GET_VPUMEM_USED_COUNT :
     case MPP_DEC_SET_OUTPUT_FORMAT :
     case MPP_DEC_QUERY :
+    case MPP_DEC_GET_LATENCY :
     case MPP_DEC_SET_MAX_USE_BUFFER_SIZE: {
         ret = mpp_dec_control(mDec, cmd, param);
     } break;
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2010 Rockchip Electronics S.LSI Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __VERSION_H__
+#define __VERSION_H__
+
+#define MPP_VERSION             "d303791 author: agent          2026-10-16 [user-025] fix: sync input buffer cache before lookahead downscale"
+#define MPP_VER_HIST_CNT        10
+#define MPP_VER_HIST_0          "d303791 author: agent          2026-10-16 [user-025] fix: sync input buffer cache before lookahead downscale  (HEAD -> master)"
+#define MPP_VER_HIST_1          "942c93c author: agent          2026-10-16 [user-004] fix: read back mock registers from per task snapshot"
+#define MPP_VER_HIST_2          "42c088f author: agent          2026-10-16 [user-023] fix: initialise pipe test timers on error paths"
+#define MPP_VER_HIST_3          "a537dec author: agent          2026-10-16 [user-010] fix: avoid 32 bit shift of size_t in buf_size_class"
+#define MPP_VER_HIST_4          "ec332e9 author: agent          2026-10-16 [user-016] fix: per task av1 filter buffers and opt-in fast mode"
+#define MPP_VER_HIST_5          "74ff776 author: agent          2026-10-16 [user-011] fix: keep caller owned packets in advanced mode ports"
+#define MPP_VER_HIST_6          "8a02007 author: agent          2026-10-16 [user-025] rc: add lookahead rc with software pre-analysis"
+#define MPP_VER_HIST_7          "16598a8 author: agent          2026-10-16 [user-024] rc: add rc trace and host replay test"
+#define MPP_VER_HIST_8          "5b4b35f author: agent          2026-10-16 [user-023] mpp_enc: configurable frames in flight with rc reconcile"
+#define MPP_VER_HIST_9          "553e704 author: agent          2026-10-16 [user-022] hal_h264e_amend: rewrite slice headers in place"
+
+#endif /*__VERSION_H__*/
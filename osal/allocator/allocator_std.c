@@ -15,19 +15,51 @@
  */
 
 #include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "os_mem.h"
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_debug.h"
+#include "mpp_common.h"
 
 #include "allocator_std.h"
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC             0x0001U
+#endif
+
+/* large buffer to be backed by transparent huge page */
+#define STD_THP_SIZE            SZ_2M
+/* handle of imported buffer whose fd is duplicated by allocator */
+#define STD_HND_FD_DUP          ((void *)1)
+
 typedef struct {
     size_t              alignment;
     MppAllocFlagType    flags;
     RK_S32              fd_count;
+    RK_U32              thp;
 } allocator_ctx;
 
+/*
+ * memfd gives each buffer a real fd which can be mmapped and shared across
+ * processes like a dma-buf fd. Call syscall directly for old libc.
+ */
+static RK_S32 std_memfd_create(const char *name)
+{
+#ifdef __NR_memfd_create
+    return syscall(__NR_memfd_create, name, MFD_CLOEXEC);
+#else
+    (void)name;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType flags)
 {
     allocator_ctx *p = NULL;
@@ -44,6 +76,7 @@ static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType
         p->alignment = alignment;
         p->flags = flags;
         p->fd_count = 0;
+        mpp_env_get_u32("allocator_std_thp", &p->thp, 0);
     }
 
     *ctx = p;
@@ -52,22 +85,52 @@ static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType
 
 static MPP_RET allocator_std_alloc(void *ctx, MppBufferInfo *info)
 {
+    allocator_ctx *p = (allocator_ctx *)ctx;
+    size_t size;
+    RK_S32 fd;
+
     if (NULL == ctx) {
         mpp_err_f("found NULL context input\n");
         return MPP_ERR_NULL_PTR;
     }
 
-    mpp_err_f("Warning: std allocator should be used on simulation mode only\n");
-    (void)info;
+    fd = std_memfd_create("mpp_buffer");
+    if (fd < 0) {
+        mpp_err_f("memfd_create failed: %s\n", strerror(errno));
+        return MPP_NOK;
+    }
 
-    return MPP_NOK;
+    /*
+     * huge page backing needs the whole huge page in the file and mapping so
+     * the rounded size is stored for mmap, madvise and munmap
+     */
+    size = MPP_ALIGN(info->size, p->alignment);
+    if (p->thp && size >= STD_THP_SIZE)
+        size = MPP_ALIGN(size, STD_THP_SIZE);
+
+    if (ftruncate(fd, size)) {
+        mpp_err_f("ftruncate size %d failed: %s\n", size, strerror(errno));
+        close(fd);
+        return MPP_NOK;
+    }
+
+    /* mapped on mpp_buffer_get_ptr like dma-buf */
+    info->size = size;
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+
+    return MPP_OK;
 }
 
 static MPP_RET allocator_std_free(void *ctx, MppBufferInfo *info)
 {
     (void) ctx;
-    if (info->ptr)
-        os_free(info->ptr);
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+    close(info->fd);
     return MPP_OK;
 }
 
@@ -75,18 +138,34 @@ static MPP_RET allocator_std_import(void *ctx, MppBufferInfo *info)
 {
     allocator_ctx *p = (allocator_ctx *)ctx;
     mpp_assert(ctx);
-    mpp_assert(info->ptr);
     mpp_assert(info->size);
+
+    /* fd only import is duplicated and mapped on demand like dma-buf */
+    if (NULL == info->ptr) {
+        RK_S32 fd_ext = info->fd;
+
+        mpp_assert(fd_ext >= 0);
+
+        info->fd    = mpp_dup(fd_ext);
+        info->hnd   = STD_HND_FD_DUP;
+        return (info->fd >= 0) ? MPP_OK : MPP_NOK;
+    }
+
     info->hnd   = NULL;
-    info->fd    = p->fd_count++;
+    if (info->fd <= 0)
+        info->fd = p->fd_count++;
     return MPP_OK;
 }
 
 static MPP_RET allocator_std_release(void *ctx, MppBufferInfo *info)
 {
     (void) ctx;
-    mpp_assert(info->ptr);
     mpp_assert(info->size);
+    if (info->hnd == STD_HND_FD_DUP) {
+        if (info->ptr)
+            munmap(info->ptr, info->size);
+        close(info->fd);
+    }
     info->ptr   = NULL;
     info->size  = 0;
     info->hnd   = NULL;
@@ -96,9 +175,31 @@ static MPP_RET allocator_std_release(void *ctx, MppBufferInfo *info)
 
 static MPP_RET allocator_std_mmap(void *ctx, MppBufferInfo *info)
 {
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
     mpp_assert(ctx);
-    mpp_assert(info->ptr);
     mpp_assert(info->size);
+
+    /* imported buffer has valid pointer already */
+    if (info->ptr)
+        return MPP_OK;
+
+    info->ptr = mmap(NULL, info->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     info->fd, 0);
+    if (info->ptr == MAP_FAILED) {
+        mpp_err_f("mmap fd %d size %d failed: %s\n", info->fd, info->size,
+                  strerror(errno));
+        info->ptr = NULL;
+        return MPP_NOK;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (p->thp && info->size >= STD_THP_SIZE)
+        madvise(info->ptr, info->size, MADV_HUGEPAGE);
+#else
+    (void)p;
+#endif
+
     return MPP_OK;
 }
 
@@ -0,0 +1,523 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_mock"
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "mpp_device_debug.h"
+#include "mpp_dev_mock_api.h"
+
+#define MOCK_MAX_REQ        32
+#define MOCK_MAX_TASK       8
+#define MOCK_REG_ALIGN      256
+
+typedef struct MockRegReq_t {
+    void            *reg;
+    RK_U32          size;
+    RK_U32          offset;
+} MockRegReq;
+
+typedef struct MockTask_t {
+    RK_S64          done_time;
+    RK_S32          rd_cnt;
+    MockRegReq      rd[MOCK_MAX_REQ];
+
+    /* register file snapshot at send for readback on poll */
+    RK_U8           *regs;
+    RK_U32          regs_size;
+} MockTask;
+
+typedef struct MppDevMock_t {
+    MppClientType   type;
+    RK_S32          batch_io;
+    MppCbCtx        *dev_cb;
+
+    /* shadow register file written on send and read back on poll */
+    RK_U8           *regs;
+    RK_U32          regs_size;
+
+    RK_S32          wr_cnt;
+    MockRegReq      wr[MOCK_MAX_REQ];
+    RK_S32          rd_cnt;
+    MockRegReq      rd[MOCK_MAX_REQ];
+
+    /* task fifo between cmd_send and cmd_poll */
+    RK_S32          task_rd;
+    RK_S32          task_wr;
+    RK_S32          task_cnt;
+    MockTask        tasks[MOCK_MAX_TASK];
+
+    MppDevMockStat  stat;
+
+    pthread_mutex_t     lock_bufs;
+    struct list_head    list_bufs;
+} MppDevMock;
+
+static RK_U32 mock_latency = 0;
+static pthread_mutex_t mock_lock = PTHREAD_MUTEX_INITIALIZER;
+/* time when the simulated hardware core of each client type gets idle */
+static RK_S64 mock_hw_idle[VPU_CLIENT_BUTT];
+static MppDevMockStat mock_stat;
+
+RK_U32 mpp_dev_mock_enabled(void)
+{
+    RK_U32 enable = 0;
+
+    mpp_env_get_u32("mpp_dev_mock", &enable, 0);
+
+    return enable;
+}
+
+MPP_RET mpp_dev_mock_get_stat(MppDevMockStat *stat)
+{
+    if (NULL == stat)
+        return MPP_ERR_NULL_PTR;
+
+    pthread_mutex_lock(&mock_lock);
+    memcpy(stat, &mock_stat, sizeof(*stat));
+    pthread_mutex_unlock(&mock_lock);
+
+    return MPP_OK;
+}
+
+static MPP_RET mock_add_req(MockRegReq *reqs, RK_S32 *cnt, void *reg,
+                            RK_U32 size, RK_U32 offset)
+{
+    MockRegReq *req;
+
+    if (*cnt >= MOCK_MAX_REQ) {
+        mpp_err_f("reach max request count %d\n", MOCK_MAX_REQ);
+        return MPP_NOK;
+    }
+
+    req = &reqs[*cnt];
+    req->reg = reg;
+    req->size = size;
+    req->offset = offset;
+    (*cnt)++;
+
+    return MPP_OK;
+}
+
+static MPP_RET mock_task_snapshot(MppDevMock *p, MockTask *task)
+{
+    if (task->regs_size < p->regs_size) {
+        RK_U8 *regs = mpp_realloc(task->regs, RK_U8, p->regs_size);
+
+        if (NULL == regs) {
+            mpp_err_f("failed to expand task register to %d\n", p->regs_size);
+            return MPP_ERR_MALLOC;
+        }
+
+        task->regs = regs;
+        task->regs_size = p->regs_size;
+    }
+
+    memcpy(task->regs, p->regs, p->regs_size);
+
+    return MPP_OK;
+}
+
+static MPP_RET mock_check_regs(MppDevMock *p, RK_U32 end)
+{
+    RK_U8 *regs;
+
+    if (end <= p->regs_size)
+        return MPP_OK;
+
+    end = MPP_ALIGN(end, MOCK_REG_ALIGN);
+    regs = mpp_realloc(p->regs, RK_U8, end);
+    if (NULL == regs) {
+        mpp_err_f("failed to expand shadow register to %d\n", end);
+        return MPP_ERR_MALLOC;
+    }
+
+    memset(regs + p->regs_size, 0, end - p->regs_size);
+    p->regs = regs;
+    p->regs_size = end;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_init(void *ctx, MppClientType type)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    if (type < 0 || type >= VPU_CLIENT_BUTT) {
+        mpp_err_f("invalid client type %d\n", type);
+        return MPP_NOK;
+    }
+
+    mpp_env_get_u32("mpp_dev_mock_latency", &mock_latency, 0);
+
+    p->type = type;
+    p->batch_io = 0;
+    p->dev_cb = NULL;
+
+    INIT_LIST_HEAD(&p->list_bufs);
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&p->lock_bufs, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    mpp_dev_dbg_probe("client %d latency %d us\n", type, mock_latency);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_deinit(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+    MppDevMockStat *s = &p->stat;
+    MppDevBufMapNode *pos, *n;
+    RK_S32 i;
+
+    pthread_mutex_lock(&p->lock_bufs);
+    list_for_each_entry_safe(pos, n, &p->list_bufs, MppDevBufMapNode, list_dev) {
+        pthread_mutex_t *lock_buf = pos->lock_buf;
+
+        pthread_mutex_lock(lock_buf);
+
+        list_del_init(&pos->list_dev);
+        list_del_init(&pos->list_buf);
+        pos->lock_buf = NULL;
+        pos->lock_dev = NULL;
+        pos->iova = (RK_U32)(-1);
+        mpp_mem_pool_put_f(__FUNCTION__, pos->pool, pos);
+
+        pthread_mutex_unlock(lock_buf);
+    }
+    pthread_mutex_unlock(&p->lock_bufs);
+    pthread_mutex_destroy(&p->lock_bufs);
+
+    if (p->task_cnt)
+        mpp_err_f("client %d deinit with %d task unpolled\n", p->type, p->task_cnt);
+
+    pthread_mutex_lock(&mock_lock);
+    mock_stat.reg_wr_cnt  += s->reg_wr_cnt;
+    mock_stat.reg_wr_size += s->reg_wr_size;
+    mock_stat.reg_rd_cnt  += s->reg_rd_cnt;
+    mock_stat.reg_rd_size += s->reg_rd_size;
+    mock_stat.send_cnt    += s->send_cnt;
+    mock_stat.poll_cnt    += s->poll_cnt;
+    mock_stat.wait_time   += s->wait_time;
+    pthread_mutex_unlock(&mock_lock);
+
+    mpp_dev_dbg_probe("client %d send %lld poll %lld wr %lld:%lld rd %lld:%lld wait %lld us\n",
+                      p->type, s->send_cnt, s->poll_cnt, s->reg_wr_cnt, s->reg_wr_size,
+                      s->reg_rd_cnt, s->reg_rd_size, s->wait_time);
+
+    MPP_FREE(p->regs);
+    for (i = 0; i < MOCK_MAX_TASK; i++)
+        MPP_FREE(p->tasks[i].regs);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_attach(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    p->batch_io = 1;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_detach(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    p->batch_io = 0;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_delimit(void *ctx)
+{
+    (void)ctx;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_set_cb_ctx(void *ctx, MppCbCtx *cb_ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    p->dev_cb = cb_ctx;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_reg_wr(void *ctx, MppDevRegWrCfg *cfg)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    mpp_dev_dbg_reg("client %d wr offset %04x size %d\n", p->type,
+                    cfg->offset, cfg->size);
+
+    return mock_add_req(p->wr, &p->wr_cnt, cfg->reg, cfg->size, cfg->offset);
+}
+
+MPP_RET mpp_dev_mock_reg_rd(void *ctx, MppDevRegRdCfg *cfg)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    mpp_dev_dbg_reg("client %d rd offset %04x size %d\n", p->type,
+                    cfg->offset, cfg->size);
+
+    return mock_add_req(p->rd, &p->rd_cnt, cfg->reg, cfg->size, cfg->offset);
+}
+
+MPP_RET mpp_dev_mock_reg_offset(void *ctx, MppDevRegOffsetCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_reg_offsets(void *ctx, MppDevRegOffCfgs *cfgs)
+{
+    (void)ctx;
+    (void)cfgs;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_rcb_info(void *ctx, MppDevRcbInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_set_info(void *ctx, MppDevInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_set_err_ref_hack(void *ctx, RK_U32 *enable)
+{
+    (void)ctx;
+    (void)enable;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_lock_map(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    pthread_mutex_lock(&p->lock_bufs);
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_unlock_map(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    pthread_mutex_unlock(&p->lock_bufs);
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_attach_fd(void *ctx, MppDevBufMapNode *node)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    mpp_assert(node->buffer);
+    mpp_assert(node->lock_buf);
+
+    /* use buffer fd as fake iova like the legacy vcodec_service does */
+    node->lock_dev = &p->lock_bufs;
+    node->dev_fd = -1;
+    node->iova = node->buf_fd;
+    list_add_tail(&node->list_dev, &p->list_bufs);
+
+    mpp_dev_dbg_buf("node %p attach fd %d iova %x\n", node, node->buf_fd, node->iova);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_detach_fd(void *ctx, MppDevBufMapNode *node)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+
+    mpp_assert(node->lock_dev == &p->lock_bufs);
+
+    mpp_dev_dbg_buf("node %p detach fd %d iova %x\n", node, node->buf_fd, node->iova);
+
+    node->dev = NULL;
+    node->lock_dev = NULL;
+    node->iova = (RK_U32)(-1);
+    list_del_init(&node->list_dev);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_mock_cmd_send(void *ctx)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+    MppDevMockStat *s = &p->stat;
+    MockTask *task;
+    RK_S64 now;
+    RK_S32 i;
+
+    if (p->wr_cnt + p->rd_cnt <= 0) {
+        mpp_err_f("ctx %p invalid request count %d\n", ctx, p->wr_cnt + p->rd_cnt);
+        return MPP_ERR_VALUE;
+    }
+
+    if (p->task_cnt >= MOCK_MAX_TASK) {
+        mpp_err_f("ctx %p task fifo full\n", ctx);
+        p->wr_cnt = 0;
+        p->rd_cnt = 0;
+        return MPP_NOK;
+    }
+
+    task = &p->tasks[p->task_wr];
+
+    for (i = 0; i < p->rd_cnt; i++) {
+        MockRegReq *req = &p->rd[i];
+
+        if (mock_check_regs(p, req->offset + req->size))
+            goto FAILED;
+    }
+
+    for (i = 0; i < p->wr_cnt; i++) {
+        MockRegReq *req = &p->wr[i];
+
+        if (mock_check_regs(p, req->offset + req->size))
+            goto FAILED;
+
+        memcpy(p->regs + req->offset, req->reg, req->size);
+        s->reg_wr_size += req->size;
+    }
+
+    /* later send overwrites the shared register file before this task is polled */
+    if (mock_task_snapshot(p, task))
+        goto FAILED;
+
+    s->reg_wr_cnt += p->wr_cnt;
+    p->wr_cnt = 0;
+
+    memcpy(task->rd, p->rd, sizeof(p->rd[0]) * p->rd_cnt);
+    task->rd_cnt = p->rd_cnt;
+    p->rd_cnt = 0;
+
+    /* tasks on the same hardware core run one by one */
+    now = mpp_time();
+    pthread_mutex_lock(&mock_lock);
+    task->done_time = MPP_MAX(now, mock_hw_idle[p->type]) + mock_latency;
+    mock_hw_idle[p->type] = task->done_time;
+    pthread_mutex_unlock(&mock_lock);
+
+    p->task_wr = (p->task_wr + 1) % MOCK_MAX_TASK;
+    p->task_cnt++;
+    s->send_cnt++;
+
+    return MPP_OK;
+
+FAILED:
+    p->wr_cnt = 0;
+    p->rd_cnt = 0;
+    return MPP_ERR_MALLOC;
+}
+
+MPP_RET mpp_dev_mock_cmd_poll(void *ctx, MppDevPollCfg *cfg)
+{
+    MppDevMock *p = (MppDevMock *)ctx;
+    MppDevMockStat *s = &p->stat;
+    MockTask *task;
+    RK_S64 now;
+    RK_S32 i;
+
+    if (p->task_cnt <= 0) {
+        mpp_err_f("ctx %p poll without task\n", ctx);
+        return MPP_NOK;
+    }
+
+    task = &p->tasks[p->task_rd];
+
+    now = mpp_time();
+    if (task->done_time > now) {
+        usleep(task->done_time - now);
+        s->wait_time += mpp_time() - now;
+    }
+
+    /* read ranges are checked on send so they are all in the snapshot */
+    for (i = 0; i < task->rd_cnt; i++) {
+        MockRegReq *req = &task->rd[i];
+
+        memcpy(req->reg, task->regs + req->offset, req->size);
+        s->reg_rd_size += req->size;
+    }
+    s->reg_rd_cnt += task->rd_cnt;
+
+    if (cfg) {
+        mpp_assert(cfg->count_max);
+        if (cfg->count_max) {
+            cfg->count_ret = 1;
+            cfg->slice_info[0].val = 0;
+            cfg->slice_info[0].last = 1;
+        }
+    }
+
+    p->task_rd = (p->task_rd + 1) % MOCK_MAX_TASK;
+    p->task_cnt--;
+    s->poll_cnt++;
+
+    return MPP_OK;
+}
+
+const MppDevApi mpp_dev_mock_api = {
+    "mpp_dev_mock",
+    sizeof(MppDevMock),
+    mpp_dev_mock_init,
+    mpp_dev_mock_deinit,
+    mpp_dev_mock_attach,
+    mpp_dev_mock_detach,
+    mpp_dev_mock_delimit,
+    mpp_dev_mock_set_cb_ctx,
+    mpp_dev_mock_reg_wr,
+    mpp_dev_mock_reg_rd,
+    mpp_dev_mock_reg_offset,
+    mpp_dev_mock_reg_offsets,
+    mpp_dev_mock_rcb_info,
+    mpp_dev_mock_set_info,
+    mpp_dev_mock_set_err_ref_hack,
+    mpp_dev_mock_lock_map,
+    mpp_dev_mock_unlock_map,
+    mpp_dev_mock_attach_fd,
+    mpp_dev_mock_detach_fd,
+    mpp_dev_mock_cmd_send,
+    mpp_dev_mock_cmd_poll,
+};
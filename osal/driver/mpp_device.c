@@ -26,6 +26,7 @@
 #include "mpp_device_debug.h"
 #include "mpp_service_api.h"
 #include "vcodec_service_api.h"
+#include "mpp_dev_mock_api.h"
 
 typedef struct MppDevImpl_t {
     MppClientType   type;
@@ -36,17 +37,14 @@ typedef struct MppDevImpl_t {
 
 RK_U32 mpp_device_debug = 0;
 
-MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
+static MPP_RET mpp_dev_get_api(MppClientType type, const MppDevApi **api)
 {
-    if (NULL == ctx) {
-        mpp_err_f("found NULL input ctx\n");
-        return MPP_ERR_NULL_PTR;
+    /* loopback device for benchmark without hardware */
+    if (mpp_dev_mock_enabled()) {
+        *api = &mpp_dev_mock_api;
+        return MPP_OK;
     }
 
-    mpp_env_get_u32("mpp_device_debug", &mpp_device_debug, 0);
-
-    *ctx = NULL;
-
     RK_U32 codec_type = mpp_get_vcodec_type();
     if (!(codec_type & (1 << type))) {
         mpp_err_f("found unsupported client type %d in platform %x\n",
@@ -55,14 +53,13 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
     }
 
     MppIoctlVersion ioctl_version = mpp_get_ioctl_version();
-    const MppDevApi *api = NULL;
 
     switch (ioctl_version) {
     case IOCTL_VCODEC_SERVICE : {
-        api = &vcodec_service_api;
+        *api = &vcodec_service_api;
     } break;
     case IOCTL_MPP_SERVICE_V1 : {
-        api = &mpp_service_api;
+        *api = &mpp_service_api;
     } break;
     default : {
         mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
@@ -70,6 +67,25 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
     } break;
     }
 
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
+{
+    if (NULL == ctx) {
+        mpp_err_f("found NULL input ctx\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_env_get_u32("mpp_device_debug", &mpp_device_debug, 0);
+
+    *ctx = NULL;
+
+    const MppDevApi *api = NULL;
+    MPP_RET ret = mpp_dev_get_api(type, &api);
+    if (ret)
+        return ret;
+
     MppDevImpl *impl = mpp_calloc(MppDevImpl, 1);
     void *impl_ctx = mpp_calloc_size(void, api->ctx_size);
     if (NULL == impl || NULL == impl_ctx) {
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEV_MOCK_API_H__
+#define __MPP_DEV_MOCK_API_H__
+
+#include "mpp_device.h"
+
+/*
+ * Loopback device without kernel driver for host side benchmark.
+ *
+ * Enabled by env mpp_dev_mock=1. Register write is stored into a shadow
+ * register file on cmd_send and register read is filled from the shadow
+ * register file on cmd_poll. Each client type is simulated as one hardware
+ * core which takes mpp_dev_mock_latency us to finish one task, so tasks from
+ * different device contexts of the same client type are serialized.
+ */
+typedef struct MppDevMockStat_t {
+    RK_U64  reg_wr_cnt;
+    RK_U64  reg_wr_size;
+    RK_U64  reg_rd_cnt;
+    RK_U64  reg_rd_size;
+    RK_U64  send_cnt;
+    RK_U64  poll_cnt;
+    /* time in us waiting for the simulated hardware in cmd_poll */
+    RK_S64  wait_time;
+} MppDevMockStat;
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+extern const MppDevApi mpp_dev_mock_api;
+
+RK_U32 mpp_dev_mock_enabled(void);
+/* accumulated statistic of all deinited mock device */
+MPP_RET mpp_dev_mock_get_stat(MppDevMockStat *stat);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_DEV_MOCK_API_H__ */
@@ -53,11 +53,31 @@ typedef struct {
     RK_S64  time;
 } spinlock_t;
 
+/*
+ * Lock statistic for the locks shared by all mpp instances.
+ * contend_cnt counts the lock calls which have to wait for another owner and
+ * wait_time is the total waiting time in us of these calls.
+ */
+typedef struct MppLockStat_t {
+    const char  *name;
+    RK_S64      lock_cnt;
+    RK_S64      contend_cnt;
+    RK_S64      wait_time;
+} MppLockStat;
+
 void mpp_spinlock_init(spinlock_t *lock);
 void mpp_spinlock_deinit(spinlock_t *lock, const char *name);
 void mpp_spinlock_lock(spinlock_t *lock);
 void mpp_spinlock_unlock(spinlock_t *lock);
 bool mpp_spinlock_trylock(spinlock_t *lock);
+/* lock and record to stat, stat can be NULL */
+void mpp_spinlock_lock_stat(spinlock_t *lock, MppLockStat *stat);
+
+/*
+ * get the process wide lock statistic by name, create on first call
+ * name should be a static string, e.g. MODULE_TAG of the lock owner
+ */
+MppLockStat *mpp_lock_stat_get(const char *name);
 
 #ifdef __cplusplus
 }
@@ -18,11 +18,25 @@
 #define __MPP_MEM_POOL_H__
 
 #include <stdlib.h>
+#include "mpp_err.h"
 #include "mpp_mem.h"
 #include "mpp_common.h"
 
 typedef void* MppMemPool;
 
+typedef struct MppMemPoolStat_t {
+    size_t      size;
+    RK_U64      get_count;
+    RK_U64      put_count;
+    /* get served by thread cache without touching the shared pool */
+    RK_U64      hit_count;
+    /* thread cache refilled from the shared free list */
+    RK_U64      refill_count;
+    /* nodes ever created, also the high-water mark of used and cached nodes */
+    RK_S32      node_count;
+    RK_S32      cached_count;
+} MppMemPoolStat;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -39,6 +53,8 @@ void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool);
 void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool);
 void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p);
 
+MPP_RET mpp_mem_pool_get_stat(MppMemPool pool, MppMemPoolStat *stat);
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,7 @@ typedef enum {
 #ifdef __cplusplus
 
 #include "mpp_debug.h"
+#include "mpp_lock.h"
 
 class Mutex;
 class Condition;
@@ -77,7 +78,8 @@ class Condition;
 class Mutex
 {
 public:
-    Mutex();
+    /* record lock count and contention to stat when stat is not NULL */
+    explicit Mutex(MppLockStat *stat = NULL);
     ~Mutex();
 
     void lock();
@@ -106,12 +108,15 @@ private:
     friend class Condition;
 
     pthread_mutex_t mMutex;
+    MppLockStat     *mStat;
+
+    void lock_stat();
 
     Mutex(const Mutex &);
     Mutex &operator = (const Mutex&);
 };
 
-inline Mutex::Mutex()
+inline Mutex::Mutex(MppLockStat *stat) : mStat(stat)
 {
     pthread_mutexattr_t attr;
     pthread_mutexattr_init(&attr);
@@ -125,7 +130,10 @@ inline Mutex::~Mutex()
 }
 inline void Mutex::lock()
 {
-    pthread_mutex_lock(&mMutex);
+    if (mStat)
+        lock_stat();
+    else
+        pthread_mutex_lock(&mMutex);
 }
 inline void Mutex::unlock()
 {
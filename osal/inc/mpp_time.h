@@ -32,6 +32,7 @@
 typedef void* MppClock;
 typedef void* MppTimer;
 typedef void* MppStopwatch;
+typedef void* MppTimeHist;
 
 #ifdef __cplusplus
 extern "C" {
@@ -109,6 +110,27 @@ void mpp_stopwatch_record(MppStopwatch stopwatch, const char *event);
 void mpp_stopwatch_put(MppStopwatch timer);
 RK_S64 mpp_stopwatch_elapsed_time(MppStopwatch stopwatch);
 
+/*
+ * MppTimeHist is a histogram of time in us for latency percentile statistic
+ *
+ * Time is recorded into log-linear bins with 16 bins per power of two. So the
+ * percentile has less than 1/32 relative error and the max value is exact.
+ * Add and query are protected by spinlock and can be called from different
+ * threads.
+ *
+ * mpp_time_hist_percentile - Return time at permille, 500 for p50 and 990
+ *                            for p99
+ */
+MppTimeHist mpp_time_hist_get(const char *name);
+void mpp_time_hist_put(MppTimeHist hist);
+void mpp_time_hist_add(MppTimeHist hist, RK_S64 time);
+void mpp_time_hist_reset(MppTimeHist hist);
+RK_S64 mpp_time_hist_get_count(MppTimeHist hist);
+RK_S64 mpp_time_hist_get_sum(MppTimeHist hist);
+RK_S64 mpp_time_hist_get_max(MppTimeHist hist);
+RK_S64 mpp_time_hist_percentile(MppTimeHist hist, RK_U32 permille);
+const char *mpp_time_hist_get_name(MppTimeHist hist);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,14 +16,22 @@
 
 #define MODULE_TAG "mpp_lock"
 
+#include <string.h>
+
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_lock.h"
 #include "mpp_time.h"
+#include "mpp_common.h"
 
 #define LOCK_IDLE   0
 #define LOCK_BUSY   1
 
+#define LOCK_STAT_MAX   16
+
+static MppLockStat lock_stats[LOCK_STAT_MAX];
+static pthread_mutex_t lock_stat_lock = PTHREAD_MUTEX_INITIALIZER;
+
 void mpp_spinlock_init(spinlock_t *lock)
 {
     MPP_SYNC_CLR(&lock->lock);
@@ -81,3 +89,53 @@ bool mpp_spinlock_trylock(spinlock_t *lock)
 
     return ret;
 }
+
+void mpp_spinlock_lock_stat(spinlock_t *lock, MppLockStat *stat)
+{
+    if (!stat) {
+        mpp_spinlock_lock(lock);
+        return;
+    }
+
+    if (!MPP_BOOL_CAS(&lock->lock, LOCK_IDLE, LOCK_BUSY)) {
+        RK_S64 time = mpp_time();
+
+        mpp_spinlock_lock(lock);
+        stat->contend_cnt++;
+        stat->wait_time += mpp_time() - time;
+    }
+
+    stat->lock_cnt++;
+}
+
+MppLockStat *mpp_lock_stat_get(const char *name)
+{
+    MppLockStat *stat = NULL;
+    RK_U32 i;
+
+    if (!name) {
+        mpp_err_f("invalid input name NULL\n");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&lock_stat_lock);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(lock_stats); i++) {
+        MppLockStat *p = &lock_stats[i];
+
+        if (!p->name)
+            p->name = name;
+
+        if (!strcmp(p->name, name)) {
+            stat = p;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&lock_stat_lock);
+
+    if (!stat)
+        mpp_err_f("no free lock stat for %s\n", name);
+
+    return stat;
+}
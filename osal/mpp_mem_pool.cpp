@@ -22,22 +22,33 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_lock.h"
 #include "mpp_debug.h"
+#include "mpp_thread.h"
 
 #include "mpp_mem_pool.h"
 
 #define MPP_MEM_POOL_DBG_FLOW           (0x00000001)
+#define MPP_MEM_POOL_DBG_STAT           (0x00000002)
 
 #define mem_pool_dbg(flag, fmt, ...)    _mpp_dbg(mpp_mem_pool_debug, flag, fmt, ## __VA_ARGS__)
 #define mem_pool_dbg_f(flag, fmt, ...)  _mpp_dbg_f(mpp_mem_pool_debug, flag, fmt, ## __VA_ARGS__)
 
 #define mem_pool_dbg_flow(fmt, ...)     mem_pool_dbg(MPP_MEM_POOL_DBG_FLOW, fmt, ## __VA_ARGS__)
+#define mem_pool_dbg_stat(fmt, ...)     mem_pool_dbg(MPP_MEM_POOL_DBG_STAT, fmt, ## __VA_ARGS__)
+
+/* pool slot count in each thread cache, pool is mapped to slot by serial */
+#define MEM_POOL_CACHE_SLOTS            16
+/* max free node count kept in one thread cache slot */
+#define MEM_POOL_CACHE_MAX              32
 
 RK_U32 mpp_mem_pool_debug = 0;
 
 typedef struct MppMemPoolNode_t {
     void                *check;
     struct list_head    list;
+    /* link in thread cache or pool free stack */
+    struct MppMemPoolNode_t *next;
     void                *ptr;
     size_t              size;
 } MppMemPoolNode;
@@ -45,18 +56,106 @@ typedef struct MppMemPoolNode_t {
 typedef struct MppMemPoolImpl_t {
     void                *check;
     size_t              size;
+    RK_U32              serial;
     pthread_mutex_t     lock;
     struct list_head    service_link;
 
-    struct list_head    used;
-    struct list_head    unused;
-    RK_S32              used_count;
-    RK_S32              unused_count;
+    /* all nodes created by this pool, only changed on malloc */
+    struct list_head    nodes;
+    RK_S32              node_count;
+
+    /* lock-free free node stack, push one by CAS and pop all by swap */
+    MppMemPoolNode      *free_head;
+
+    /* statistic flushed from thread cache */
+    RK_U64              get_count;
+    RK_U64              put_count;
+    RK_U64              hit_count;
+    RK_U64              refill_count;
 
     /* extra flag for C++ static destruction order error */
     RK_S32              finalized;
 } MppMemPoolImpl;
 
+typedef struct MppMemPoolSlot_t {
+    MppMemPoolImpl      *pool;
+    MppMemPoolNode      *head;
+    RK_S32              count;
+
+    RK_U64              get_count;
+    RK_U64              put_count;
+    RK_U64              hit_count;
+    RK_U64              refill_count;
+} MppMemPoolSlot;
+
+/*
+ * Per-thread free node cache. The lock is only contended when a pool is
+ * deinited or statistic is collected by another thread.
+ */
+typedef struct MppMemPoolCache_t {
+    struct list_head    link;
+    RK_U32              lock;
+    MppMemPoolSlot      slots[MEM_POOL_CACHE_SLOTS];
+} MppMemPoolCache;
+
+static void cache_lock(MppMemPoolCache *cache)
+{
+    while (MPP_SYNC_TEST_SET(&cache->lock, 1))
+        ;
+}
+
+static void cache_unlock(MppMemPoolCache *cache)
+{
+    MPP_SYNC_CLR(&cache->lock);
+}
+
+static void pool_push_nodes(MppMemPoolImpl *impl, MppMemPoolNode *head,
+                            MppMemPoolNode *tail)
+{
+    MppMemPoolNode *old;
+
+    do {
+        old = impl->free_head;
+        tail->next = old;
+    } while (!MPP_BOOL_CAS(&impl->free_head, old, head));
+}
+
+static MppMemPoolNode *pool_pop_all(MppMemPoolImpl *impl)
+{
+    MppMemPoolNode *head;
+
+    do {
+        head = impl->free_head;
+    } while (head && !MPP_BOOL_CAS(&impl->free_head, head, NULL));
+
+    return head;
+}
+
+/* return cached nodes and statistic to the pool */
+static void slot_flush(MppMemPoolSlot *slot)
+{
+    MppMemPoolImpl *impl = slot->pool;
+
+    if (NULL == impl)
+        return;
+
+    if (slot->head) {
+        MppMemPoolNode *tail = slot->head;
+
+        while (tail->next)
+            tail = tail->next;
+
+        pool_push_nodes(impl, slot->head, tail);
+    }
+
+    MPP_FETCH_ADD(&impl->get_count, slot->get_count);
+    MPP_FETCH_ADD(&impl->put_count, slot->put_count);
+    MPP_FETCH_ADD(&impl->hit_count, slot->hit_count);
+    MPP_FETCH_ADD(&impl->refill_count, slot->refill_count);
+
+    memset(slot, 0, sizeof(*slot));
+}
+
 class MppMemPoolService
 {
 public:
@@ -66,22 +165,59 @@ public:
         return &pool_service;
     }
     static Mutex *get_lock() {
-        static Mutex lock;
+        static Mutex lock(mpp_lock_stat_get(MODULE_TAG));
         return &lock;
     }
 
     MppMemPoolImpl *get_pool(size_t size);
     void put_pool(MppMemPoolImpl *impl);
 
+    void add_cache(MppMemPoolCache *cache);
+    static void put_cache(void *cache);
+    void get_stat(MppMemPoolImpl *impl, MppMemPoolStat *stat);
+
 private:
     MppMemPoolService();
     ~MppMemPoolService();
+
     struct list_head    mLink;
+    struct list_head    mCaches;
+    RK_U32              mSerial;
 };
 
+static pthread_key_t mem_pool_key;
+static pthread_once_t mem_pool_once = PTHREAD_ONCE_INIT;
+
+static void mem_pool_key_init(void)
+{
+    pthread_key_create(&mem_pool_key, MppMemPoolService::put_cache);
+}
+
+static MppMemPoolCache *get_thread_cache(void)
+{
+    MppMemPoolCache *cache;
+
+    pthread_once(&mem_pool_once, mem_pool_key_init);
+
+    cache = (MppMemPoolCache *)pthread_getspecific(mem_pool_key);
+    if (cache)
+        return cache;
+
+    cache = mpp_calloc(MppMemPoolCache, 1);
+    if (NULL == cache)
+        return NULL;
+
+    MppMemPoolService::getInstance()->add_cache(cache);
+    pthread_setspecific(mem_pool_key, cache);
+
+    return cache;
+}
+
 MppMemPoolService::MppMemPoolService()
+    : mSerial(0)
 {
     INIT_LIST_HEAD(&mLink);
+    INIT_LIST_HEAD(&mCaches);
 
     mpp_env_get_u32("mpp_mem_pool_debug", &mpp_mem_pool_debug, 0);
 }
@@ -97,6 +233,62 @@ MppMemPoolService::~MppMemPoolService()
     }
 }
 
+void MppMemPoolService::add_cache(MppMemPoolCache *cache)
+{
+    AutoMutex auto_lock(get_lock());
+
+    INIT_LIST_HEAD(&cache->link);
+    list_add_tail(&cache->link, &mCaches);
+}
+
+/* thread exit destructor */
+void MppMemPoolService::put_cache(void *ctx)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)ctx;
+    RK_S32 i;
+
+    AutoMutex auto_lock(get_lock());
+
+    cache_lock(cache);
+    for (i = 0; i < MEM_POOL_CACHE_SLOTS; i++)
+        slot_flush(&cache->slots[i]);
+    list_del_init(&cache->link);
+    cache_unlock(cache);
+
+    mpp_free(cache);
+}
+
+void MppMemPoolService::get_stat(MppMemPoolImpl *impl, MppMemPoolStat *stat)
+{
+    MppMemPoolCache *cache;
+    RK_S32 idx = impl->serial % MEM_POOL_CACHE_SLOTS;
+
+    memset(stat, 0, sizeof(*stat));
+
+    AutoMutex auto_lock(get_lock());
+
+    list_for_each_entry(cache, &mCaches, MppMemPoolCache, link) {
+        MppMemPoolSlot *slot = &cache->slots[idx];
+
+        cache_lock(cache);
+        if (slot->pool == impl) {
+            stat->get_count += slot->get_count;
+            stat->put_count += slot->put_count;
+            stat->hit_count += slot->hit_count;
+            stat->refill_count += slot->refill_count;
+            stat->cached_count += slot->count;
+        }
+        cache_unlock(cache);
+    }
+
+    stat->size = impl->size;
+    stat->get_count += impl->get_count;
+    stat->put_count += impl->put_count;
+    stat->hit_count += impl->hit_count;
+    stat->refill_count += impl->refill_count;
+    stat->node_count = impl->node_count;
+}
+
 MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 {
     MppMemPoolImpl *pool = mpp_malloc(MppMemPoolImpl, 1);
@@ -111,14 +303,18 @@ MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 
     pool->check = pool;
     pool->size = size;
-    pool->used_count = 0;
-    pool->unused_count = 0;
+    pool->node_count = 0;
+    pool->free_head = NULL;
+    pool->get_count = 0;
+    pool->put_count = 0;
+    pool->hit_count = 0;
+    pool->refill_count = 0;
     pool->finalized = 0;
 
-    INIT_LIST_HEAD(&pool->used);
-    INIT_LIST_HEAD(&pool->unused);
+    INIT_LIST_HEAD(&pool->nodes);
     INIT_LIST_HEAD(&pool->service_link);
     AutoMutex auto_lock(get_lock());
+    pool->serial = mSerial++;
     list_add_tail(&pool->service_link, &mLink);
 
     return pool;
@@ -127,6 +323,9 @@ MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
 void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
 {
     MppMemPoolNode *node, *m;
+    MppMemPoolCache *cache;
+    RK_S32 idx = impl->serial % MEM_POOL_CACHE_SLOTS;
+    RK_S32 used_count = 0;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem impl %p check %p\n", impl, impl->check);
@@ -136,36 +335,49 @@ void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
     if (impl->finalized)
         return;
 
-    pthread_mutex_lock(&impl->lock);
+    if (mpp_mem_pool_debug & MPP_MEM_POOL_DBG_STAT) {
+        MppMemPoolStat stat;
 
-    if (!list_empty(&impl->unused)) {
-        list_for_each_entry_safe(node, m, &impl->unused, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->unused_count--;
-        }
+        get_stat(impl, &stat);
+        mpp_log_f("pool size %d get %lld put %lld hit %lld refill %lld node %d\n",
+                  stat.size, stat.get_count, stat.put_count, stat.hit_count,
+                  stat.refill_count, stat.node_count);
     }
 
-    if (!list_empty(&impl->used)) {
-        mpp_err_f("found %d used buffer size %d\n",
-                  impl->used_count, impl->size);
+    {
+        AutoMutex auto_lock(get_lock());
+
+        /* drop the nodes in thread cache, they are released below */
+        list_for_each_entry(cache, &mCaches, MppMemPoolCache, link) {
+            MppMemPoolSlot *slot = &cache->slots[idx];
 
-        list_for_each_entry_safe(node, m, &impl->used, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->used_count--;
+            cache_lock(cache);
+            if (slot->pool == impl)
+                memset(slot, 0, sizeof(*slot));
+            cache_unlock(cache);
         }
-    }
 
-    if (impl->used_count || impl->unused_count)
-        mpp_err_f("pool size %d found leaked buffer used:unused [%d:%d]\n",
-                  impl->size, impl->used_count, impl->unused_count);
+        list_del_init(&impl->service_link);
+    }
 
-    pthread_mutex_unlock(&impl->lock);
+    pthread_mutex_lock(&impl->lock);
 
-    {
-        AutoMutex auto_lock(get_lock());
-        list_del_init(&impl->service_link);
+    list_for_each_entry_safe(node, m, &impl->nodes, MppMemPoolNode, list) {
+        if (node->check)
+            used_count++;
+        MPP_FREE(node);
+        impl->node_count--;
     }
 
+    if (used_count)
+        mpp_err_f("found %d used buffer size %d\n", used_count, impl->size);
+
+    if (impl->node_count)
+        mpp_err_f("pool size %d found leaked buffer %d\n",
+                  impl->size, impl->node_count);
+
+    pthread_mutex_unlock(&impl->lock);
+
     impl->finalized = 1;
     mpp_free(impl);
 }
@@ -186,48 +398,98 @@ void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool)
     MppMemPoolService::getInstance()->put_pool(impl);
 }
 
+/* get the slot for the pool and flush the slot used by other pool */
+static MppMemPoolSlot *cache_get_slot(MppMemPoolCache *cache, MppMemPoolImpl *impl)
+{
+    MppMemPoolSlot *slot = &cache->slots[impl->serial % MEM_POOL_CACHE_SLOTS];
+
+    if (slot->pool != impl) {
+        slot_flush(slot);
+        slot->pool = impl;
+    }
+
+    return slot;
+}
+
 void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
 {
     MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache = get_thread_cache();
     MppMemPoolNode *node = NULL;
     void* ptr = NULL;
 
-    pthread_mutex_lock(&impl->lock);
+    mem_pool_dbg_flow("pool %d get nodes %d from %s", impl->size,
+                      impl->node_count, caller);
 
-    mem_pool_dbg_flow("pool %d get used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
+    if (cache) {
+        MppMemPoolSlot *slot;
 
-    if (!list_empty(&impl->unused)) {
-        node = list_first_entry(&impl->unused, MppMemPoolNode, list);
+        cache_lock(cache);
+        slot = cache_get_slot(cache, impl);
+        slot->get_count++;
+
+        node = slot->head;
         if (node) {
-            list_del_init(&node->list);
-            list_add_tail(&node->list, &impl->used);
-            impl->unused_count--;
-            impl->used_count++;
-            ptr = node->ptr;
-            node->check = node;
-            goto DONE;
+            slot->hit_count++;
+        } else {
+            /*
+             * take at most one cache of free nodes from the pool and return
+             * the rest so threads which only get do not drain the pool
+             */
+            node = pool_pop_all(impl);
+            if (node) {
+                MppMemPoolNode *tail = node;
+
+                slot->refill_count++;
+                slot->count = 1;
+                while (tail->next && slot->count < MEM_POOL_CACHE_MAX) {
+                    tail = tail->next;
+                    slot->count++;
+                }
+
+                if (tail->next) {
+                    MppMemPoolNode *rest = tail->next;
+                    MppMemPoolNode *rest_tail = rest;
+
+                    while (rest_tail->next)
+                        rest_tail = rest_tail->next;
+
+                    tail->next = NULL;
+                    pool_push_nodes(impl, rest, rest_tail);
+                }
+            }
+        }
+
+        if (node) {
+            slot->head = node->next;
+            slot->count--;
         }
+        cache_unlock(cache);
+
+        if (node)
+            goto DONE;
     }
 
     node = mpp_malloc_size(MppMemPoolNode, sizeof(MppMemPoolNode) + impl->size);
     if (NULL == node) {
         mpp_err_f("failed to create node from size %d pool\n", impl->size);
-        goto DONE;
+        return NULL;
     }
 
-    node->check = node;
     node->ptr = (void *)(node + 1);
     node->size = impl->size;
     INIT_LIST_HEAD(&node->list);
-    list_add_tail(&node->list, &impl->used);
-    impl->used_count++;
-    ptr = node->ptr;
 
-DONE:
+    pthread_mutex_lock(&impl->lock);
+    list_add_tail(&node->list, &impl->nodes);
+    impl->node_count++;
     pthread_mutex_unlock(&impl->lock);
-    if (node)
-        memset(node->ptr, 0 , node->size);
+
+DONE:
+    node->check = node;
+    node->next = NULL;
+    ptr = node->ptr;
+    memset(node->ptr, 0 , node->size);
     return ptr;
 }
 
@@ -235,6 +497,7 @@ void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
 {
     MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
     MppMemPoolNode *node = (MppMemPoolNode *)((RK_U8 *)p - sizeof(MppMemPoolNode));
+    MppMemPoolCache *cache;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem pool %p check %p\n", impl, impl->check);
@@ -247,16 +510,40 @@ void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
         return ;
     }
 
-    pthread_mutex_lock(&impl->lock);
-
-    mem_pool_dbg_flow("pool %d put used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
+    mem_pool_dbg_flow("pool %d put nodes %d from %s", impl->size,
+                      impl->node_count, caller);
 
-    list_del_init(&node->list);
-    list_add(&node->list, &impl->unused);
-    impl->used_count--;
-    impl->unused_count++;
     node->check = NULL;
 
-    pthread_mutex_unlock(&impl->lock);
+    cache = get_thread_cache();
+    if (cache) {
+        MppMemPoolSlot *slot;
+
+        cache_lock(cache);
+        slot = cache_get_slot(cache, impl);
+        slot->put_count++;
+        if (slot->count < MEM_POOL_CACHE_MAX) {
+            node->next = slot->head;
+            slot->head = node;
+            slot->count++;
+            node = NULL;
+        }
+        cache_unlock(cache);
+    }
+
+    /* thread cache is full, return node to the pool */
+    if (node)
+        pool_push_nodes(impl, node, node);
+}
+
+MPP_RET mpp_mem_pool_get_stat(MppMemPool pool, MppMemPoolStat *stat)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl || NULL == stat || impl != impl->check)
+        return MPP_ERR_NULL_PTR;
+
+    MppMemPoolService::getInstance()->get_stat(impl, stat);
+
+    return MPP_OK;
 }
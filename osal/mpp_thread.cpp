@@ -21,6 +21,7 @@
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_lock.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_thread.h"
 
@@ -30,6 +31,19 @@ static RK_U32 thread_debug = 0;
 
 #define thread_dbg(flag, fmt, ...)  _mpp_dbg(thread_debug, flag, fmt, ## __VA_ARGS__)
 
+void Mutex::lock_stat()
+{
+    if (pthread_mutex_trylock(&mMutex)) {
+        RK_S64 time = mpp_time();
+
+        pthread_mutex_lock(&mMutex);
+        mStat->contend_cnt++;
+        mStat->wait_time += mpp_time() - time;
+    }
+
+    mStat->lock_cnt++;
+}
+
 MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
     : mFunction(func),
       mContext(ctx)
@@ -22,6 +22,7 @@
 #include <sys/epoll.h>
 
 #include "mpp_mem.h"
+#include "mpp_lock.h"
 #include "mpp_time.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
@@ -580,3 +581,203 @@ RK_S64 mpp_stopwatch_elapsed_time(MppStopwatch stopwatch)
     RK_S64 elapsed_time = curr_time - base_time;
     return elapsed_time;
 }
+
+/*
+ * Bin layout: time below 16 us has one bin per us. Above that each power of
+ * two range [2^e, 2^(e+1)) is split into 16 bins by the four bits below the
+ * leading one. Time is clipped to 31 bits which is about 35 minutes.
+ */
+#define TIME_HIST_SUB_BITS      4
+#define TIME_HIST_SUB_CNT       (1 << TIME_HIST_SUB_BITS)
+#define TIME_HIST_MAX_BITS      31
+#define TIME_HIST_BIN_CNT       ((TIME_HIST_MAX_BITS - TIME_HIST_SUB_BITS + 1) * TIME_HIST_SUB_CNT)
+
+typedef struct MppTimeHistImpl_t {
+    const char          *check;
+    char                name[16];
+
+    spinlock_t          lock;
+    RK_S64              count;
+    RK_S64              sum;
+    RK_S64              max;
+    RK_U32              bins[TIME_HIST_BIN_CNT];
+} MppTimeHistImpl;
+
+static const char *time_hist_name = "mpp_time_hist";
+
+MPP_RET check_is_mpp_time_hist(void *hist)
+{
+    if (hist && ((MppTimeHistImpl*)hist)->check == time_hist_name)
+        return MPP_OK;
+
+    mpp_err_f("pointer %p failed on check\n", hist);
+    mpp_abort();
+    return MPP_NOK;
+}
+
+static RK_S32 time_hist_bin(RK_S64 time)
+{
+    RK_U32 val;
+    RK_S32 bits;
+
+    if (time < TIME_HIST_SUB_CNT)
+        return (time < 0) ? 0 : (RK_S32)time;
+
+    if (time >= (1LL << TIME_HIST_MAX_BITS))
+        return TIME_HIST_BIN_CNT - 1;
+
+    val = (RK_U32)time;
+    bits = 31 - __builtin_clz(val);
+
+    return (bits - TIME_HIST_SUB_BITS + 1) * TIME_HIST_SUB_CNT +
+           ((val >> (bits - TIME_HIST_SUB_BITS)) & (TIME_HIST_SUB_CNT - 1));
+}
+
+/* return the middle of the bin time range */
+static RK_S64 time_hist_bin_time(RK_S32 bin)
+{
+    RK_S32 shift;
+
+    if (bin < TIME_HIST_SUB_CNT)
+        return bin;
+
+    shift = bin / TIME_HIST_SUB_CNT - 1;
+
+    return ((RK_S64)(TIME_HIST_SUB_CNT + bin % TIME_HIST_SUB_CNT) << shift) +
+           ((1LL << shift) >> 1);
+}
+
+MppTimeHist mpp_time_hist_get(const char *name)
+{
+    MppTimeHistImpl *impl = mpp_calloc(MppTimeHistImpl, 1);
+
+    if (impl) {
+        impl->check = time_hist_name;
+        snprintf(impl->name, sizeof(impl->name) - 1, "%s", name);
+        mpp_spinlock_init(&impl->lock);
+    } else
+        mpp_err_f("malloc failed\n");
+
+    return impl;
+}
+
+void mpp_time_hist_put(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return ;
+    }
+
+    mpp_free(hist);
+}
+
+void mpp_time_hist_add(MppTimeHist hist, RK_S64 time)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return ;
+    }
+
+    MppTimeHistImpl *impl = (MppTimeHistImpl *)hist;
+    RK_S32 bin = time_hist_bin(time);
+
+    mpp_spinlock_lock(&impl->lock);
+    impl->bins[bin]++;
+    impl->count++;
+    impl->sum += time;
+    if (time > impl->max)
+        impl->max = time;
+    mpp_spinlock_unlock(&impl->lock);
+}
+
+void mpp_time_hist_reset(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return ;
+    }
+
+    MppTimeHistImpl *impl = (MppTimeHistImpl *)hist;
+
+    mpp_spinlock_lock(&impl->lock);
+    impl->count = 0;
+    impl->sum = 0;
+    impl->max = 0;
+    memset(impl->bins, 0, sizeof(impl->bins));
+    mpp_spinlock_unlock(&impl->lock);
+}
+
+RK_S64 mpp_time_hist_get_count(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return 0;
+    }
+
+    return ((MppTimeHistImpl *)hist)->count;
+}
+
+RK_S64 mpp_time_hist_get_sum(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return 0;
+    }
+
+    return ((MppTimeHistImpl *)hist)->sum;
+}
+
+RK_S64 mpp_time_hist_get_max(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return 0;
+    }
+
+    return ((MppTimeHistImpl *)hist)->max;
+}
+
+RK_S64 mpp_time_hist_percentile(MppTimeHist hist, RK_U32 permille)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return 0;
+    }
+
+    MppTimeHistImpl *impl = (MppTimeHistImpl *)hist;
+    RK_S64 time = 0;
+    RK_S64 target;
+    RK_S64 acc = 0;
+    RK_S32 i;
+
+    mpp_spinlock_lock(&impl->lock);
+
+    /* rank of the permille sample, round up */
+    target = (impl->count * MPP_MIN(permille, 1000) + 999) / 1000;
+    if (target < 1)
+        target = 1;
+
+    if (impl->count) {
+        for (i = 0; i < TIME_HIST_BIN_CNT; i++) {
+            acc += impl->bins[i];
+            if (acc >= target)
+                break;
+        }
+
+        time = MPP_MIN(time_hist_bin_time(i), impl->max);
+    }
+
+    mpp_spinlock_unlock(&impl->lock);
+
+    return time;
+}
+
+const char *mpp_time_hist_get_name(MppTimeHist hist)
+{
+    if (NULL == hist || check_is_mpp_time_hist(hist)) {
+        mpp_err_f("invalid time hist %p\n", hist);
+        return NULL;
+    }
+
+    return ((MppTimeHistImpl *)hist)->name;
+}
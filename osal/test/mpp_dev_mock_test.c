@@ -0,0 +1,217 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_mock_test"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_dev_mock_api.h"
+
+#define MOCK_LATENCY        1000
+#define MOCK_THREADS        2
+#define MOCK_FRAMES         200
+#define MOCK_REG_COUNT      256
+#define MOCK_STATUS_OFFSET  (4 * 4)
+#define MOCK_QUEUE_DEPTH    4
+
+typedef struct MockTestCtx_t {
+    RK_S32      id;
+    RK_S32      frames;
+    RK_S32      ret;
+    RK_S64      time_send;
+    RK_S64      time_poll;
+} MockTestCtx;
+
+static void *mock_dev_thread(void *arg)
+{
+    MockTestCtx *ctx = (MockTestCtx *)arg;
+    RK_U32 regs[MOCK_REG_COUNT];
+    RK_U32 status[MOCK_REG_COUNT];
+    MppDev dev = NULL;
+    RK_S32 i;
+
+    ctx->ret = mpp_dev_init(&dev, VPU_CLIENT_VDPU2);
+    if (ctx->ret) {
+        mpp_err("thread %d mpp_dev_init failed ret %d\n", ctx->id, ctx->ret);
+        return NULL;
+    }
+
+    for (i = 0; i < ctx->frames; i++) {
+        MppDevRegWrCfg wr_cfg;
+        MppDevRegRdCfg rd_cfg;
+        RK_S64 start;
+        RK_S32 j;
+
+        for (j = 0; j < MOCK_REG_COUNT; j++)
+            regs[j] = (ctx->id << 24) | (i << 8) | j;
+
+        start = mpp_time();
+
+        wr_cfg.reg = regs;
+        wr_cfg.size = sizeof(regs);
+        wr_cfg.offset = 0;
+        ctx->ret |= mpp_dev_ioctl(dev, MPP_DEV_REG_WR, &wr_cfg);
+
+        rd_cfg.reg = status;
+        rd_cfg.size = sizeof(status) - MOCK_STATUS_OFFSET;
+        rd_cfg.offset = MOCK_STATUS_OFFSET;
+        ctx->ret |= mpp_dev_ioctl(dev, MPP_DEV_REG_RD, &rd_cfg);
+
+        ctx->ret |= mpp_dev_ioctl(dev, MPP_DEV_CMD_SEND, NULL);
+        ctx->time_send += mpp_time() - start;
+
+        start = mpp_time();
+        ctx->ret |= mpp_dev_ioctl(dev, MPP_DEV_CMD_POLL, NULL);
+        ctx->time_poll += mpp_time() - start;
+
+        if (ctx->ret)
+            break;
+
+        /* register read back from the loopback register file */
+        for (j = 0; j < MOCK_REG_COUNT - MOCK_STATUS_OFFSET / 4; j++) {
+            if (status[j] != regs[j + MOCK_STATUS_OFFSET / 4]) {
+                mpp_err("thread %d frame %d reg %d mismatch %08x vs %08x\n",
+                        ctx->id, i, j, status[j], regs[j + MOCK_STATUS_OFFSET / 4]);
+                ctx->ret = MPP_NOK;
+                break;
+            }
+        }
+
+        if (ctx->ret)
+            break;
+    }
+
+    mpp_dev_deinit(dev);
+
+    return NULL;
+}
+
+/* each queued task reads back the registers written by itself */
+static MPP_RET mock_dev_queue_check(void)
+{
+    RK_U32 status[MOCK_QUEUE_DEPTH];
+    MppDev dev = NULL;
+    MPP_RET ret;
+    RK_S32 i;
+
+    ret = mpp_dev_init(&dev, VPU_CLIENT_VDPU2);
+    if (ret) {
+        mpp_err("mpp_dev_init failed ret %d\n", ret);
+        return ret;
+    }
+
+    for (i = 0; i < MOCK_QUEUE_DEPTH; i++) {
+        RK_U32 reg = 0x5a000000 | i;
+        MppDevRegWrCfg wr_cfg;
+        MppDevRegRdCfg rd_cfg;
+
+        wr_cfg.reg = &reg;
+        wr_cfg.size = sizeof(reg);
+        wr_cfg.offset = 0;
+        ret |= mpp_dev_ioctl(dev, MPP_DEV_REG_WR, &wr_cfg);
+
+        rd_cfg.reg = &status[i];
+        rd_cfg.size = sizeof(status[i]);
+        rd_cfg.offset = 0;
+        ret |= mpp_dev_ioctl(dev, MPP_DEV_REG_RD, &rd_cfg);
+
+        ret |= mpp_dev_ioctl(dev, MPP_DEV_CMD_SEND, NULL);
+    }
+
+    for (i = 0; i < MOCK_QUEUE_DEPTH; i++)
+        ret |= mpp_dev_ioctl(dev, MPP_DEV_CMD_POLL, NULL);
+
+    for (i = 0; !ret && i < MOCK_QUEUE_DEPTH; i++) {
+        if (status[i] != (0x5a000000U | i)) {
+            mpp_err("queued task %d read back %08x\n", i, status[i]);
+            ret = MPP_NOK;
+        }
+    }
+
+    mpp_dev_deinit(dev);
+
+    return ret;
+}
+
+int main()
+{
+    MockTestCtx ctxs[MOCK_THREADS];
+    pthread_t thds[MOCK_THREADS];
+    MppDevMockStat stat;
+    RK_S64 time_start;
+    RK_S64 time_total;
+    RK_S64 time_send = 0;
+    RK_S64 time_poll = 0;
+    RK_S32 ret = MPP_OK;
+    RK_S32 i;
+
+    mpp_log("mpp_dev_mock_test start\n");
+
+    mpp_env_set_u32("mpp_dev_mock", 1);
+    mpp_env_set_u32("mpp_dev_mock_latency", MOCK_LATENCY);
+
+    time_start = mpp_time();
+    for (i = 0; i < MOCK_THREADS; i++) {
+        MockTestCtx *ctx = &ctxs[i];
+
+        memset(ctx, 0, sizeof(*ctx));
+        ctx->id = i;
+        ctx->frames = MOCK_FRAMES;
+        pthread_create(&thds[i], NULL, mock_dev_thread, ctx);
+    }
+
+    for (i = 0; i < MOCK_THREADS; i++) {
+        pthread_join(thds[i], NULL);
+        ret |= ctxs[i].ret;
+        time_send += ctxs[i].time_send;
+        time_poll += ctxs[i].time_poll;
+    }
+    time_total = mpp_time() - time_start;
+
+    mpp_dev_mock_get_stat(&stat);
+
+    mpp_log("send %lld poll %lld reg wr %lld:%lld rd %lld:%lld\n",
+            stat.send_cnt, stat.poll_cnt, stat.reg_wr_cnt, stat.reg_wr_size,
+            stat.reg_rd_cnt, stat.reg_rd_size);
+    mpp_log("total %lld us hw wait %lld us per task send %.2f us poll %.2f us\n",
+            time_total, stat.wait_time,
+            (double)time_send / (MOCK_THREADS * MOCK_FRAMES),
+            (double)time_poll / (MOCK_THREADS * MOCK_FRAMES));
+
+    if (stat.send_cnt != MOCK_THREADS * MOCK_FRAMES ||
+        stat.poll_cnt != MOCK_THREADS * MOCK_FRAMES) {
+        mpp_err("task count mismatch\n");
+        ret = MPP_NOK;
+    }
+
+    /* all task share one simulated hardware core */
+    if (time_total < MOCK_THREADS * MOCK_FRAMES * MOCK_LATENCY) {
+        mpp_err("total time %lld is less than serialized hardware time %d\n",
+                time_total, MOCK_THREADS * MOCK_FRAMES * MOCK_LATENCY);
+        ret = MPP_NOK;
+    }
+
+    ret |= mock_dev_queue_check();
+
+    mpp_log("mpp_dev_mock_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -17,13 +17,267 @@
 #define MODULE_TAG "mpp_mem_pool_test"
 
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "mpp_log.h"
+#include "mpp_time.h"
 #include "mpp_mem_pool.h"
 
 #define MPP_MEM_POOL_TEST_SIZE      1024
 #define MPP_MEM_POOL_TEST_COUNT     20
 
+/* multi-thread stress test config */
+#define MPP_MEM_POOL_MT_SIZE        256
+#define MPP_MEM_POOL_MT_BATCH       8
+/* large batch to overflow the thread cache and go through shared free list */
+#define MPP_MEM_POOL_MT_BATCH_MAX   48
+#define MPP_MEM_POOL_MT_LOOP        200000
+#define MPP_MEM_POOL_MT_MAX_THREAD  16
+
+/* cross thread test config, nodes are got on some threads and put on another */
+#define MPP_MEM_POOL_XT_LOOP        400000
+#define MPP_MEM_POOL_XT_RING        64
+#define MPP_MEM_POOL_XT_MAX_GETTER  4
+/* same as MEM_POOL_CACHE_MAX in mpp_mem_pool.cpp */
+#define MPP_MEM_POOL_XT_CACHE_MAX   32
+
+typedef struct MemPoolMtCtx_t {
+    MppMemPool  pool;
+    RK_U32      id;
+    RK_U64      count;
+    RK_S32      ret;
+} MemPoolMtCtx;
+
+static void *mem_pool_mt_thread(void *arg)
+{
+    MemPoolMtCtx *ctx = (MemPoolMtCtx *)arg;
+    RK_U32 *p[MPP_MEM_POOL_MT_BATCH_MAX];
+    RK_U32 i, j;
+
+    for (i = 0; i < MPP_MEM_POOL_MT_LOOP; i++) {
+        RK_U32 batch = (i % 16) ? MPP_MEM_POOL_MT_BATCH : MPP_MEM_POOL_MT_BATCH_MAX;
+
+        ctx->count += batch;
+        for (j = 0; j < batch; j++) {
+            p[j] = (RK_U32 *)mpp_mem_pool_get(ctx->pool);
+            if (NULL == p[j] || p[j][0]) {
+                mpp_err("thread %d get invalid ptr %p\n", ctx->id, p[j]);
+                ctx->ret = MPP_NOK;
+                return NULL;
+            }
+            p[j][0] = ctx->id + 1;
+        }
+
+        /* check no node is handed to two threads at the same time */
+        for (j = 0; j < batch; j++) {
+            if (p[j][0] != ctx->id + 1) {
+                mpp_err("thread %d found node %p overwritten\n", ctx->id, p[j]);
+                ctx->ret = MPP_NOK;
+            }
+            mpp_mem_pool_put(ctx->pool, p[j]);
+        }
+    }
+
+    return NULL;
+}
+
+static RK_S32 mem_pool_mt_test(RK_U32 thread_count)
+{
+    MemPoolMtCtx ctx[MPP_MEM_POOL_MT_MAX_THREAD];
+    pthread_t thds[MPP_MEM_POOL_MT_MAX_THREAD];
+    MppMemPool pool = mpp_mem_pool_init(MPP_MEM_POOL_MT_SIZE);
+    MppMemPoolStat stat;
+    RK_S32 ret = MPP_OK;
+    RK_U64 count = 0;
+    RK_S64 time;
+    RK_U32 i;
+
+    if (NULL == pool)
+        return MPP_NOK;
+
+    time = mpp_time();
+    for (i = 0; i < thread_count; i++) {
+        ctx[i].pool = pool;
+        ctx[i].id = i;
+        ctx[i].count = 0;
+        ctx[i].ret = MPP_OK;
+        pthread_create(&thds[i], NULL, mem_pool_mt_thread, &ctx[i]);
+    }
+
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(thds[i], NULL);
+        ret |= ctx[i].ret;
+        count += ctx[i].count;
+    }
+    time = mpp_time() - time;
+
+    mpp_mem_pool_get_stat(pool, &stat);
+
+    mpp_log("mt test %2d threads %8.2f M get+put/s hit %5.2f%% node %d\n",
+            thread_count,
+            (double)count / MPP_MAX(time, 1),
+            stat.get_count ? stat.hit_count * 100.0 / stat.get_count : 0,
+            stat.node_count);
+
+    if (stat.get_count != stat.put_count ||
+        stat.get_count != count) {
+        mpp_err("mt test get %lld put %lld mismatch\n", stat.get_count, stat.put_count);
+        ret = MPP_NOK;
+    }
+
+    mpp_mem_pool_deinit(pool);
+
+    return ret;
+}
+
+typedef struct MemPoolXtRing_t {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    void            *nodes[MPP_MEM_POOL_XT_RING];
+    RK_U32          rd;
+    RK_U32          wr;
+    RK_U32          getter_done;
+} MemPoolXtRing;
+
+typedef struct MemPoolXtCtx_t {
+    MppMemPool      pool;
+    MemPoolXtRing   *ring;
+    RK_U32          loop;
+    RK_S32          ret;
+} MemPoolXtCtx;
+
+static void *mem_pool_xt_getter(void *arg)
+{
+    MemPoolXtCtx *ctx = (MemPoolXtCtx *)arg;
+    MemPoolXtRing *ring = ctx->ring;
+    RK_U32 i;
+
+    for (i = 0; i < ctx->loop; i++) {
+        void *p = mpp_mem_pool_get(ctx->pool);
+
+        if (NULL == p) {
+            ctx->ret = MPP_NOK;
+            break;
+        }
+
+        pthread_mutex_lock(&ring->lock);
+        while (ring->wr - ring->rd >= MPP_MEM_POOL_XT_RING)
+            pthread_cond_wait(&ring->cond, &ring->lock);
+        ring->nodes[ring->wr++ % MPP_MEM_POOL_XT_RING] = p;
+        pthread_cond_broadcast(&ring->cond);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    pthread_mutex_lock(&ring->lock);
+    ring->getter_done++;
+    pthread_cond_broadcast(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+
+    return NULL;
+}
+
+static void *mem_pool_xt_putter(void *arg)
+{
+    MemPoolXtCtx *ctx = (MemPoolXtCtx *)arg;
+    MemPoolXtRing *ring = ctx->ring;
+
+    while (1) {
+        void *p = NULL;
+
+        pthread_mutex_lock(&ring->lock);
+        while (ring->rd == ring->wr && ring->getter_done < ctx->loop)
+            pthread_cond_wait(&ring->cond, &ring->lock);
+        if (ring->rd != ring->wr) {
+            p = ring->nodes[ring->rd++ % MPP_MEM_POOL_XT_RING];
+            pthread_cond_broadcast(&ring->cond);
+        }
+        pthread_mutex_unlock(&ring->lock);
+
+        if (NULL == p)
+            break;
+
+        mpp_mem_pool_put(ctx->pool, p);
+    }
+
+    return NULL;
+}
+
+/*
+ * Getter threads only get and one putter thread only puts like frame or
+ * packet created by decoder and released by user. A refill must not move all
+ * free nodes to one getter, otherwise the other getters keep creating nodes.
+ */
+static RK_S32 mem_pool_xt_test(RK_U32 getter_count)
+{
+    MemPoolXtCtx getter[MPP_MEM_POOL_XT_MAX_GETTER];
+    MemPoolXtCtx putter;
+    pthread_t thds[MPP_MEM_POOL_XT_MAX_GETTER + 1];
+    MppMemPool pool = mpp_mem_pool_init(MPP_MEM_POOL_MT_SIZE);
+    MemPoolXtRing ring;
+    MppMemPoolStat stat;
+    RK_S32 node_max;
+    RK_S32 ret = MPP_OK;
+    RK_S64 time;
+    RK_U32 i;
+
+    if (NULL == pool)
+        return MPP_NOK;
+
+    memset(&ring, 0, sizeof(ring));
+    pthread_mutex_init(&ring.lock, NULL);
+    pthread_cond_init(&ring.cond, NULL);
+
+    time = mpp_time();
+    for (i = 0; i < getter_count; i++) {
+        getter[i].pool = pool;
+        getter[i].ring = &ring;
+        getter[i].loop = MPP_MEM_POOL_XT_LOOP / getter_count;
+        getter[i].ret = MPP_OK;
+        pthread_create(&thds[i], NULL, mem_pool_xt_getter, &getter[i]);
+    }
+
+    /* putter loop is the getter count to wait */
+    putter.pool = pool;
+    putter.ring = &ring;
+    putter.loop = getter_count;
+    putter.ret = MPP_OK;
+    pthread_create(&thds[getter_count], NULL, mem_pool_xt_putter, &putter);
+
+    for (i = 0; i <= getter_count; i++)
+        pthread_join(thds[i], NULL);
+    time = mpp_time() - time;
+
+    for (i = 0; i < getter_count; i++)
+        ret |= getter[i].ret;
+
+    mpp_mem_pool_get_stat(pool, &stat);
+
+    /* nodes in ring, in hand and in the cache of every thread */
+    node_max = MPP_MEM_POOL_XT_RING + getter_count +
+               MPP_MEM_POOL_XT_CACHE_MAX * (getter_count + 1);
+
+    mpp_log("xt test %d getter %8.2f M get+put/s refill %lld node %d max %d\n",
+            getter_count, (double)stat.get_count / MPP_MAX(time, 1),
+            stat.refill_count, stat.node_count, node_max);
+
+    if (stat.get_count != stat.put_count) {
+        mpp_err("xt test get %lld put %lld mismatch\n", stat.get_count, stat.put_count);
+        ret = MPP_NOK;
+    }
+
+    if (stat.node_count > node_max) {
+        mpp_err("xt test node count %d exceeds %d\n", stat.node_count, node_max);
+        ret = MPP_NOK;
+    }
+
+    mpp_mem_pool_deinit(pool);
+    pthread_cond_destroy(&ring.cond);
+    pthread_mutex_destroy(&ring.lock);
+
+    return ret;
+}
+
 int main()
 {
     MppMemPool pool = NULL;
@@ -69,6 +323,16 @@ int main()
         }
     }
 
+    for (i = 1; i <= MPP_MEM_POOL_MT_MAX_THREAD; i <<= 1) {
+        if (mem_pool_mt_test(i))
+            goto mpp_mem_pool_test_failed;
+    }
+
+    for (i = 1; i <= MPP_MEM_POOL_XT_MAX_GETTER; i <<= 1) {
+        if (mem_pool_xt_test(i))
+            goto mpp_mem_pool_test_failed;
+    }
+
     mpp_log("mpp_mem_pool_test success\n");
     return MPP_OK;
 
@@ -35,6 +35,10 @@ int main()
     RK_S64 time_1;
     MppClock clock;
     MppTimer timer;
+    MppTimeHist hist;
+    RK_S64 p50;
+    RK_S64 p99;
+    RK_S32 ret = 0;
     RK_S32 i;
 
     mpp_log("mpp time test start\n");
@@ -103,8 +107,41 @@ int main()
     mpp_log("mpp_time pause 0 at %.3f ms pause 1 at %.3f ms\n",
             time_0 / 1000.0, time_1 / 1000.0);
 
+    mpp_clock_put(clock);
 
-    mpp_log("mpp time test done\n");
+    mpp_log("mpp time hist test start\n");
+
+    hist = mpp_time_hist_get("hist test");
+
+    /* uniform 1 ~ 10000 us so p50 is 5000 us and p99 is 9900 us */
+    for (i = 1; i <= 10000; i++)
+        mpp_time_hist_add(hist, i);
+
+    p50 = mpp_time_hist_percentile(hist, 500);
+    p99 = mpp_time_hist_percentile(hist, 990);
+
+    mpp_log("hist count %lld avg %lld p50 %lld p99 %lld max %lld\n",
+            mpp_time_hist_get_count(hist),
+            mpp_time_hist_get_sum(hist) / mpp_time_hist_get_count(hist),
+            p50, p99, mpp_time_hist_get_max(hist));
+
+    if (p50 < 5000 * 31 / 32 || p50 > 5000 * 33 / 32 ||
+        p99 < 9900 * 31 / 32 || p99 > 9900 * 33 / 32 ||
+        mpp_time_hist_get_max(hist) != 10000) {
+        mpp_err("mpp time hist percentile check failed\n");
+        ret = -1;
+    }
+
+    mpp_time_hist_reset(hist);
+    if (mpp_time_hist_get_count(hist) || mpp_time_hist_percentile(hist, 500)) {
+        mpp_err("mpp time hist reset check failed\n");
+        ret = -1;
+    }
+
+    mpp_time_hist_put(hist);
+
+
+    mpp_log("mpp time test %s\n", ret ? "failed" : "done");
 
-    return 0;
+    return ret;
 }
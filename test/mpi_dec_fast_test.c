@@ -0,0 +1,214 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpi_dec_fast_test"
+
+#include <string.h>
+#include "rk_mpi.h"
+
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpi_dec_utils.h"
+
+/*
+ * Fast parse benchmark
+ *
+ * Decode the same input twice, first with base:fast_parse off then on, and
+ * report the fps of both runs. With fast parse the parser prepares the next
+ * frame while the current one is still in hardware unless the codec needs
+ * the hardware feedback first, e.g. vp9 frame with refresh_frame_context or
+ * av1 frame without disable_frame_end_update_cdf. So streams coded with
+ * error_resilient_mode / frame_parallel_decoding_mode show the largest gain.
+ * av1 fast parse also needs env hal_av1d_fast_mode=1.
+ */
+typedef struct DecFastResult_t {
+    RK_S32      frame_count;
+    RK_S32      err_count;
+    RK_S64      elapsed_time;
+} DecFastResult;
+
+static MPP_RET dec_fast_run(MpiDecTestCmd *cmd, RK_U32 fast_parse, DecFastResult *res)
+{
+    MppCtx ctx = NULL;
+    MppApi *mpi = NULL;
+    MppDecCfg cfg = NULL;
+    MppPacket packet = NULL;
+    RK_U32 pkt_pending = 0;
+    RK_U32 pkt_eos = 0;
+    RK_U32 frm_eos = 0;
+    RK_S64 time_start = 0;
+    MPP_RET ret;
+
+    memset(res, 0, sizeof(*res));
+    reader_rewind(cmd->reader);
+
+    ret = mpp_packet_init(&packet, NULL, 0);
+    if (ret) {
+        mpp_err("mpp_packet_init failed\n");
+        goto DONE;
+    }
+
+    ret = mpp_create(&ctx, &mpi);
+    if (ret) {
+        mpp_err("mpp_create failed\n");
+        goto DONE;
+    }
+
+    /* fast parse decides the hal task count so it must be set before init */
+    ret = mpi->control(ctx, MPP_DEC_SET_PARSER_FAST_MODE, &fast_parse);
+    if (ret) {
+        mpp_err("%p failed to set fast parse ret %d\n", ctx, ret);
+        goto DONE;
+    }
+
+    ret = mpp_init(ctx, MPP_CTX_DEC, cmd->type);
+    if (ret) {
+        mpp_err("%p mpp_init failed\n", ctx);
+        goto DONE;
+    }
+
+    mpp_dec_cfg_init(&cfg);
+    mpi->control(ctx, MPP_DEC_GET_CFG, cfg);
+    mpp_dec_cfg_set_u32(cfg, "base:split_parse", 1);
+    ret = mpi->control(ctx, MPP_DEC_SET_CFG, cfg);
+    if (ret) {
+        mpp_err("%p failed to set cfg ret %d\n", ctx, ret);
+        goto DONE;
+    }
+
+    time_start = mpp_time();
+
+    while (!frm_eos) {
+        RK_U32 progress = 0;
+
+        if (!pkt_eos && !pkt_pending) {
+            FileBufSlot *slot = NULL;
+
+            ret = reader_read(cmd->reader, &slot);
+            if (ret || !slot)
+                break;
+
+            pkt_eos = slot->eos;
+            if (cmd->frame_num > 0 && res->frame_count >= cmd->frame_num)
+                pkt_eos = 1;
+
+            mpp_packet_set_data(packet, slot->data);
+            mpp_packet_set_size(packet, slot->size);
+            mpp_packet_set_pos(packet, slot->data);
+            mpp_packet_set_length(packet, slot->size);
+            if (pkt_eos)
+                mpp_packet_set_eos(packet);
+
+            pkt_pending = 1;
+        }
+
+        if (pkt_pending && !mpi->decode_put_packet(ctx, packet)) {
+            pkt_pending = 0;
+            progress = 1;
+        }
+
+        do {
+            MppFrame frame = NULL;
+
+            ret = mpi->decode_get_frame(ctx, &frame);
+            if (ret || !frame)
+                break;
+
+            if (mpp_frame_get_info_change(frame)) {
+                /* use decoder internal buffer group */
+                mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+            } else if (mpp_frame_get_buffer(frame)) {
+                if (mpp_frame_get_errinfo(frame) || mpp_frame_get_discard(frame))
+                    res->err_count++;
+                res->frame_count++;
+            }
+
+            frm_eos = mpp_frame_get_eos(frame);
+            mpp_frame_deinit(&frame);
+            progress = 1;
+        } while (!frm_eos);
+
+        if (!progress)
+            msleep(1);
+    }
+
+    res->elapsed_time = mpp_time() - time_start;
+    ret = MPP_OK;
+
+DONE:
+    if (ctx) {
+        mpi->reset(ctx);
+        mpp_destroy(ctx);
+    }
+    if (cfg)
+        mpp_dec_cfg_deinit(cfg);
+    if (packet)
+        mpp_packet_deinit(&packet);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    MpiDecTestCmd cmd_ctx;
+    MpiDecTestCmd *cmd = &cmd_ctx;
+    DecFastResult res[2];
+    RK_S32 ret;
+    RK_U32 i;
+
+    memset((void*)cmd, 0, sizeof(*cmd));
+    cmd->format = MPP_FMT_BUTT;
+    cmd->pkt_size = MPI_DEC_STREAM_SIZE;
+
+    ret = mpi_dec_test_cmd_init(cmd, argc, argv);
+    if (ret)
+        goto RET;
+
+    if (!cmd->reader) {
+        mpp_err("no input file\n");
+        ret = MPP_NOK;
+        goto RET;
+    }
+
+    mpi_dec_test_cmd_options(cmd);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(res); i++) {
+        ret = dec_fast_run(cmd, i, &res[i]);
+        if (ret)
+            goto RET;
+
+        mpp_log("fast_parse %d decode %d frames err %d time %lld ms fps %3.2f\n",
+                i, res[i].frame_count, res[i].err_count,
+                (RK_S64)(res[i].elapsed_time / 1000),
+                (float)res[i].frame_count * 1000000 / res[i].elapsed_time);
+    }
+
+    if (res[0].frame_count != res[1].frame_count) {
+        mpp_err("frame count mismatch %d vs %d\n",
+                res[0].frame_count, res[1].frame_count);
+        ret = MPP_NOK;
+    } else if (res[1].elapsed_time) {
+        mpp_log("fast parse fps gain %.2f%%\n",
+                (res[0].elapsed_time * 100.0 / res[1].elapsed_time) - 100.0);
+    }
+
+RET:
+    mpi_dec_test_cmd_deinit(cmd);
+
+    return ret;
+}
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpi_dec_scale_test"
+
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/resource.h>
+#endif
+
+#include "rk_mpi.h"
+
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+#include "mpp_impl.h"
+#include "mpp_common.h"
+#include "mpi_dec_utils.h"
+
+/*
+ * Decoder instance scaling benchmark
+ *
+ * Run 1, 2, 4 ... up to -s instances decoding the same input concurrently
+ * and record for each step:
+ * aggregate fps, process cpu usage and cpu time per frame, context switches,
+ * peak thread count, lock count / contention / wait time of the locks shared
+ * by all instances and the decoder stage timing per frame.
+ *
+ * Each instance decodes -n frames, or the whole input when -n is not set.
+ * The result is written as csv to the -o file.
+ *
+ * Set mpp_dev_mock=1 to run on the mock device without hardware. Then the
+ * hardware time is simulated by mpp_dev_mock_latency and the result shows the
+ * host side cost only.
+ */
+#define SCALE_STAGE_MAX     16
+
+/* the locks shared by all instances */
+static const char *lock_names[] = {
+    "mpp_buffer",
+    "mpp_mem_pool",
+    "mpp_meta",
+};
+
+typedef struct DecScaleSnap_t {
+    RK_S64          time;
+    RK_S64          cpu_time;
+    RK_S64          nvcsw;
+    RK_S64          nivcsw;
+    MppLockStat     locks[MPP_ARRAY_ELEMS(lock_names)];
+    MppDecTimingStat stages[SCALE_STAGE_MAX];
+    RK_S32          stage_cnt;
+} DecScaleSnap;
+
+typedef struct DecScaleInst_t {
+    MpiDecTestCmd   *cmd;
+    pthread_t       thd;
+    RK_S32          frame_count;
+    RK_S32          err_count;
+    RK_S32          ret;
+    RK_U32          *done;
+} DecScaleInst;
+
+static void scale_snap(DecScaleSnap *snap)
+{
+    RK_U32 i;
+
+    memset(snap, 0, sizeof(*snap));
+
+#if defined(__linux__)
+    {
+        struct rusage usage;
+
+        if (!getrusage(RUSAGE_SELF, &usage)) {
+            snap->cpu_time = (RK_S64)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec +
+                             (RK_S64)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+            snap->nvcsw = usage.ru_nvcsw;
+            snap->nivcsw = usage.ru_nivcsw;
+        }
+    }
+#endif
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(lock_names); i++) {
+        MppLockStat *stat = mpp_lock_stat_get(lock_names[i]);
+
+        if (stat)
+            snap->locks[i] = *stat;
+    }
+
+    snap->stage_cnt = mpp_dec_timing_stat_get(snap->stages, SCALE_STAGE_MAX);
+    snap->time = mpp_time();
+}
+
+static RK_S32 scale_thread_count(void)
+{
+    RK_S32 count = 0;
+
+#if defined(__linux__)
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+
+    if (!dir)
+        return 0;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.')
+            count++;
+    }
+
+    closedir(dir);
+#endif
+
+    return count;
+}
+
+static void *scale_dec_thread(void *arg)
+{
+    DecScaleInst *inst = (DecScaleInst *)arg;
+    MpiDecTestCmd *cmd = inst->cmd;
+    MppCtx ctx = NULL;
+    MppApi *mpi = NULL;
+    MppPacket packet = NULL;
+    RK_S32 pkt_idx = 0;
+    RK_U32 pkt_pending = 0;
+    RK_U32 pkt_eos = 0;
+    RK_U32 frm_eos = 0;
+    MPP_RET ret;
+
+    ret = mpp_packet_init(&packet, NULL, 0);
+    if (ret) {
+        mpp_err("mpp_packet_init failed\n");
+        goto DONE;
+    }
+
+    ret = mpp_create(&ctx, &mpi);
+    if (ret) {
+        mpp_err("mpp_create failed\n");
+        goto DONE;
+    }
+
+    ret = mpp_init(ctx, MPP_CTX_DEC, cmd->type);
+    if (ret) {
+        mpp_err("%p mpp_init failed\n", ctx);
+        goto DONE;
+    }
+
+    while (!frm_eos) {
+        RK_U32 progress = 0;
+
+        if (!pkt_eos && !pkt_pending) {
+            FileBufSlot *slot = NULL;
+
+            ret = reader_index_read(cmd->reader, pkt_idx++, &slot);
+            if (ret || !slot)
+                break;
+
+            pkt_eos = slot->eos;
+            if (cmd->frame_num > 0 && inst->frame_count >= cmd->frame_num)
+                pkt_eos = 1;
+
+            mpp_packet_set_data(packet, slot->data);
+            mpp_packet_set_size(packet, slot->size);
+            mpp_packet_set_pos(packet, slot->data);
+            mpp_packet_set_length(packet, slot->size);
+            if (pkt_eos)
+                mpp_packet_set_eos(packet);
+
+            pkt_pending = 1;
+        }
+
+        if (pkt_pending && !mpi->decode_put_packet(ctx, packet)) {
+            pkt_pending = 0;
+            progress = 1;
+        }
+
+        do {
+            MppFrame frame = NULL;
+
+            ret = mpi->decode_get_frame(ctx, &frame);
+            if (ret || !frame)
+                break;
+
+            if (mpp_frame_get_info_change(frame)) {
+                /* use decoder internal buffer group */
+                mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+            } else if (mpp_frame_get_buffer(frame)) {
+                if (mpp_frame_get_errinfo(frame) || mpp_frame_get_discard(frame))
+                    inst->err_count++;
+                inst->frame_count++;
+            }
+
+            frm_eos = mpp_frame_get_eos(frame);
+            mpp_frame_deinit(&frame);
+            progress = 1;
+        } while (!frm_eos);
+
+        if (!progress)
+            msleep(1);
+    }
+
+    ret = MPP_OK;
+
+DONE:
+    /* destroy before done so the stage timing is summed on decoder deinit */
+    if (ctx) {
+        mpi->reset(ctx);
+        mpp_destroy(ctx);
+    }
+    if (packet)
+        mpp_packet_deinit(&packet);
+
+    inst->ret = ret;
+    MPP_FETCH_ADD(inst->done, 1);
+
+    return NULL;
+}
+
+static void scale_csv_header(FILE *fp, DecScaleSnap *snap)
+{
+    RK_S32 i;
+    RK_U32 j;
+
+    fprintf(fp, "instances,frames,errors,time_ms,fps,fps_per_inst,cpu_pct,cpu_us_per_frm,"
+            "vol_csw,invol_csw,csw_per_frm,threads,threads_per_inst");
+
+    for (j = 0; j < MPP_ARRAY_ELEMS(lock_names); j++)
+        fprintf(fp, ",%s_lock,%s_contend,%s_wait_us", lock_names[j],
+                lock_names[j], lock_names[j]);
+
+    /* stage name has padding space for log alignment */
+    for (i = 0; i < snap->stage_cnt; i++) {
+        char name[32];
+        char *p;
+
+        snprintf(name, sizeof(name), "%s", snap->stages[i].name);
+        for (p = name + strlen(name); p > name && p[-1] == ' '; p--)
+            p[-1] = '\0';
+        for (p = name; *p; p++) {
+            if (*p == ' ')
+                *p = '_';
+        }
+
+        fprintf(fp, ",%s_us_per_frm", name);
+    }
+
+    fprintf(fp, "\n");
+}
+
+static MPP_RET scale_run(MpiDecTestCmd *cmd, RK_S32 count, FILE *fp)
+{
+    DecScaleInst *insts = mpp_calloc(DecScaleInst, count);
+    DecScaleSnap start;
+    DecScaleSnap end;
+    RK_U32 done = 0;
+    RK_S32 frames = 0;
+    RK_S32 errors = 0;
+    RK_S32 threads = 0;
+    RK_S64 time;
+    RK_S64 cpu_time;
+    RK_S64 csw;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
+    RK_U32 j;
+
+    if (!insts) {
+        mpp_err("failed to alloc %d instances\n", count);
+        return MPP_ERR_MALLOC;
+    }
+
+    scale_snap(&start);
+
+    for (i = 0; i < count; i++) {
+        insts[i].cmd = cmd;
+        insts[i].done = &done;
+        if (pthread_create(&insts[i].thd, NULL, scale_dec_thread, &insts[i])) {
+            mpp_err("failed to create instance %d\n", i);
+            count = i;
+            ret = MPP_NOK;
+            break;
+        }
+    }
+
+    /* sample the peak thread count while all instances are running */
+    while (MPP_FETCH_ADD(&done, 0) < (RK_U32)count) {
+        RK_S32 cnt = scale_thread_count();
+
+        if (cnt > threads)
+            threads = cnt;
+
+        msleep(10);
+    }
+
+    for (i = 0; i < count; i++) {
+        pthread_join(insts[i].thd, NULL);
+        frames += insts[i].frame_count;
+        errors += insts[i].err_count;
+        ret |= insts[i].ret;
+    }
+
+    scale_snap(&end);
+
+    MPP_FREE(insts);
+
+    time = end.time - start.time;
+    cpu_time = end.cpu_time - start.cpu_time;
+    csw = (end.nvcsw - start.nvcsw) + (end.nivcsw - start.nivcsw);
+
+    if (!time || !frames) {
+        mpp_err("instances %d decode %d frames in %lld us\n", count, frames, time);
+        return MPP_NOK;
+    }
+
+    mpp_log("instances %3d frames %6d fps %8.2f cpu %6.1f%% %7.1f us/frm csw %6.1f/frm threads %d\n",
+            count, frames, frames * 1000000.0 / time, cpu_time * 100.0 / time,
+            (double)cpu_time / frames, (double)csw / frames, threads);
+
+    for (j = 0; j < MPP_ARRAY_ELEMS(lock_names); j++) {
+        RK_S64 lock_cnt = end.locks[j].lock_cnt - start.locks[j].lock_cnt;
+        RK_S64 contend = end.locks[j].contend_cnt - start.locks[j].contend_cnt;
+        RK_S64 wait = end.locks[j].wait_time - start.locks[j].wait_time;
+
+        if (lock_cnt)
+            mpp_log("instances %3d lock %-12s %8lld contend %6.2f%% wait %lld us\n",
+                    count, lock_names[j], lock_cnt, contend * 100.0 / lock_cnt, wait);
+    }
+
+    if (!fp)
+        return ret;
+
+    fprintf(fp, "%d,%d,%d,%lld,%.2f,%.2f,%.1f,%.1f,%lld,%lld,%.2f,%d,%.2f",
+            count, frames, errors, time / 1000, frames * 1000000.0 / time,
+            frames * 1000000.0 / time / count, cpu_time * 100.0 / time,
+            (double)cpu_time / frames, end.nvcsw - start.nvcsw,
+            end.nivcsw - start.nivcsw, (double)csw / frames, threads,
+            threads > 1 ? (threads - 1.0) / count : 0.0);
+
+    for (j = 0; j < MPP_ARRAY_ELEMS(lock_names); j++)
+        fprintf(fp, ",%lld,%lld,%lld",
+                end.locks[j].lock_cnt - start.locks[j].lock_cnt,
+                end.locks[j].contend_cnt - start.locks[j].contend_cnt,
+                end.locks[j].wait_time - start.locks[j].wait_time);
+
+    for (i = 0; i < end.stage_cnt; i++)
+        fprintf(fp, ",%.1f", (double)(end.stages[i].sum - start.stages[i].sum) / frames);
+
+    fprintf(fp, "\n");
+    fflush(fp);
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    MpiDecTestCmd cmd_ctx;
+    MpiDecTestCmd *cmd = &cmd_ctx;
+    FILE *fp = NULL;
+    RK_S32 count;
+    RK_S32 ret;
+
+    memset((void*)cmd, 0, sizeof(*cmd));
+    cmd->format = MPP_FMT_BUTT;
+    cmd->pkt_size = MPI_DEC_STREAM_SIZE;
+    cmd->nthreads = 1;
+
+    ret = mpi_dec_test_cmd_init(cmd, argc, argv);
+    if (ret)
+        goto RET;
+
+    if (!cmd->reader) {
+        mpp_err("no input file\n");
+        ret = MPP_NOK;
+        goto RET;
+    }
+
+    mpi_dec_test_cmd_options(cmd);
+
+    if (cmd->have_output) {
+        fp = fopen(cmd->file_output, "w");
+        if (!fp) {
+            mpp_err("failed to open csv file %s\n", cmd->file_output);
+            ret = MPP_NOK;
+            goto RET;
+        }
+    }
+
+    /* enable the decoder stage timing for all instances */
+    mpp_env_set_u32("mpp_dec_stat", 1);
+
+    if (fp) {
+        DecScaleSnap snap;
+
+        scale_snap(&snap);
+        scale_csv_header(fp, &snap);
+    }
+
+    for (count = 1; ; count *= 2) {
+        if (count > cmd->nthreads)
+            count = cmd->nthreads;
+
+        ret = scale_run(cmd, count, fp);
+        if (ret)
+            break;
+
+        if (count >= cmd->nthreads)
+            break;
+    }
+
+    mpp_log("mpi_dec_scale_test %s\n", ret ? "failed" : "success");
+
+RET:
+    if (fp)
+        fclose(fp);
+
+    mpi_dec_test_cmd_deinit(cmd);
+
+    return ret;
+}
@@ -198,8 +198,15 @@ static int dec_simple(MpiDecLoopData *data)
                         dump_mpp_frame_to_file(frame, data->fp_output);
 
                     if (data->fp_verify) {
-                        calc_frm_crc(frame, checkcrc);
-                        write_frm_crc(data->fp_verify, checkcrc);
+                        if (cmd->slt_md5) {
+                            RK_U8 md5[16];
+
+                            calc_frm_md5(frame, md5);
+                            write_md5(data->fp_verify, md5);
+                        } else {
+                            calc_frm_crc(frame, checkcrc);
+                            write_frm_crc(data->fp_verify, checkcrc);
+                        }
                     }
 
                     fps_calc_inc(cmd->fps);
@@ -336,8 +343,15 @@ static int dec_advanced(MpiDecLoopData *data)
                 dump_mpp_frame_to_file(frame, data->fp_output);
 
             if (data->fp_verify) {
-                calc_frm_crc(frame, checkcrc);
-                write_frm_crc(data->fp_verify, checkcrc);
+                if (cmd->slt_md5) {
+                    RK_U8 md5[16];
+
+                    calc_frm_md5(frame, md5);
+                    write_md5(data->fp_verify, md5);
+                } else {
+                    calc_frm_crc(frame, checkcrc);
+                    write_frm_crc(data->fp_verify, checkcrc);
+                }
             }
 
             mpp_log_q(quiet, "%p decoded frame %d\n", ctx, data->frame_count);
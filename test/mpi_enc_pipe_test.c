@@ -0,0 +1,358 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpi_enc_pipe_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "rk_mpi.h"
+
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_dev_mock_api.h"
+
+/*
+ * Encoder pipeline depth benchmark on mock device
+ *
+ * Encode -n frames with MPP_SET_ENC_TASK_COUNT set from 1 to -d and record
+ * the wall time, process cpu time and simulated hardware time per frame.
+ *
+ * Host overhead is the part of the frame time which is not covered by the
+ * hardware. On depth 1 the rc / header / register setup of next frame waits
+ * for the hardware of current frame so it is fully exposed. On depth 2 and
+ * above it runs while the previous frame is on hardware.
+ *
+ * usage: mpi_enc_pipe_test -w width -h height -t type -n frames
+ *                          -d max depth -l hardware latency in us
+ */
+/* encoder accepts up to four frames in flight */
+#define ENC_PIPE_DEPTH_MAX      4
+#define ENC_PIPE_BUF_CNT        (ENC_PIPE_DEPTH_MAX + 2)
+
+typedef struct EncPipeCfg_t {
+    RK_S32          width;
+    RK_S32          height;
+    MppCodingType   type;
+    RK_S32          frame_num;
+    RK_S32          depth_max;
+    RK_S32          latency;
+} EncPipeCfg;
+
+typedef struct EncPipeCtx_t {
+    EncPipeCfg      *cfg;
+    MppCtx          ctx;
+    MppApi          *mpi;
+    RK_S32          async;
+    RK_U32          abort;
+    RK_S32          pkt_count;
+    RK_S64          stream_size;
+    RK_S64          end_time;
+} EncPipeCtx;
+
+static RK_S64 pipe_cpu_time(void)
+{
+    RK_S64 time = 0;
+
+#if defined(__linux__)
+    struct rusage usage;
+
+    if (!getrusage(RUSAGE_SELF, &usage))
+        time = (RK_S64)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec +
+               (RK_S64)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+#endif
+
+    return time;
+}
+
+static void *pipe_output_thread(void *arg)
+{
+    EncPipeCtx *p = (EncPipeCtx *)arg;
+    RK_U32 eos = 0;
+
+    while (!eos && !p->abort) {
+        MppPacket packet = NULL;
+        MPP_RET ret = p->mpi->encode_get_packet(p->ctx, &packet);
+
+        if (ret || !packet)
+            continue;
+
+        eos = mpp_packet_get_eos(packet);
+
+        /* input frame is returned with output packet on async mode */
+        if (p->async && mpp_packet_has_meta(packet)) {
+            MppMeta meta = mpp_packet_get_meta(packet);
+            MppFrame frm = NULL;
+
+            if (!mpp_meta_get_frame(meta, KEY_INPUT_FRAME, &frm) && frm)
+                mpp_frame_deinit(&frm);
+        }
+
+        p->stream_size += mpp_packet_get_length(packet);
+        p->pkt_count++;
+        mpp_packet_deinit(&packet);
+    }
+
+    p->end_time = mpp_time();
+
+    return NULL;
+}
+
+static MPP_RET pipe_setup(EncPipeCtx *p, RK_S32 depth)
+{
+    EncPipeCfg *cfg = p->cfg;
+    /* timeout for exit on put frame failure */
+    MppPollType timeout = (MppPollType)100;
+    MppEncCfg enc_cfg = NULL;
+    MPP_RET ret;
+
+    ret = mpp_create(&p->ctx, &p->mpi);
+    if (ret) {
+        mpp_err("mpp_create failed ret %d\n", ret);
+        return ret;
+    }
+
+    ret = p->mpi->control(p->ctx, MPP_SET_ENC_TASK_COUNT, &depth);
+    if (ret) {
+        mpp_err("set encoder task count %d ret %d\n", depth, ret);
+        return ret;
+    }
+
+    ret = p->mpi->control(p->ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout);
+    if (ret) {
+        mpp_err("set output timeout ret %d\n", ret);
+        return ret;
+    }
+
+    ret = mpp_init(p->ctx, MPP_CTX_ENC, cfg->type);
+    if (ret) {
+        mpp_err("mpp_init failed ret %d\n", ret);
+        return ret;
+    }
+
+    ret = mpp_enc_cfg_init(&enc_cfg);
+    if (ret) {
+        mpp_err("mpp_enc_cfg_init failed ret %d\n", ret);
+        return ret;
+    }
+
+    p->mpi->control(p->ctx, MPP_ENC_GET_CFG, enc_cfg);
+
+    mpp_enc_cfg_set_s32(enc_cfg, "prep:width", cfg->width);
+    mpp_enc_cfg_set_s32(enc_cfg, "prep:height", cfg->height);
+    mpp_enc_cfg_set_s32(enc_cfg, "prep:hor_stride", MPP_ALIGN(cfg->width, 16));
+    mpp_enc_cfg_set_s32(enc_cfg, "prep:ver_stride", MPP_ALIGN(cfg->height, 16));
+    mpp_enc_cfg_set_s32(enc_cfg, "prep:format", MPP_FMT_YUV420SP);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:mode", MPP_ENC_RC_MODE_CBR);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:bps_target", cfg->width * cfg->height / 8 * 30);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:bps_max", cfg->width * cfg->height / 8 * 30 * 17 / 16);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:bps_min", cfg->width * cfg->height / 8 * 30 * 15 / 16);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:fps_in_num", 30);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:fps_in_denom", 1);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:fps_out_num", 30);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:fps_out_denom", 1);
+    mpp_enc_cfg_set_s32(enc_cfg, "rc:gop", 60);
+
+    ret = p->mpi->control(p->ctx, MPP_ENC_SET_CFG, enc_cfg);
+    if (ret)
+        mpp_err("set enc cfg failed ret %d\n", ret);
+
+    mpp_enc_cfg_deinit(enc_cfg);
+
+    return ret;
+}
+
+static MPP_RET pipe_run(EncPipeCfg *cfg, RK_S32 depth)
+{
+    EncPipeCtx ctx;
+    EncPipeCtx *p = &ctx;
+    MppBufferGroup group = NULL;
+    MppBuffer bufs[ENC_PIPE_BUF_CNT];
+    MppDevMockStat mock_start;
+    MppDevMockStat mock_end;
+    pthread_t thd;
+    RK_S32 hor_stride = MPP_ALIGN(cfg->width, 16);
+    RK_S32 ver_stride = MPP_ALIGN(cfg->height, 16);
+    size_t size = hor_stride * ver_stride * 3 / 2;
+    RK_S64 start_time;
+    RK_S64 cpu_time = 0;
+    RK_S64 hw_time;
+    RK_S64 time = 0;
+    double frm_us;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    memset(p, 0, sizeof(*p));
+    memset(bufs, 0, sizeof(bufs));
+    p->cfg = cfg;
+    p->async = depth > 1;
+
+    mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    for (i = 0; i < ENC_PIPE_BUF_CNT; i++) {
+        mpp_buffer_get(group, &bufs[i], size);
+        if (!bufs[i]) {
+            mpp_err("failed to get frame buffer size %d\n", (RK_S32)size);
+            goto DONE;
+        }
+        memset(mpp_buffer_get_ptr(bufs[i]), 0x80, size);
+    }
+
+    ret = pipe_setup(p, depth);
+    if (ret)
+        goto DONE;
+
+    mpp_dev_mock_get_stat(&mock_start);
+    cpu_time = pipe_cpu_time();
+    start_time = mpp_time();
+
+    if (pthread_create(&thd, NULL, pipe_output_thread, p)) {
+        mpp_err("failed to create output thread\n");
+        ret = MPP_NOK;
+        goto DONE;
+    }
+
+    for (i = 0; i < cfg->frame_num; i++) {
+        MppFrame frame = NULL;
+
+        mpp_frame_init(&frame);
+        mpp_frame_set_width(frame, cfg->width);
+        mpp_frame_set_height(frame, cfg->height);
+        mpp_frame_set_hor_stride(frame, hor_stride);
+        mpp_frame_set_ver_stride(frame, ver_stride);
+        mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+        mpp_frame_set_pts(frame, i);
+        mpp_frame_set_buffer(frame, bufs[i % ENC_PIPE_BUF_CNT]);
+        if (i == cfg->frame_num - 1)
+            mpp_frame_set_eos(frame, 1);
+
+        ret = p->mpi->encode_put_frame(p->ctx, frame);
+        if (ret) {
+            mpp_err("put frame %d failed ret %d\n", i, ret);
+            mpp_frame_deinit(&frame);
+            p->abort = 1;
+            break;
+        }
+
+        if (!p->async)
+            mpp_frame_deinit(&frame);
+    }
+
+    pthread_join(thd, NULL);
+
+    cpu_time = pipe_cpu_time() - cpu_time;
+    time = p->end_time - start_time;
+
+DONE:
+    if (p->ctx) {
+        mpp_destroy(p->ctx);
+        p->ctx = NULL;
+    }
+
+    for (i = 0; i < ENC_PIPE_BUF_CNT; i++) {
+        if (bufs[i])
+            mpp_buffer_put(bufs[i]);
+    }
+
+    if (group)
+        mpp_buffer_group_put(group);
+
+    if (ret)
+        return ret;
+
+    /* mock statistic is summed on device deinit */
+    mpp_dev_mock_get_stat(&mock_end);
+    hw_time = (RK_S64)(mock_end.send_cnt - mock_start.send_cnt) * cfg->latency;
+
+    if (!p->pkt_count || !time) {
+        mpp_err("depth %d encode %d packets in %lld us\n", depth, p->pkt_count, time);
+        return MPP_NOK;
+    }
+
+    frm_us = (double)time / p->pkt_count;
+    mpp_log("depth %d frames %4d fps %8.2f frame %8.1f us hw %8.1f us "
+            "host overhead %7.1f us cpu %7.1f us/frm stream %lld\n",
+            depth, p->pkt_count, p->pkt_count * 1000000.0 / time, frm_us,
+            (double)hw_time / p->pkt_count, frm_us - (double)hw_time / p->pkt_count,
+            (double)cpu_time / p->pkt_count, p->stream_size);
+
+    return MPP_OK;
+}
+
+int main(int argc, char **argv)
+{
+    EncPipeCfg cfg;
+    RK_S32 depth;
+    RK_S32 i;
+    MPP_RET ret = MPP_OK;
+
+    cfg.width = 1920;
+    cfg.height = 1080;
+    cfg.type = MPP_VIDEO_CodingAVC;
+    cfg.frame_num = 120;
+    cfg.depth_max = 3;
+    cfg.latency = 2000;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        RK_S32 val = atoi(argv[i + 1]);
+
+        if (!strcmp(argv[i], "-w"))
+            cfg.width = val;
+        else if (!strcmp(argv[i], "-h"))
+            cfg.height = val;
+        else if (!strcmp(argv[i], "-t"))
+            cfg.type = (MppCodingType)val;
+        else if (!strcmp(argv[i], "-n"))
+            cfg.frame_num = val;
+        else if (!strcmp(argv[i], "-d"))
+            cfg.depth_max = val;
+        else if (!strcmp(argv[i], "-l"))
+            cfg.latency = val;
+        else
+            mpp_log("unknown option %s\n", argv[i]);
+    }
+
+    if (cfg.width <= 0 || cfg.height <= 0 || cfg.frame_num <= 0 ||
+        cfg.depth_max <= 0 || cfg.depth_max > ENC_PIPE_DEPTH_MAX) {
+        mpp_err("invalid w %d h %d frames %d depth %d\n", cfg.width,
+                cfg.height, cfg.frame_num, cfg.depth_max);
+        return MPP_NOK;
+    }
+
+    /* run on mock device with fixed hardware time */
+    mpp_env_set_u32("mpp_dev_mock", 1);
+    mpp_env_set_u32("mpp_dev_mock_latency", cfg.latency);
+
+    mpp_log("encoder type %d %dx%d frames %d hardware %d us\n", cfg.type,
+            cfg.width, cfg.height, cfg.frame_num, cfg.latency);
+
+    for (depth = 1; depth <= cfg.depth_max; depth++) {
+        ret = pipe_run(&cfg, depth);
+        if (ret)
+            break;
+    }
+
+    mpp_log("mpi_enc_pipe_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright 2024 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "utils_crc_test"
+
+#include <limits.h>
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "utils.h"
+
+#define CRC_SUM_CNT         512
+#define CRC_BENCH_WIDTH     1920
+#define CRC_BENCH_HEIGHT    1080
+#define CRC_BENCH_LOOP      50
+
+#define MAX_HALF_WORD_SUM_CNT \
+    ((RK_ULONG)((0-1) / ((1UL << ((__SIZEOF_POINTER__ * 8) / 2)) - 1)))
+#define CAL_BYTE (__SIZEOF_POINTER__ >> 1)
+
+typedef struct Md5Vector_t {
+    const char  *str;
+    const char  *md5;
+} Md5Vector;
+
+static const Md5Vector md5_vectors[] = {
+    { "", "d41d8cd98f00b204e9800998ecf8427e" },
+    { "abc", "900150983cd24fb0d6963f7d28e17f72" },
+    { "message digest", "f96b697d7cb7938d525a2f31aaf161d0" },
+    { "The quick brown fox jumps over the lazy dog", "9e107d9d372bb6826bd81d3542a419d6" },
+    {
+        "12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+        "57edf4a22be3c955ac49da2e2107b67a"
+    },
+};
+
+/* reference of the original scalar sum and xor of 8bit 420 frame */
+static void ref_wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
+{
+    RK_U32 loop;
+#if LONG_MAX == INT_MAX
+    RK_U16 *data_rk = (RK_U16 *)data;
+#else
+    RK_U32 *data_rk = (RK_U32 *)data;
+#endif
+
+    for (loop = 0; loop < len / CAL_BYTE; loop++)
+        *sum += data_rk[loop];
+    for (loop = len / CAL_BYTE * CAL_BYTE; loop < len; loop++)
+        *sum += data[loop];
+}
+
+static void ref_calc_plane(RK_U8 *dat8, RK_U32 width, RK_U32 height,
+                           RK_U32 stride, DataCrc *crc, RK_U32 *xor)
+{
+    RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
+    RK_U32 grp_line_cnt = data_grp_byte_cnt / ((width + CAL_BYTE - 1) / CAL_BYTE * CAL_BYTE);
+    RK_U32 x, y;
+
+    crc->sum_cnt = (height + grp_line_cnt - 1) / grp_line_cnt;
+    for (y = 0; y < height; y++)
+        ref_wide_bit_sum(&dat8[y * stride], width, &crc->sum[y / grp_line_cnt]);
+
+    for (y = 0; y < height; y++) {
+        RK_U32 *dat32 = (RK_U32 *)&dat8[y * stride];
+
+        for (x = 0; x < width / 4; x++)
+            *xor ^= dat32[x];
+    }
+    crc->vor = *xor;
+}
+
+static void ref_calc_frm_crc(MppFrame frame, FrmCrc *crc)
+{
+    RK_U32 width  = mpp_frame_get_width(frame);
+    RK_U32 height = mpp_frame_get_height(frame);
+    RK_U32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U32 xor = 0;
+
+    ref_calc_plane(buf, width, height, stride, &crc->luma, &xor);
+    crc->luma.len = height * width;
+    ref_calc_plane(buf + height * stride, width, height / 2, stride, &crc->chroma, &xor);
+    crc->chroma.len = height * width / 2;
+}
+
+static void crc_reset(FrmCrc *crc)
+{
+    memset(crc->luma.sum, 0, sizeof(RK_ULONG) * CRC_SUM_CNT);
+    memset(crc->chroma.sum, 0, sizeof(RK_ULONG) * CRC_SUM_CNT);
+}
+
+static RK_S32 crc_compare(DataCrc *a, DataCrc *b)
+{
+    if (a->len != b->len || a->sum_cnt != b->sum_cnt || a->vor != b->vor)
+        return 1;
+
+    return memcmp(a->sum, b->sum, sizeof(RK_ULONG) * a->sum_cnt) ? 1 : 0;
+}
+
+static MppFrame crc_frame_init(RK_U32 width, RK_U32 height, RK_U32 stride,
+                               RK_U32 ver_stride, MppFrameFormat fmt)
+{
+    MppFrame frame = NULL;
+    MppBuffer buffer = NULL;
+    size_t size = stride * ver_stride * 3 + 64;
+    RK_U8 *ptr;
+    size_t i;
+
+    mpp_buffer_get(NULL, &buffer, size);
+    if (NULL == buffer)
+        return NULL;
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    for (i = 0; i < size; i++)
+        ptr[i] = (RK_U8)(i * 7 + (i >> 8) * 13);
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, width);
+    mpp_frame_set_height(frame, height);
+    mpp_frame_set_hor_stride(frame, stride);
+    mpp_frame_set_ver_stride(frame, ver_stride);
+    mpp_frame_set_fmt(frame, fmt);
+    mpp_frame_set_buffer(frame, buffer);
+    mpp_buffer_put(buffer);
+
+    return frame;
+}
+
+static MPP_RET test_md5(void)
+{
+    RK_U8 md5[16];
+    char str[33];
+    RK_U32 i, j;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(md5_vectors); i++) {
+        const Md5Vector *v = &md5_vectors[i];
+
+        calc_data_md5((RK_U8 *)v->str, strlen(v->str), md5);
+        for (j = 0; j < 16; j++)
+            snprintf(str + j * 2, 3, "%02x", md5[j]);
+
+        if (strcmp(str, v->md5)) {
+            mpp_err("md5 of \"%s\" %s mismatch %s\n", v->str, str, v->md5);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_log("md5 vector test success\n");
+    return MPP_OK;
+}
+
+static MPP_RET test_crc(FrmCrc *crc, FrmCrc *ref)
+{
+    static const RK_U32 sizes[][2] = {
+        { 1920, 1080 }, { 1921, 1081 }, { 1922, 17 }, { 176, 144 },
+        { 3, 2 }, { 7, 5 }, { 13, 9 }, { 4096, 2 },
+    };
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(sizes) && !ret; i++) {
+        RK_U32 width = sizes[i][0];
+        RK_U32 height = sizes[i][1];
+        RK_U32 stride = MPP_ALIGN(width, 16);
+        MppFrame frame = crc_frame_init(width, height, stride,
+                                        MPP_ALIGN(height, 16), MPP_FMT_YUV420SP);
+        RK_U8 *ptr;
+        RK_U32 len;
+
+        if (NULL == frame)
+            return MPP_NOK;
+
+        crc_reset(crc);
+        crc_reset(ref);
+        calc_frm_crc(frame, crc);
+        ref_calc_frm_crc(frame, ref);
+
+        if (crc_compare(&crc->luma, &ref->luma) ||
+            crc_compare(&crc->chroma, &ref->chroma)) {
+            mpp_err("frame %dx%d crc mismatch\n", width, height);
+            ret = MPP_NOK;
+        }
+
+        /* data crc on unaligned length and address */
+        ptr = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+        len = width * height - i;
+
+        crc_reset(crc);
+        crc_reset(ref);
+        calc_data_crc(ptr, len, &crc->luma);
+        ref_wide_bit_sum(ptr, len, &ref->luma.sum[0]);
+        if (crc->luma.sum_cnt == 1 && crc->luma.sum[0] != ref->luma.sum[0]) {
+            mpp_err("data len %d crc sum mismatch\n", len);
+            ret = MPP_NOK;
+        }
+
+        mpp_frame_deinit(&frame);
+    }
+
+    if (!ret)
+        mpp_log("crc compare with reference success\n");
+
+    return ret;
+}
+
+static MPP_RET test_layout(FrmCrc *crc)
+{
+    static const MppFrameFormat fmts[] = {
+        MPP_FMT_YUV420SP, MPP_FMT_YUV420SP_10BIT, MPP_FMT_YUV422SP,
+        MPP_FMT_YUV422SP_10BIT, MPP_FMT_YUV444SP, MPP_FMT_YUV400,
+    };
+    static const RK_U32 chroma_size[] = {
+        176 * 144 / 2, 220 * 144 / 2, 176 * 144,
+        220 * 144, 176 * 144 * 2, 0,
+    };
+    RK_U32 i;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(fmts); i++) {
+        MppFrame frame = crc_frame_init(176, 144, 512, 160, fmts[i]);
+        RK_U8 md5[16];
+
+        if (NULL == frame)
+            return MPP_NOK;
+
+        crc_reset(crc);
+        calc_frm_crc(frame, crc);
+        calc_frm_md5(frame, md5);
+        mpp_frame_deinit(&frame);
+
+        if (crc->chroma.len != chroma_size[i]) {
+            mpp_err("fmt %d chroma size %d mismatch %d\n", fmts[i],
+                    crc->chroma.len, chroma_size[i]);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_log("frame layout test success\n");
+    return MPP_OK;
+}
+
+static void test_bench(FrmCrc *crc, FrmCrc *ref)
+{
+    MppFrame frame = crc_frame_init(CRC_BENCH_WIDTH, CRC_BENCH_HEIGHT,
+                                    CRC_BENCH_WIDTH, MPP_ALIGN(CRC_BENCH_HEIGHT, 16),
+                                    MPP_FMT_YUV420SP);
+    double frm_mb = CRC_BENCH_WIDTH * CRC_BENCH_HEIGHT * 1.5 / 1000000;
+    RK_S64 time_ref;
+    RK_S64 time_crc;
+    RK_S64 time_md5;
+    RK_S64 start;
+    RK_U8 md5[16];
+    RK_U32 i;
+
+    if (NULL == frame)
+        return;
+
+    start = mpp_time();
+    for (i = 0; i < CRC_BENCH_LOOP; i++)
+        ref_calc_frm_crc(frame, ref);
+    time_ref = mpp_time() - start;
+
+    start = mpp_time();
+    for (i = 0; i < CRC_BENCH_LOOP; i++)
+        calc_frm_crc(frame, crc);
+    time_crc = mpp_time() - start;
+
+    start = mpp_time();
+    for (i = 0; i < CRC_BENCH_LOOP; i++)
+        calc_frm_md5(frame, md5);
+    time_md5 = mpp_time() - start;
+
+    mpp_frame_deinit(&frame);
+
+    mpp_log("%dx%d nv12 x %d: scalar crc %.0f MB/s crc %.0f MB/s md5 %.0f MB/s\n",
+            CRC_BENCH_WIDTH, CRC_BENCH_HEIGHT, CRC_BENCH_LOOP,
+            frm_mb * CRC_BENCH_LOOP * 1000000 / time_ref,
+            frm_mb * CRC_BENCH_LOOP * 1000000 / time_crc,
+            frm_mb * CRC_BENCH_LOOP * 1000000 / time_md5);
+}
+
+int main()
+{
+    FrmCrc crc;
+    FrmCrc ref;
+    MPP_RET ret;
+
+    mpp_log("utils_crc_test start\n");
+
+    crc.luma.sum = mpp_calloc(RK_ULONG, CRC_SUM_CNT);
+    crc.chroma.sum = mpp_calloc(RK_ULONG, CRC_SUM_CNT);
+    ref.luma.sum = mpp_calloc(RK_ULONG, CRC_SUM_CNT);
+    ref.chroma.sum = mpp_calloc(RK_ULONG, CRC_SUM_CNT);
+
+    ret = test_md5();
+    if (!ret)
+        ret = test_crc(&crc, &ref);
+    if (!ret)
+        ret = test_layout(&crc);
+    if (!ret)
+        test_bench(&crc, &ref);
+
+    MPP_FREE(crc.luma.sum);
+    MPP_FREE(crc.chroma.sum);
+    MPP_FREE(ref.luma.sum);
+    MPP_FREE(ref.chroma.sum);
+
+    mpp_log("utils_crc_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -18,6 +18,7 @@
 
 #include <string.h>
 #include <pthread.h>
+#include <sys/mman.h>
 
 #include "rk_mpi.h"
 
@@ -69,6 +70,14 @@ typedef struct FileReader_t {
     RK_U32          slot_cnt;
     RK_U32          slot_rd_idx;
     FileBufSlot     **slots;
+
+    /*
+     * mmap mode: the whole file is mapped and all slots are built once on
+     * init with data pointing into the mapping, no copy and no read thread.
+     */
+    RK_U8           *map_base;
+    size_t          map_size;
+    FileBufSlot     *map_slots;
 } FileReaderImpl;
 
 typedef struct DecBufMgrImpl_t {
@@ -197,6 +206,126 @@ static FileBufSlot *read_normal_file(FileReader data)
     return slot;
 }
 
+static RK_U32 map_add_slot(FileReaderImpl *impl, size_t offset, size_t size, RK_U32 eos)
+{
+    FileBufSlot *slot = &impl->map_slots[impl->slot_cnt];
+
+    slot->index = impl->slot_cnt;
+    slot->buf   = NULL;
+    slot->size  = size;
+    slot->eos   = eos;
+    slot->data  = size ? (char *)impl->map_base + offset : NULL;
+
+    impl->slots[impl->slot_cnt++] = slot;
+    impl->read_total = offset + size;
+    impl->read_size = size;
+
+    return eos;
+}
+
+/* build the slot index of the whole file with the same split as fread path */
+static MPP_RET map_build_index(FileReaderImpl *impl)
+{
+    size_t file_size = impl->file_size;
+    size_t pos = impl->seek_base;
+    RK_U32 count = 0;
+    RK_U32 eos = 0;
+
+    if (impl->file_type == FILE_IVF_TYPE) {
+        /* one pass for frame count and one pass to fill slots */
+        while (pos + IVF_FRAME_HEADER_LENGTH <= file_size) {
+            RK_U8 *hdr = impl->map_base + pos;
+            size_t data_size = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((size_t)hdr[3] << 24);
+
+            count++;
+            pos += IVF_FRAME_HEADER_LENGTH + data_size;
+            if (!data_size || pos >= file_size)
+                break;
+        }
+        /* trailing eos slot without data */
+        count++;
+    } else {
+        count = (file_size + impl->buf_size - 1) / impl->buf_size;
+        count = MPP_MAX(count, 1);
+    }
+
+    impl->map_slots = mpp_calloc(FileBufSlot, count);
+    impl->slots = mpp_calloc(FileBufSlot*, count + 1);
+    if (!impl->map_slots || !impl->slots) {
+        MPP_FREE(impl->map_slots);
+        MPP_FREE(impl->slots);
+        return MPP_NOK;
+    }
+    impl->slot_max = count + 1;
+    impl->slot_cnt = 0;
+
+    pos = impl->seek_base;
+    if (impl->file_type == FILE_IVF_TYPE) {
+        while (!eos && pos + IVF_FRAME_HEADER_LENGTH <= file_size) {
+            RK_U8 *hdr = impl->map_base + pos;
+            size_t data_size = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | ((size_t)hdr[3] << 24);
+            size_t read_size;
+
+            pos += IVF_FRAME_HEADER_LENGTH;
+            read_size = MPP_MIN(data_size, file_size - pos);
+            if (!data_size)
+                mpp_err("data_size is zero! offset %d\n", pos);
+
+            eos = !data_size || read_size != data_size || pos + read_size >= file_size;
+            map_add_slot(impl, pos, read_size, eos);
+            pos += read_size;
+        }
+        if (!eos)
+            map_add_slot(impl, pos, 0, 1);
+    } else {
+        do {
+            size_t read_size = MPP_MIN(impl->buf_size, file_size - pos);
+
+            eos = pos + read_size >= file_size;
+            map_add_slot(impl, pos, read_size, eos);
+            pos += read_size;
+        } while (!eos);
+    }
+
+    mpp_assert(impl->slot_cnt <= count);
+
+    return MPP_OK;
+}
+
+static MPP_RET reader_map_init(FileReaderImpl *impl)
+{
+    RK_U32 use_mmap = 1;
+    void *ptr;
+
+    mpp_env_get_u32("reader_mmap", &use_mmap, 1);
+
+    /* jpeg is read into hardware buffer directly */
+    if (!use_mmap || impl->file_type == FILE_JPEG_TYPE || !impl->file_size)
+        return MPP_NOK;
+
+    ptr = mmap(NULL, impl->file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+               fileno(impl->fp_input), 0);
+    if (ptr == MAP_FAILED) {
+        mpp_log_f("mmap size %ld failed fallback to read\n", impl->file_size);
+        return MPP_NOK;
+    }
+
+    /* kernel reads ahead and drops the pages behind for long file */
+    madvise(ptr, impl->file_size, MADV_SEQUENTIAL);
+
+    impl->map_base = (RK_U8 *)ptr;
+    impl->map_size = impl->file_size;
+
+    if (map_build_index(impl)) {
+        munmap(impl->map_base, impl->map_size);
+        impl->map_base = NULL;
+        impl->map_size = 0;
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
 static void check_file_type(FileReader data, char *file_in, MppCodingType type)
 {
     FileReaderImpl *impl = (FileReaderImpl*)data;
@@ -266,6 +395,10 @@ MPP_RET reader_read(FileReader reader, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    /* all slots are ready on mmap mode and there is nothing after eos */
+    if (impl->map_base && impl->slot_rd_idx >= impl->slot_cnt)
+        return MPP_NOK;
+
     do {
         slot = impl->slots[impl->slot_rd_idx];
         if (slot == NULL || (impl->slot_rd_idx > impl->slot_cnt))
@@ -295,6 +428,9 @@ MPP_RET reader_index_read(FileReader reader, RK_S32 index, FileBufSlot **buf)
         return MPP_NOK;
     }
 
+    if (impl->map_base && index >= (RK_S32)impl->slot_cnt)
+        return MPP_NOK;
+
     do {
         slot = impl->slots[index];
         if (slot == NULL)
@@ -336,7 +472,8 @@ void reader_init(FileReader* reader, char* file_in, MppCodingType type)
 
     check_file_type(impl, file_in, type);
 
-    impl->slots = mpp_calloc(FileBufSlot*, impl->slot_max);
+    if (reader_map_init(impl))
+        impl->slots = mpp_calloc(FileBufSlot*, impl->slot_max);
 
     reader_start(impl);
 
@@ -356,6 +493,13 @@ void reader_deinit(FileReader reader)
         impl->fp_input = NULL;
     }
 
+    if (impl->map_base) {
+        munmap(impl->map_base, impl->map_size);
+        impl->map_base = NULL;
+        MPP_FREE(impl->map_slots);
+        impl->slot_cnt = 0;
+    }
+
     for (i = 0; i < impl->slot_cnt; i++) {
         FileBufSlot *slot = impl->slots[i];
         if (!slot)
@@ -399,6 +543,12 @@ void reader_start(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
+    /* no read thread on mmap mode */
+    if (impl->map_base) {
+        impl->thd_stop = 1;
+        return;
+    }
+
     impl->thd_stop = 0;
     pthread_create(&impl->thd, NULL, reader_worker, impl);
 }
@@ -407,6 +557,9 @@ void reader_sync(FileReader reader)
 {
     FileReaderImpl *impl = (FileReaderImpl*)reader;
 
+    if (impl->map_base)
+        return;
+
     pthread_join(impl->thd, NULL);
     impl->thd_stop = 1;
 }
@@ -592,6 +745,15 @@ RK_S32 mpi_dec_opt_slt(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_dec_opt_md5(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+    (void)next;
+
+    cmd->slt_md5 = 1;
+    return 0;
+}
+
 RK_S32 mpi_dec_opt_bufmode(void *ctx, const char *next)
 {
     MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
@@ -634,6 +796,7 @@ static MppOptInfo dec_opts[] = {
     {"s",       "instance_nb",  "number of instances",              mpi_dec_opt_s},
     {"v",       "trace option", "q - quiet f - show fps",           mpi_dec_opt_v},
     {"slt",     "slt file",     "slt verify data file",             mpi_dec_opt_slt},
+    {"md5",     "md5 verify",   "write frame md5 to slt file instead of crc", mpi_dec_opt_md5},
     {"help",    "help",         "show help",                        mpi_dec_opt_help},
     {"bufmode", "buffer mode",  "hi - half internal (default) i -internal e - external", mpi_dec_opt_bufmode},
 };
@@ -762,7 +925,7 @@ void mpi_dec_test_cmd_options(MpiDecTestCmd* cmd)
     mpp_log("type       : %4d\n", cmd->type);
     mpp_log("max frames : %4d\n", cmd->frame_num);
     if (cmd->file_slt)
-        mpp_log("verify     : %s\n", cmd->file_slt);
+        mpp_log("verify     : %s %s\n", cmd->file_slt, cmd->slt_md5 ? "md5" : "crc");
 }
 
 MPP_RET dec_buf_mgr_init(DecBufMgr *mgr)
@@ -133,6 +133,8 @@ typedef struct MpiDecTestCmd_t {
     RK_U32          quiet;
     RK_U32          trace_fps;
     char            *file_slt;
+    /* write frame md5 to slt file instead of crc */
+    RK_U32          slt_md5;
 } MpiDecTestCmd;
 
 RK_S32  mpi_dec_test_cmd_init(MpiDecTestCmd* cmd, int argc, char **argv);
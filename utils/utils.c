@@ -270,6 +270,66 @@ void wide_bit_sum(RK_U8 *data, RK_U32 len, RK_ULONG *sum)
     return;
 }
 
+/*
+ * Sum and xor of one line in one pass. The result is the same as
+ * wide_bit_sum plus xor of the 32bit words in the line.
+ *
+ * On 64bit platform two 32bit words are loaded at once and summed on four
+ * independent accumulators so the compiler can vectorize the loop.
+ */
+static void calc_line_crc(RK_U8 *dat, RK_U32 len, RK_ULONG *sum, RK_U32 *xor)
+{
+#if CAL_BYTE == 4
+    RK_U64 *dat64 = (RK_U64 *)dat;
+    RK_U32 cnt = len / 8;
+    RK_U64 s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    RK_U64 x0 = 0, x1 = 0;
+    RK_U32 i;
+
+    for (i = 0; i + 2 <= cnt; i += 2) {
+        RK_U64 a = dat64[i];
+        RK_U64 b = dat64[i + 1];
+
+        s0 += a & 0xffffffff;
+        s1 += a >> 32;
+        s2 += b & 0xffffffff;
+        s3 += b >> 32;
+        x0 ^= a;
+        x1 ^= b;
+    }
+    if (i < cnt) {
+        RK_U64 a = dat64[i];
+
+        s0 += a & 0xffffffff;
+        s1 += a >> 32;
+        x0 ^= a;
+    }
+
+    x0 ^= x1;
+    *xor ^= (RK_U32)x0 ^ (RK_U32)(x0 >> 32);
+
+    i = cnt * 8;
+    if (len - i >= 4) {
+        RK_U32 w = *(RK_U32 *)(dat + i);
+
+        s0 += w;
+        *xor ^= w;
+        i += 4;
+    }
+    for (; i < len; i++)
+        s0 += dat[i];
+
+    *sum += s0 + s1 + s2 + s3;
+#else
+    RK_U32 *dat32 = (RK_U32 *)dat;
+    RK_U32 i;
+
+    wide_bit_sum(dat, len, sum);
+    for (i = 0; i < len / 4; i++)
+        *xor ^= dat32[i];
+#endif
+}
+
 void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
 {
     RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
@@ -278,19 +338,25 @@ void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
     RK_U32 *dat32 = NULL;
     RK_U32 xor = 0;
 
-    /*calc sum */
     crc->sum_cnt = (len + data_grp_byte_cnt - 1) / data_grp_byte_cnt;
-    for (grp_loop = 0; grp_loop < len / data_grp_byte_cnt; grp_loop++) {
-        wide_bit_sum(&dat[grp_loop * data_grp_byte_cnt], data_grp_byte_cnt, &crc->sum[grp_loop]);
-    }
-    if (len % data_grp_byte_cnt) {
-        wide_bit_sum(&dat[grp_loop * data_grp_byte_cnt], len % data_grp_byte_cnt, &crc->sum[grp_loop]);
-    }
 
-    /*calc xor */
-    dat32 = (RK_U32 *)dat;
-    for (i = 0; i < len / 4; i++)
-        xor ^= dat32[i];
+    if (crc->sum_cnt <= 1) {
+        /* calc sum and xor of 32bit words in one pass */
+        calc_line_crc(dat, len, &crc->sum[0], &xor);
+    } else {
+        /*calc sum */
+        for (grp_loop = 0; grp_loop < len / data_grp_byte_cnt; grp_loop++) {
+            wide_bit_sum(&dat[grp_loop * data_grp_byte_cnt], data_grp_byte_cnt, &crc->sum[grp_loop]);
+        }
+        if (len % data_grp_byte_cnt) {
+            wide_bit_sum(&dat[grp_loop * data_grp_byte_cnt], len % data_grp_byte_cnt, &crc->sum[grp_loop]);
+        }
+
+        /*calc xor */
+        dat32 = (RK_U32 *)dat;
+        for (i = 0; i < len / 4; i++)
+            xor ^= dat32[i];
+    }
 
     if (len % 4) {
         RK_U32 val = 0;
@@ -334,68 +400,127 @@ void read_data_crc(FILE *fp, DataCrc *crc)
     }
 }
 
-void calc_frm_crc(MppFrame frame, FrmCrc *crc)
+/*
+ * Visible area of the two planes of a semi-planar frame.
+ *
+ * line_size is in byte so the 10bit compact formats are covered by the same
+ * kernel. Formats not listed here keep the original 8bit 420 layout.
+ */
+typedef struct FrmCrcLayout_t {
+    RK_U8       *luma;
+    RK_U8       *chroma;
+    RK_U32      stride;
+    RK_U32      luma_size;
+    RK_U32      chroma_size;
+    RK_U32      luma_line_size;
+    RK_U32      luma_lines;
+    RK_U32      chroma_line_size;
+    RK_U32      chroma_lines;
+} FrmCrcLayout;
+
+static void get_frm_crc_layout(MppFrame frame, FrmCrcLayout *layout, RK_U32 compat)
 {
-    RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
-    RK_U32 grp_line_cnt = 0;
-    RK_U32 grp_cnt = 0;
-
-    RK_U32 y = 0, x = 0;
-    RK_U8 *dat8 = NULL;
-    RK_U32 *dat32 = NULL;
-    RK_U32 xor = 0;
-
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
     RK_U32 width  = mpp_frame_get_width(frame);
     RK_U32 height = mpp_frame_get_height(frame);
     RK_U32 stride = mpp_frame_get_hor_stride(frame);
+    RK_U32 ver_stride = mpp_frame_get_ver_stride(frame);
     RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U32 line_size = width;
 
-    grp_line_cnt = data_grp_byte_cnt / ((width + CAL_BYTE - 1) / CAL_BYTE * CAL_BYTE);
+    /* fbc frame is checked as raw data of 8bit 420 layout */
+    if (MPP_FRAME_FMT_IS_FBC(fmt))
+        fmt = MPP_FMT_YUV420SP;
 
-    /* luma */
-    grp_cnt = (height + grp_line_cnt - 1) / grp_line_cnt;
-    crc->luma.sum_cnt = grp_cnt;
+    if (MPP_FRAME_FMT_IS_YUV_10BIT(fmt) ||
+        (fmt & MPP_FRAME_FMT_MASK) == MPP_FMT_YUV444SP_10BIT)
+        line_size = (width * 10 + 7) / 8;
 
-    dat8 = buf;
-    for (y = 0; y <  height / grp_line_cnt * grp_line_cnt; y++) {
-        wide_bit_sum(&dat8[y * stride], width, &crc->luma.sum[y / grp_line_cnt]);
-    }
-    if (height % grp_line_cnt) {
-        for (y = height / grp_line_cnt * grp_line_cnt; y < height; y++) {
-            wide_bit_sum(&dat8[y * stride], width, &crc->luma.sum[y / grp_line_cnt]);
+    if (ver_stride < height)
+        ver_stride = height;
+
+    layout->luma = buf;
+    layout->chroma = buf + stride * ver_stride;
+    layout->stride = stride;
+    layout->luma_line_size = line_size;
+    layout->luma_lines = height;
+    layout->chroma_line_size = line_size;
+    layout->chroma_lines = height;
+
+    switch (fmt & MPP_FRAME_FMT_MASK) {
+    case MPP_FMT_YUV420SP_10BIT : {
+        layout->chroma_lines = height / 2;
+    } break;
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV422SP_VU :
+    case MPP_FMT_YUV422SP_10BIT : {
+    } break;
+    case MPP_FMT_YUV440SP : {
+        layout->chroma_line_size = line_size * 2;
+        layout->chroma_lines = height / 2;
+    } break;
+    case MPP_FMT_YUV411SP : {
+        layout->chroma_line_size = line_size / 2;
+    } break;
+    case MPP_FMT_YUV444SP :
+    case MPP_FMT_YUV444SP_10BIT : {
+        layout->chroma_line_size = line_size * 2;
+    } break;
+    case MPP_FMT_YUV400 : {
+        layout->chroma_line_size = 0;
+        layout->chroma_lines = 0;
+    } break;
+    default : {
+        layout->chroma_lines = height / 2;
+        if (compat) {
+            /* keep the chroma offset and size of the slt files generated before */
+            layout->chroma = buf + stride * height;
+            layout->luma_size = width * height;
+            layout->chroma_size = width * height / 2;
+            return;
         }
+    } break;
     }
 
-    dat8 = buf;
-    for (y = 0; y < height; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
-    crc->luma.len = height * width;
-    crc->luma.vor = xor;
+    layout->luma_size = layout->luma_line_size * layout->luma_lines;
+    layout->chroma_size = layout->chroma_line_size * layout->chroma_lines;
+}
 
-    /* chroma */
-    grp_cnt = (height / 2 + grp_line_cnt - 1) / grp_line_cnt;
-    crc->chroma.sum_cnt = grp_cnt;
+static void calc_plane_crc(RK_U8 *dat, RK_U32 line_size, RK_U32 lines,
+                           RK_U32 stride, DataCrc *crc, RK_U32 *xor)
+{
+    RK_ULONG data_grp_byte_cnt = MAX_HALF_WORD_SUM_CNT * CAL_BYTE;
+    RK_U32 grp_line_cnt;
+    RK_U32 y;
 
-    dat8 = buf + height * stride;
-    for (y = 0; y <  height / 2 / grp_line_cnt * grp_line_cnt; y++) {
-        wide_bit_sum(&dat8[y * stride], width, &crc->chroma.sum[y / grp_line_cnt]);
-    }
-    if (height / 2 % grp_line_cnt) {
-        for (y = height / 2 / grp_line_cnt * grp_line_cnt; y < height / 2; y++) {
-            wide_bit_sum(&dat8[y * stride], width, &crc->chroma.sum[y / grp_line_cnt]);
-        }
-    }
+    crc->sum_cnt = 0;
+    if (!line_size || !lines)
+        return;
 
-    dat8 = buf + height * stride;
-    for (y = 0; y < height / 2; y++) {
-        dat32 = (RK_U32 *)&dat8[y * stride];
-        for (x = 0; x < width / 4; x++)
-            xor ^= dat32[x];
-    }
-    crc->chroma.len = height * width / 2;
+    grp_line_cnt = data_grp_byte_cnt / ((line_size + CAL_BYTE - 1) / CAL_BYTE * CAL_BYTE);
+    crc->sum_cnt = (lines + grp_line_cnt - 1) / grp_line_cnt;
+
+    for (y = 0; y < lines; y++, dat += stride)
+        calc_line_crc(dat, line_size, &crc->sum[y / grp_line_cnt], xor);
+}
+
+void calc_frm_crc(MppFrame frame, FrmCrc *crc)
+{
+    FrmCrcLayout layout;
+    RK_U32 xor = 0;
+
+    get_frm_crc_layout(frame, &layout, 1);
+
+    /* luma */
+    calc_plane_crc(layout.luma, layout.luma_line_size, layout.luma_lines,
+                   layout.stride, &crc->luma, &xor);
+    crc->luma.len = layout.luma_size;
+    crc->luma.vor = xor;
+
+    /* chroma, xor continues from luma */
+    calc_plane_crc(layout.chroma, layout.chroma_line_size, layout.chroma_lines,
+                   layout.stride, &crc->chroma, &xor);
+    crc->chroma.len = layout.chroma_size;
     crc->chroma.vor = xor;
 }
 
@@ -446,6 +571,167 @@ void read_frm_crc(FILE *fp, FrmCrc *crc)
     }
 }
 
+/*
+ * MD5 (RFC 1321) for checking against the md5 output of reference decoders
+ */
+typedef struct Md5Ctx_t {
+    RK_U32      state[4];
+    RK_U64      count;
+    RK_U8       buf[64];
+} Md5Ctx;
+
+static const RK_U32 md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const RK_U8 md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void md5_block(RK_U32 *state, const RK_U8 *blk)
+{
+    RK_U32 w[16];
+    RK_U32 a = state[0];
+    RK_U32 b = state[1];
+    RK_U32 c = state[2];
+    RK_U32 d = state[3];
+    RK_U32 i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = blk[i * 4] | (blk[i * 4 + 1] << 8) |
+               (blk[i * 4 + 2] << 16) | ((RK_U32)blk[i * 4 + 3] << 24);
+
+#define MD5_STEP(f, i, g) \
+    do { \
+        RK_U32 tmp = a + (f) + md5_k[i] + w[g]; \
+        a = d; \
+        d = c; \
+        c = b; \
+        b += (tmp << md5_r[i]) | (tmp >> (32 - md5_r[i])); \
+    } while (0)
+
+    for (i = 0; i < 16; i++)
+        MD5_STEP((b & c) | (~b & d), i, i);
+    for (i = 16; i < 32; i++)
+        MD5_STEP((d & b) | (~d & c), i, (5 * i + 1) & 15);
+    for (i = 32; i < 48; i++)
+        MD5_STEP(b ^ c ^ d, i, (3 * i + 5) & 15);
+    for (i = 48; i < 64; i++)
+        MD5_STEP(c ^ (b | ~d), i, (7 * i) & 15);
+
+#undef MD5_STEP
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+static void md5_init(Md5Ctx *ctx)
+{
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->count = 0;
+}
+
+static void md5_update(Md5Ctx *ctx, const RK_U8 *dat, RK_U32 len)
+{
+    RK_U32 pos = (RK_U32)(ctx->count & 63);
+
+    ctx->count += len;
+
+    if (pos) {
+        RK_U32 fill = MPP_MIN(64 - pos, len);
+
+        memcpy(ctx->buf + pos, dat, fill);
+        dat += fill;
+        len -= fill;
+        if (pos + fill < 64)
+            return;
+
+        md5_block(ctx->state, ctx->buf);
+    }
+
+    for (; len >= 64; len -= 64, dat += 64)
+        md5_block(ctx->state, dat);
+
+    if (len)
+        memcpy(ctx->buf, dat, len);
+}
+
+static void md5_final(Md5Ctx *ctx, RK_U8 *md5)
+{
+    RK_U64 bits = ctx->count * 8;
+    RK_U8 pad[72];
+    RK_U32 pad_len = 64 - (RK_U32)((ctx->count + 8) & 63);
+    RK_U32 i;
+
+    memset(pad, 0, sizeof(pad));
+    pad[0] = 0x80;
+    for (i = 0; i < 8; i++)
+        pad[pad_len + i] = (RK_U8)(bits >> (i * 8));
+
+    md5_update(ctx, pad, pad_len + 8);
+
+    for (i = 0; i < 16; i++)
+        md5[i] = (RK_U8)(ctx->state[i / 4] >> ((i % 4) * 8));
+}
+
+void calc_data_md5(RK_U8 *dat, RK_U32 len, RK_U8 *md5)
+{
+    Md5Ctx ctx;
+
+    md5_init(&ctx);
+    md5_update(&ctx, dat, len);
+    md5_final(&ctx, md5);
+}
+
+void calc_frm_md5(MppFrame frame, RK_U8 *md5)
+{
+    FrmCrcLayout layout;
+    Md5Ctx ctx;
+    RK_U8 *dat;
+    RK_U32 y;
+
+    get_frm_crc_layout(frame, &layout, 0);
+
+    md5_init(&ctx);
+
+    dat = layout.luma;
+    for (y = 0; y < layout.luma_lines; y++, dat += layout.stride)
+        md5_update(&ctx, dat, layout.luma_line_size);
+
+    dat = layout.chroma;
+    for (y = 0; y < layout.chroma_lines; y++, dat += layout.stride)
+        md5_update(&ctx, dat, layout.chroma_line_size);
+
+    md5_final(&ctx, md5);
+}
+
+void write_md5(FILE *fp, RK_U8 *md5)
+{
+    RK_U32 i;
+
+    if (fp) {
+        for (i = 0; i < 16; i++)
+            fprintf(fp, "%02x", md5[i]);
+        fprintf(fp, "\n");
+        fflush(fp);
+    }
+}
+
 static MPP_RET read_with_pixel_width(RK_U8 *buf, RK_S32 width, RK_S32 height,
                                      RK_S32 hor_stride, RK_S32 pix_w, FILE *fp)
 {
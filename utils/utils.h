@@ -65,6 +65,11 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc);
 void write_frm_crc(FILE *fp, FrmCrc *crc);
 void read_frm_crc(FILE *fp, FrmCrc *crc);
 
+/* md5 is 16 bytes, frame md5 is on the visible lines of luma and chroma */
+void calc_data_md5(RK_U8 *dat, RK_U32 len, RK_U8 *md5);
+void calc_frm_md5(MppFrame frame, RK_U8 *md5);
+void write_md5(FILE *fp, RK_U8 *md5);
+
 MPP_RET read_image(RK_U8 *buf, FILE *fp, RK_U32 width, RK_U32 height,
                    RK_U32 hor_stride, RK_U32 ver_stride,
                    MppFrameFormat fmt);